@@ -438,7 +438,7 @@ static void Sys_Android_ExecuteIntent( void ) {
 void android_main( struct android_app *app ) {
 	int ident, events;
 	struct android_poll_source *source;
-	int64_t oldtime, newtime, time;
+	unsigned int time;
 
 	app_dummy();
 
@@ -459,7 +459,6 @@ void android_main( struct android_app *app ) {
 	Sys_Android_Init();
 	Qcommon_Init( 0, NULL );
 
-	oldtime = Sys_Milliseconds();
 	for( ;; ) {
 		if( dedicated && dedicated->integer ) {
 			Sys_Sleep( 1 );
@@ -472,14 +471,12 @@ void android_main( struct android_app *app ) {
 		}
 
 		for( ;; ) {
-			newtime = Sys_Milliseconds();
-			time = newtime - oldtime;
+			time = Qcommon_FrameMsec();
 			if( time > 0 ) {
 				break;
 			}
 			Sys_Sleep( 0 );
 		}
-		oldtime = newtime;
 
 		Sys_Android_ExecuteIntent();
 		Qcommon_Frame( time );
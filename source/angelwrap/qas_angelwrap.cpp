@@ -112,6 +112,9 @@ asIScriptEngine *qasCreateEngine( bool *asMaxPortability ) {
 	engine->SetEngineProperty( asEP_ALWAYS_IMPL_DEFAULT_CONSTRUCT, 1 );
 	engine->SetDefaultAccessMask( 0xFFFFFFFF );
 
+	// compile bytecode to native code if possible, the interpreter is used otherwise
+	qasAttachJITCompiler( engine );
+
 	PreRegisterMathAddon( engine );
 	PreRegisterScriptArray( engine, true );
 	PreRegisterStringAddon( engine );
@@ -443,10 +446,20 @@ void qasReleaseEngine( asIScriptEngine *engine ) {
 		contexts.erase( it );
 	}
 
+	if( qasReleaseEngineWithJIT( engine ) ) {
+		return;
+	}
+
 	engine->Release();
 }
 
-static asIScriptContext *qasCreateContext( asIScriptEngine *engine ) {
+/*
+* qasCreateUnmanagedContext
+*
+* Creates a context with the default exception callback, which is not
+* tracked by the context pool: the caller owns it and releases it directly.
+*/
+asIScriptContext *qasCreateUnmanagedContext( asIScriptEngine *engine ) {
 	asIScriptContext *ctx;
 	int error;
 
@@ -472,6 +485,17 @@ static asIScriptContext *qasCreateContext( asIScriptEngine *engine ) {
 		return NULL;
 	}
 
+	return ctx;
+}
+
+static asIScriptContext *qasCreateContext( asIScriptEngine *engine ) {
+	asIScriptContext *ctx;
+
+	ctx = qasCreateUnmanagedContext( engine );
+	if( !ctx ) {
+		return NULL;
+	}
+
 	qasContextList &ctxList = contexts[engine];
 	ctxList.push_back( ctx );
 
@@ -566,6 +590,7 @@ static asIScriptModule *qasBuildScriptProject( asIScriptEngine *asEngine, const
 	int numSections, sectionNum;
 	char *section;
 	asIScriptModule *asModule;
+	unsigned jitCompiled, jitFailed, numCompiled, numFailed;
 
 	if( asEngine == NULL ) {
 		QAS_Printf( S_COLOR_RED "qasBuildGameScript: Angelscript API unavailable\n" );
@@ -609,6 +634,9 @@ static asIScriptModule *qasBuildScriptProject( asIScriptEngine *asEngine, const
 		return NULL;
 	}
 
+	jitCompiled = jitFailed = 0;
+	qasGetJITStats( asEngine, &jitCompiled, &jitFailed );
+
 	error = asModule->Build();
 	if( error ) {
 		QAS_Printf( S_COLOR_RED "* Failed to build script '%s'\n", scriptName );
@@ -616,6 +644,13 @@ static asIScriptModule *qasBuildScriptProject( asIScriptEngine *asEngine, const
 		return NULL;
 	}
 
+	qasFinalizeJIT( asEngine );
+
+	if( qasGetJITStats( asEngine, &numCompiled, &numFailed ) ) {
+		QAS_Printf( "* JIT compiled %u functions, %u left to the interpreter\n",
+			numCompiled - jitCompiled, numFailed - jitFailed );
+	}
+
 	return asModule;
 }
 
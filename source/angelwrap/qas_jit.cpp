@@ -0,0 +1,177 @@
+/*
+Copyright (C) 2026 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// qas_jit.cpp -- native code generation for script bytecode
+//
+// When angelwrap is built with QAS_USE_JIT (the ANGELWRAP_USE_JIT CMake option,
+// off by default), script functions are handed over to an external
+// asIJITCompiler as modules are built. Functions the JIT can't handle, and all
+// functions when as_jit is 0, run in the bytecode interpreter. Other builds
+// always use the interpreter and don't register as_jit.
+
+#include "qas_precompiled.h"
+
+#ifdef QAS_USE_JIT
+#include "as_jit.h"
+#endif
+
+#include <map>
+
+class qasJITCompiler : public asIJITCompiler
+{
+public:
+	qasJITCompiler( asIJITCompiler *backend ) : numCompiled( 0 ), numFailed( 0 ), backend( backend ) {}
+	virtual ~qasJITCompiler() { delete backend; }
+
+	virtual int CompileFunction( asIScriptFunction *function, asJITFunction *output ) {
+		int error = backend->CompileFunction( function, output );
+
+		// the interpreter takes over for whatever the backend refuses to compile
+		if( error < 0 || !*output ) {
+			numFailed++;
+			return error < 0 ? error : asERROR;
+		}
+
+		numCompiled++;
+		return error;
+	}
+
+	virtual void ReleaseJITFunction( asJITFunction func ) {
+		backend->ReleaseJITFunction( func );
+	}
+
+	// the backend keeps generated code in pages which aren't executable
+	// until they're finalized, which must happen after every module build
+	void FinalizePages( void ) {
+#ifdef QAS_USE_JIT
+		static_cast<asCJITCompiler *>( backend )->finalizePages();
+#endif
+	}
+
+	unsigned numCompiled;
+	unsigned numFailed;
+
+private:
+	asIJITCompiler *backend;
+};
+
+// engine -> JIT compiler key/value pairs
+typedef std::map<asIScriptEngine *, qasJITCompiler *> qasEngineJITMap;
+
+static qasEngineJITMap jitCompilers;
+
+#ifdef QAS_USE_JIT
+static cvar_t *as_jit;
+#endif
+
+/*
+* qasCreateJITBackend
+*
+* Returns NULL when no JIT is compiled in or when it is disabled by as_jit,
+* which only exists in builds with a JIT.
+*/
+static asIJITCompiler *qasCreateJITBackend( void ) {
+#ifdef QAS_USE_JIT
+	if( !as_jit ) {
+		as_jit = trap_Cvar_Get( "as_jit", "1", CVAR_ARCHIVE );
+	}
+	if( !as_jit->integer ) {
+		return NULL;
+	}
+	return new asCJITCompiler( 0 );
+#else
+	return NULL;
+#endif
+}
+
+/*
+* qasAttachJITCompiler
+*
+* Must be called before any module is built for the engine.
+*/
+void qasAttachJITCompiler( asIScriptEngine *engine ) {
+	asIJITCompiler *backend;
+	qasJITCompiler *jit;
+
+	backend = qasCreateJITBackend();
+	if( !backend ) {
+		return;
+	}
+
+	jit = QAS_NEW( qasJITCompiler )( backend );
+	if( engine->SetJITCompiler( jit ) < 0 ) {
+		QAS_DELETE( jit, qasJITCompiler );
+		return;
+	}
+
+	engine->SetEngineProperty( asEP_INCLUDE_JIT_INSTRUCTIONS, 1 );
+	jitCompilers[engine] = jit;
+}
+
+/*
+* qasReleaseEngineWithJIT
+*
+* Returns false if the engine has no JIT attached. Otherwise the engine is
+* shut down, which releases all compiled functions, before the JIT goes away.
+*/
+bool qasReleaseEngineWithJIT( asIScriptEngine *engine ) {
+	qasEngineJITMap::iterator it = jitCompilers.find( engine );
+	if( it == jitCompilers.end() ) {
+		return false;
+	}
+
+	qasJITCompiler *jit = it->second;
+	jitCompilers.erase( it );
+
+	engine->ShutDownAndRelease();
+	QAS_DELETE( jit, qasJITCompiler );
+	return true;
+}
+
+/*
+* qasFinalizeJIT
+*
+* Must be called after a module has been built successfully,
+* before any of its functions is executed.
+*/
+void qasFinalizeJIT( asIScriptEngine *engine ) {
+	qasEngineJITMap::iterator it = jitCompilers.find( engine );
+	if( it == jitCompilers.end() ) {
+		return;
+	}
+
+	it->second->FinalizePages();
+}
+
+/*
+* qasGetJITStats
+*
+* Returns false if script bytecode for the engine isn't compiled to native code.
+*/
+bool qasGetJITStats( asIScriptEngine *engine, unsigned *numCompiled, unsigned *numFailed ) {
+	qasEngineJITMap::iterator it = jitCompilers.find( engine );
+	if( it == jitCompilers.end() ) {
+		return false;
+	}
+
+	*numCompiled = it->second->numCompiled;
+	*numFailed = it->second->numFailed;
+	return true;
+}
@@ -85,11 +85,18 @@ __declspec( noreturn ) void QAS_Error( _Printf_format_string_ const char *format
 /******* C++ objects *******/
 asIScriptEngine *qasCreateEngine( bool *asMaxPortability );
 asIScriptContext *qasAcquireContext( asIScriptEngine *engine );
+asIScriptContext *qasCreateUnmanagedContext( asIScriptEngine *engine );
 void qasReleaseContext( asIScriptContext *ctx );
 void qasReleaseEngine( asIScriptEngine *engine );
 asIScriptContext *qasGetActiveContext( void );
 void qasWriteEngineDocsToFile( asIScriptEngine *engine, const char *path, bool singleFile, bool markdown, unsigned andMask, unsigned notMask );
 
+// JIT
+void qasAttachJITCompiler( asIScriptEngine *engine );
+bool qasReleaseEngineWithJIT( asIScriptEngine *engine );
+void qasFinalizeJIT( asIScriptEngine *engine );
+bool qasGetJITStats( asIScriptEngine *engine, unsigned *numCompiled, unsigned *numFailed );
+
 // array tools
 CScriptArrayInterface *qasCreateArrayCpp( unsigned int length, void *ot );
 void qasReleaseArrayCpp( CScriptArrayInterface *arr );
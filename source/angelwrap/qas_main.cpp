@@ -35,11 +35,13 @@ void QAS_InitAngelExport( void ) {
 
 	angelExport.asCreateEngine = qasCreateEngine;
 	angelExport.asReleaseEngine = qasReleaseEngine;
+	angelExport.asFinalizeJIT = qasFinalizeJIT;
 	angelExport.asWriteEngineDocsToFile = qasWriteEngineDocsToFile;
 
 	angelExport.asAcquireContext = qasAcquireContext;
 	angelExport.asReleaseContext = qasReleaseContext;
 	angelExport.asGetActiveContext = qasGetActiveContext;
+	angelExport.asCreateUnmanagedContext = qasCreateUnmanagedContext;
 
 	angelExport.asStringFactoryBuffer = qasStringFactoryBuffer;
 	angelExport.asStringRelease = qasStringRelease;
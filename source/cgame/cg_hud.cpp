@@ -3486,6 +3486,8 @@ typedef struct cg_layoutnode_s
 	int integer;
 	float value;
 	opFunc_t opFunc;
+	int ( *refFunc )( const void *parameter );
+	const void *refParameter;
 	struct cg_layoutnode_s *parent;
 	struct cg_layoutnode_s *next;
 	struct cg_layoutnode_s *ifthread;
@@ -3525,7 +3527,7 @@ static float CG_GetNumericArg( struct cg_layoutnode_s **argumentsnode ) {
 
 	*argumentsnode = anode->next;
 	if( anode->type == LNODE_REFERENCE_NUMERIC ) {
-		value = cg_numeric_references[anode->integer].func( cg_numeric_references[anode->integer].parameter );
+		value = anode->refFunc( anode->refParameter );
 	} else {
 		value = anode->value;
 	}
@@ -3677,6 +3679,11 @@ static cg_layoutnode_t *CG_LayoutParseArgumentNode( const char *token ) {
 	node->ifthread = NULL;
 	node->precache = false;
 
+	if( type == LNODE_REFERENCE_NUMERIC ) {
+		node->refFunc = cg_numeric_references[node->integer].func;
+		node->refParameter = cg_numeric_references[node->integer].parameter;
+	}
+
 	// return it
 	return node;
 }
@@ -3987,16 +3994,223 @@ static void CG_RecursePrintLayoutThread( cg_layoutnode_t *rootnode, int level )
 }
 #endif
 
+//=============================================================================
+
+/*
+* Compiled layout programs
+*
+* The parsed thread is flattened once at load time into an array of instructions.
+* "if" sub-threads are laid out right after their command and skipped with a jump
+* when the command returns false, argument counts are checked once and runs of
+* constant operands are folded into a single argument node.
+*/
+typedef struct cg_layoutinstr_s
+{
+	cg_layoutnode_t *command;
+	cg_layoutnode_t *arguments;
+	int numArguments;
+	int jump;                       // instruction to continue from when the command returns false
+} cg_layoutinstr_t;
+
+typedef struct cg_layoutprogram_s
+{
+	cg_layoutnode_t *thread;        // the parsed script, owns the command nodes and strings
+
+	int numInstructions;
+	cg_layoutinstr_t *instructions;
+
+	int numArguments;
+	cg_layoutnode_t *arguments;
+} cg_layoutprogram_t;
+
+/*
+* CG_FoldLayoutArguments
+* folds trailing constant operands of each operator chain, returns the new argument count
+*/
+static int CG_FoldLayoutArguments( cg_layoutnode_t *args, int numArguments ) {
+	int i, j, first, last;
+	float value;
+
+	for( i = 0; i < numArguments; i++ ) {
+		if( !args[i].opFunc ) {
+			continue;
+		}
+
+		// the chain runs up to the first node without an operator
+		for( last = i; last < numArguments && args[last].opFunc; last++ ) ;
+		if( last == numArguments ) {
+			break; // dangling operator, leave it for the interpreter to report
+		}
+
+		for( first = last; first > i && args[first - 1].type == LNODE_NUMERIC; first-- ) ;
+		if( args[last].type != LNODE_NUMERIC || first == last ) {
+			i = last;
+			continue;
+		}
+
+		// operators are right-associative
+		value = args[last].value;
+		for( j = last - 1; j >= first; j-- ) {
+			value = args[j].opFunc( args[j].value, value );
+		}
+
+		args[first].value = value;
+		args[first].integer = (int)value;
+		args[first].opFunc = NULL;
+
+		memmove( &args[first + 1], &args[last + 1], ( numArguments - last - 1 ) * sizeof( *args ) );
+		numArguments -= last - first;
+		i = first;
+	}
+
+	return numArguments;
+}
+
+/*
+* CG_CompileLayoutArguments
+*/
+static cg_layoutnode_t *CG_CompileLayoutArguments( cg_layoutprogram_t *program, cg_layoutnode_t *argumentnode, int *numArguments ) {
+	int i, count;
+	cg_layoutnode_t *args;
+
+	if( !*numArguments ) {
+		return NULL;
+	}
+
+	args = program->arguments + program->numArguments;
+	for( i = 0; i < *numArguments; i++, argumentnode = argumentnode->next ) {
+		args[i] = *argumentnode;
+		args[i].parent = NULL;
+		args[i].ifthread = NULL;
+	}
+
+	count = CG_FoldLayoutArguments( args, *numArguments );
+	for( i = 0; i < count; i++ ) {
+		args[i].next = i + 1 < count ? &args[i + 1] : NULL;
+	}
+
+	program->numArguments += count;
+	*numArguments = count;
+	return args;
+}
+
+/*
+* CG_CompileLayoutThread
+* walks the thread the same way the tree interpreter did. Without the instructions
+* array only the instructions and arguments are counted.
+*/
+static void CG_CompileLayoutThread( cg_layoutprogram_t *program, cg_layoutnode_t *rootnode ) {
+	cg_layoutnode_t *commandnode, *argumentnode;
+	cg_layoutinstr_t *instr;
+	int numArguments, index;
+
+	if( !rootnode ) {
+		return;
+	}
+
+	commandnode = rootnode;
+	while( commandnode->parent ) {
+		commandnode = commandnode->parent;
+	}
+
+	while( commandnode ) {
+		numArguments = 0;
+		for( argumentnode = commandnode->next; argumentnode && argumentnode->type != LNODE_COMMAND; argumentnode = argumentnode->next )
+			numArguments++;
+
+		// the rest of the thread would never run
+		if( commandnode->integer != numArguments ) {
+			if( program->instructions ) {
+				CG_Printf( "ERROR: Layout command %s: invalid argument count (expecting %i, found %i)\n", commandnode->string, commandnode->integer, numArguments );
+			}
+			return;
+		}
+
+		index = program->numInstructions++;
+		if( program->instructions ) {
+			instr = &program->instructions[index];
+			instr->command = commandnode;
+			instr->numArguments = numArguments;
+			instr->arguments = CG_CompileLayoutArguments( program, commandnode->next, &instr->numArguments );
+		} else {
+			program->numArguments += numArguments;
+		}
+
+		if( commandnode->ifthread ) {
+			CG_CompileLayoutThread( program, commandnode->ifthread );
+		}
+
+		if( program->instructions ) {
+			program->instructions[index].jump = program->numInstructions;
+		}
+
+		commandnode = commandnode->next;
+		if( commandnode == rootnode ) {
+			return;
+		}
+
+		while( commandnode && commandnode->type != LNODE_COMMAND ) {
+			commandnode = commandnode->next;
+		}
+	}
+}
+
+/*
+* CG_CompileLayoutProgram
+*/
+static cg_layoutprogram_t *CG_CompileLayoutProgram( cg_layoutnode_t *thread ) {
+	cg_layoutprogram_t counts, *program;
+	uint8_t *buffer;
+
+	memset( &counts, 0, sizeof( counts ) );
+	CG_CompileLayoutThread( &counts, thread );
+
+	buffer = ( uint8_t * )CG_Malloc( sizeof( cg_layoutprogram_t ) +
+									 counts.numInstructions * sizeof( cg_layoutinstr_t ) + counts.numArguments * sizeof( cg_layoutnode_t ) );
+
+	program = ( cg_layoutprogram_t * )buffer;
+	program->thread = thread;
+	program->instructions = ( cg_layoutinstr_t * )( buffer + sizeof( cg_layoutprogram_t ) );
+	program->arguments = ( cg_layoutnode_t * )( ( uint8_t * )program->instructions + counts.numInstructions * sizeof( cg_layoutinstr_t ) );
+
+	CG_CompileLayoutThread( program, thread );
+
+	if( cg_debugHUD && cg_debugHUD->integer ) {
+		CG_Printf( "HUD: compiled %i instructions, %i arguments (%i folded)\n",
+				   program->numInstructions, program->numArguments, counts.numArguments - program->numArguments );
+	}
+
+	return program;
+}
+
+/*
+* CG_FreeLayoutProgram
+*/
+static void CG_FreeLayoutProgram( cg_layoutprogram_t *program ) {
+	if( !program ) {
+		return;
+	}
+
+	CG_RecurseFreeLayoutThread( program->thread );
+	CG_Free( program );
+}
+
 /*
 * CG_ParseLayoutScript
 */
-static void CG_ParseLayoutScript( char *string, cg_layoutnode_t *rootnode ) {
+static void CG_ParseLayoutScript( char *string ) {
+	cg_layoutnode_t *thread;
 
-	CG_RecurseFreeLayoutThread( cg.statusBar );
-	cg.statusBar = CG_RecurseParseLayoutScript( &string, 0 );
+	CG_FreeLayoutProgram( cg.statusBar );
+	cg.statusBar = NULL;
+
+	thread = CG_RecurseParseLayoutScript( &string, 0 );
+	if( thread ) {
+		cg.statusBar = CG_CompileLayoutProgram( thread );
+	}
 
 #if 0
-	CG_RecursePrintLayoutThread( cg_layoutRootNode, 0 );
+	CG_RecursePrintLayoutThread( thread, 0 );
 #endif
 }
 
@@ -4004,6 +4218,31 @@ static void CG_ParseLayoutScript( char *string, cg_layoutnode_t *rootnode ) {
 
 //=============================================================================
 
+/*
+* CG_RunLayoutProgram
+*/
+static void CG_RunLayoutProgram( const cg_layoutprogram_t *program, bool touch ) {
+	const cg_layoutinstr_t *instr;
+	cg_layoutnode_t *command;
+	bool ( *func )( struct cg_layoutnode_s *commandnode, struct cg_layoutnode_s *argumentnode, int numArguments );
+	int i;
+
+	for( i = 0; i < program->numInstructions; ) {
+		instr = &program->instructions[i];
+		command = instr->command;
+		func = touch ? command->touchfunc : command->func;
+
+		// the "if" thread follows its command, skip over it when the command fails
+		if( func && func( command, instr->arguments, instr->numArguments ) ) {
+			i++;
+		} else {
+			i = instr->jump;
+		}
+	}
+}
+
+#ifndef PUBLIC_BUILD
+
 /*
 * CG_RecurseExecuteLayoutThread
 * Execution works like this: First node (on backwards) is expected to be the command, followed by arguments nodes.
@@ -4013,6 +4252,8 @@ static void CG_ParseLayoutScript( char *string, cg_layoutnode_t *rootnode ) {
 *
 * When finding an "if" command with a subtree, we execute the "if" command. In the case it
 * returns any value, we recurse execute the subtree
+*
+* Only kept as the reference for hudbench.
 */
 static void CG_RecurseExecuteLayoutThread( cg_layoutnode_t *rootnode, bool touch ) {
 	cg_layoutnode_t *argumentnode = NULL;
@@ -4082,11 +4323,82 @@ static void CG_RecurseExecuteLayoutThread( cg_layoutnode_t *rootnode, bool touch
 	}
 }
 
+static int cg_hudbench_frames;
+static int cg_hudbench_mode;
+static int cg_hudbench_runs[2];
+static uint64_t cg_hudbench_time[2];
+
+/*
+* CG_BenchLayoutProgram
+* alternates frames between the tree interpreter and the compiled program
+*/
+static void CG_BenchLayoutProgram( const cg_layoutprogram_t *program, bool touch ) {
+	uint64_t start;
+
+	if( !touch ) {
+		cg_hudbench_mode ^= 1;
+		cg_hudbench_runs[cg_hudbench_mode]++;
+		cg_hudbench_frames--;
+	}
+
+	start = trap_Microseconds();
+	if( cg_hudbench_mode ) {
+		CG_RunLayoutProgram( program, touch );
+	} else {
+		CG_RecurseExecuteLayoutThread( program->thread, touch );
+	}
+	cg_hudbench_time[cg_hudbench_mode] += trap_Microseconds() - start;
+
+	if( !touch && !cg_hudbench_frames ) {
+		CG_Printf( "HUD: tree %.2f usec/frame, compiled %.2f usec/frame (%i instructions, %i frames each)\n",
+				   (double)cg_hudbench_time[0] / cg_hudbench_runs[0],
+				   (double)cg_hudbench_time[1] / cg_hudbench_runs[1],
+				   program->numInstructions, cg_hudbench_runs[1] );
+	}
+}
+
+/*
+* CG_HUDBench_f
+*/
+void CG_HUDBench_f( void ) {
+	int frames;
+
+	frames = trap_Cmd_Argc() > 1 ? atoi( trap_Cmd_Argv( 1 ) ) : 0;
+	if( frames <= 0 ) {
+		frames = 1000;
+	}
+
+	if( !cg.statusBar ) {
+		CG_Printf( "No HUD loaded\n" );
+		return;
+	}
+
+	cg_hudbench_mode = 0;
+	cg_hudbench_runs[0] = cg_hudbench_runs[1] = 0;
+	cg_hudbench_time[0] = cg_hudbench_time[1] = 0;
+	cg_hudbench_frames = frames * 2;
+
+	CG_Printf( "HUD: benchmarking over %i frames\n", frames * 2 );
+}
+
+#endif // PUBLIC_BUILD
+
 /*
 * CG_ExecuteLayoutProgram
 */
-void CG_ExecuteLayoutProgram( struct cg_layoutnode_s *rootnode, bool touch ) {
-	CG_RecurseExecuteLayoutThread( rootnode, touch );
+void CG_ExecuteLayoutProgram( struct cg_layoutprogram_s *program, bool touch ) {
+	if( !program ) {
+		return;
+	}
+
+#ifndef PUBLIC_BUILD
+	if( cg_hudbench_frames ) {
+		CG_BenchLayoutProgram( program, touch );
+		return;
+	}
+#endif
+
+	CG_RunLayoutProgram( program, touch );
 }
 
 //=============================================================================
@@ -4460,7 +4772,7 @@ static void CG_LoadStatusBarFile( char *path ) {
 	CG_ClearHUDInputState();
 
 	// load the new status bar program
-	CG_ParseLayoutScript( opt, cg.statusBar );
+	CG_ParseLayoutScript( opt );
 
 	// Free the opt buffer!
 	CG_Free( opt );
@@ -638,7 +638,7 @@ typedef struct {
 	int award_head;
 
 	// statusbar program
-	struct cg_layoutnode_s *statusBar;
+	struct cg_layoutprogram_s *statusBar;
 
 	cg_viewweapon_t weapon;
 	cg_viewdef_t view;
@@ -775,6 +775,7 @@ extern cvar_t *cg_showAwards;
 extern cvar_t *cg_showZoomEffect;
 extern cvar_t *cg_showCaptureAreas;
 extern cvar_t *cg_showChasers;
+extern cvar_t *con_messageMode;
 
 void CG_ScreenInit( void );
 void CG_ScreenShutdown( void );
@@ -837,7 +838,10 @@ extern cvar_t *cg_touch_zoomTime;
 void CG_SC_ResetObituaries( void );
 void CG_SC_Obituary( void );
 void Cmd_CG_PrintHudHelp_f( void );
-void CG_ExecuteLayoutProgram( struct cg_layoutnode_s *rootnode, bool touch );
+void CG_ExecuteLayoutProgram( struct cg_layoutprogram_s *program, bool touch );
+#ifndef PUBLIC_BUILD
+void CG_HUDBench_f( void );
+#endif
 void CG_GetHUDTouchButtons( int *buttons, int *upmove );
 void CG_UpdateHUDPostDraw( void );
 void CG_UpdateHUDPostTouch( void );
@@ -43,7 +43,7 @@ typedef void ( *cg_fdrawchar_t )( int x, int y, int w, int h, float s1, float t1
 
 // cg_public.h -- client game dll information visible to engine
 
-#define CGAME_API_VERSION   104
+#define CGAME_API_VERSION   106
 
 //
 // structs and variables shared with the main engine
@@ -138,8 +138,15 @@ typedef struct {
 
 	void ( *GetConfigString )( int i, char *str, int size );
 	int64_t ( *Milliseconds )( void );
+	uint64_t ( *Microseconds )( void );
 	bool ( *DownloadRequest )( const char *filename, bool requestpak );
 
+	// job system
+	int ( *Jobs_NumThreads )( void );
+	void ( *Jobs_Add )( qjobcounter_t *counter, qjobcounter_t *dependency, qjobfunc_t func, void *arg );
+	void ( *Jobs_ParallelFor )( qjobcounter_t *counter, unsigned items, unsigned grain, qjobrangefunc_t func, void *arg );
+	void ( *Jobs_Wait )( qjobcounter_t *counter );
+
 	void ( *NET_GetUserCmd )( int frame, usercmd_t *cmd );
 	int ( *NET_GetCurrentUserCmdNum )( void );
 	void ( *NET_GetCurrentState )( int64_t *incomingAcknowledged, int64_t *outgoingSequence, int64_t *outgoingSent );
@@ -45,6 +45,8 @@ cvar_t *cg_showHUD;
 cvar_t *cg_draw2D;
 cvar_t *cg_weaponlist;
 
+cvar_t *con_messageMode;
+
 cvar_t *cg_crosshair;
 cvar_t *cg_crosshair_size;
 cvar_t *cg_crosshair_color;
@@ -245,6 +247,9 @@ void CG_ScreenInit( void ) {
 	cg_centerTime =     trap_Cvar_Get( "cg_centerTime", "2.5", 0 );
 	cg_weaponlist =     trap_Cvar_Get( "cg_weaponlist", "1", CVAR_ARCHIVE );
 
+	// set by the client console when typing a chat message
+	con_messageMode =   trap_Cvar_Get( "con_messageMode", "0", 0 );
+
 	cg_crosshair =      trap_Cvar_Get( "cg_crosshair", "1", CVAR_ARCHIVE );
 	cg_crosshair_size = trap_Cvar_Get( "cg_crosshair_size", "24", CVAR_ARCHIVE );
 	cg_crosshair_color =    trap_Cvar_Get( "cg_crosshair_color", "255 255 255", CVAR_ARCHIVE );
@@ -296,6 +301,9 @@ void CG_ScreenInit( void ) {
 	trap_Cmd_AddCommand( "sizeup", CG_SizeUp_f );
 	trap_Cmd_AddCommand( "sizedown", CG_SizeDown_f );
 	trap_Cmd_AddCommand( "help_hud", Cmd_CG_PrintHudHelp_f );
+#ifndef PUBLIC_BUILD
+	trap_Cmd_AddCommand( "hudbench", CG_HUDBench_f );
+#endif
 	trap_Cmd_AddCommand( "gamemenu", CG_GameMenu_f );
 
 	for( i = 0; i < TOUCHPAD_COUNT; ++i )
@@ -310,6 +318,9 @@ void CG_ScreenShutdown( void ) {
 	trap_Cmd_RemoveCommand( "sizeup" );
 	trap_Cmd_RemoveCommand( "sizedown" );
 	trap_Cmd_RemoveCommand( "help_hud" );
+#ifndef PUBLIC_BUILD
+	trap_Cmd_RemoveCommand( "hudbench" );
+#endif
 }
 
 
@@ -1419,7 +1430,7 @@ void CG_Draw2DView( void ) {
 	CG_CheckDamageCrosshair();
 
 	scr_centertime_off -= cg.frameTime;
-	if( !( ( trap_IN_SupportedDevices() & IN_DEVICE_SOFTKEYBOARD ) && ( int )trap_Cvar_Value( "con_messageMode" ) ) ) {
+	if( !( ( trap_IN_SupportedDevices() & IN_DEVICE_SOFTKEYBOARD ) && con_messageMode->integer ) ) {
 		if( CG_IsScoreboardShown() ) {
 			CG_DrawScoreboard();
 		} else if( scr_centertime_off > 0 ) {
@@ -171,6 +171,26 @@ static inline int64_t trap_Milliseconds( void ) {
 	return CGAME_IMPORT.Milliseconds();
 }
 
+static inline uint64_t trap_Microseconds( void ) {
+	return CGAME_IMPORT.Microseconds();
+}
+
+static inline int trap_Jobs_NumThreads( void ) {
+	return CGAME_IMPORT.Jobs_NumThreads();
+}
+
+static inline void trap_Jobs_Add( qjobcounter_t *counter, qjobcounter_t *dependency, qjobfunc_t func, void *arg ) {
+	CGAME_IMPORT.Jobs_Add( counter, dependency, func, arg );
+}
+
+static inline void trap_Jobs_ParallelFor( qjobcounter_t *counter, unsigned items, unsigned grain, qjobrangefunc_t func, void *arg ) {
+	CGAME_IMPORT.Jobs_ParallelFor( counter, items, grain, func, arg );
+}
+
+static inline void trap_Jobs_Wait( qjobcounter_t *counter ) {
+	CGAME_IMPORT.Jobs_Wait( counter );
+}
+
 static inline bool trap_DownloadRequest( const char *filename, bool requestpak ) {
 	return CGAME_IMPORT.DownloadRequest( filename, requestpak == true ? true : false ) == true;
 }
@@ -414,8 +414,14 @@ void CL_GameModule_Init( void ) {
 
 	import.GetConfigString = CL_GameModule_GetConfigString;
 	import.Milliseconds = Sys_Milliseconds;
+	import.Microseconds = Sys_Microseconds;
 	import.DownloadRequest = CL_DownloadRequest;
 
+	import.Jobs_NumThreads = QJobs_NumThreads;
+	import.Jobs_Add = QJobs_Add;
+	import.Jobs_ParallelFor = QJobs_ParallelFor;
+	import.Jobs_Wait = QJobs_Wait;
+
 	import.NET_GetUserCmd = CL_GameModule_NET_GetUserCmd;
 	import.NET_GetCurrentUserCmdNum = CL_GameModule_NET_GetCurrentUserCmdNum;
 	import.NET_GetCurrentState = CL_GameModule_NET_GetCurrentState;
@@ -610,6 +610,8 @@ void CL_ClearState( void ) {
 	if( cl.cms ) {
 		CM_ReleaseReference( cl.cms );
 		cl.cms = NULL;
+
+		CM_PurgeSharedMaps();
 	}
 
 	if( cl.frames_areabits ) {
@@ -1304,8 +1306,7 @@ static unsigned int CL_LoadMap( const char *name ) {
 	if( Com_ServerState() ) {
 		cl.cms = Com_ServerCM( &map_checksum );
 	} else {
-		cl.cms = CM_New( NULL );
-		CM_LoadMap( cl.cms, name, true, &map_checksum );
+		cl.cms = CM_AcquireSharedMap( name, true, &map_checksum );
 	}
 
 	CM_AddReference( cl.cms );
@@ -2329,7 +2330,7 @@ void CL_Frame( int realMsec, int gameMsec ) {
 
 		// fixed time for next frame
 		if( cls.demo.avi_video ) {
-			gameMsec = ( 1000.0 / (double)cl_demoavi_fps->integer ) * Cvar_Value( "timescale" );
+			gameMsec = ( 1000.0 / (double)cl_demoavi_fps->integer ) * timescale->value;
 			if( gameMsec < 1 ) {
 				gameMsec = 1;
 			}
@@ -2427,6 +2428,9 @@ void CL_Frame( int realMsec, int gameMsec ) {
 	// allow rendering DLL change
 	VID_CheckChanges();
 
+	// rasterize the glyphs deferred during the previous frames
+	FTLIB_Frame();
+
 	// update the screen
 	if( host_speeds->integer ) {
 		time_before_ref = Sys_Milliseconds();
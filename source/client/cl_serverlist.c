@@ -33,17 +33,49 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 //=========================================================
 
+#define SERVERLIST_HASH_SIZE                1024
+#define SERVER_QUERY_TIMEOUT                1000    // msecs until an unanswered ping frees its slot
+
+typedef enum {
+	PING_IDLE,
+	PING_WAITING,                           // queued, not sent yet
+	PING_SENT
+} pingstate_t;
+
 typedef struct serverlist_s {
 	char address[48];
-	int64_t pingTimeStamp;
+	netadr_t adr;
+	unsigned int hashKey;
+	pingstate_t pingState;
+	uint64_t pingTimeStamp;                 // microseconds, 0 if no reply is expected
 	int64_t lastValidPing;
 	int64_t lastUpdatedByMasterServer;
 	int64_t masterServerUpdateSeq;
 	bool isLocal;
 	struct serverlist_s *pnext;
+	struct serverlist_s *hnext;
+	struct serverlist_s *qprev, *qnext;     // ping queue links
 } serverlist_t;
 
-serverlist_t *masterList, *favoritesList;
+typedef struct {
+	serverlist_t *first;
+	serverlist_t *hash[SERVERLIST_HASH_SIZE];
+} serverlisthead_t;
+
+typedef struct {
+	serverlist_t *head, *tail;
+	int count;
+} pingqueue_t;
+
+static serverlisthead_t masterList, favoritesList;
+
+// servers waiting to be pinged and the ones we're awaiting a reply from, both in FIFO order
+static pingqueue_t pingWaiting, pingSent;
+static double pingAllowance;
+static int64_t pingLastFrameTime;
+
+static cvar_t *cl_serverQueryRate;
+static cvar_t *cl_serverQueryMax;
 
 static bool filter_allow_full = false;
 static bool filter_allow_empty = false;
@@ -65,32 +97,93 @@ int numMasterServers;
 
 //=========================================================
 
+/*
+* CL_PingQueueAppend
+*/
+static void CL_PingQueueAppend( pingqueue_t *queue, serverlist_t *server ) {
+	server->qprev = queue->tail;
+	server->qnext = NULL;
+	if( queue->tail ) {
+		queue->tail->qnext = server;
+	} else {
+		queue->head = server;
+	}
+	queue->tail = server;
+	queue->count++;
+}
+
+/*
+* CL_PingQueueRemove
+*/
+static void CL_PingQueueRemove( pingqueue_t *queue, serverlist_t *server ) {
+	if( server->qprev ) {
+		server->qprev->qnext = server->qnext;
+	} else {
+		queue->head = server->qnext;
+	}
+	if( server->qnext ) {
+		server->qnext->qprev = server->qprev;
+	} else {
+		queue->tail = server->qprev;
+	}
+	server->qprev = server->qnext = NULL;
+	queue->count--;
+}
+
+/*
+* CL_CancelServerPing
+*/
+static void CL_CancelServerPing( serverlist_t *server ) {
+	if( server->pingState == PING_WAITING ) {
+		CL_PingQueueRemove( &pingWaiting, server );
+	} else if( server->pingState == PING_SENT ) {
+		CL_PingQueueRemove( &pingSent, server );
+	}
+	server->pingState = PING_IDLE;
+}
+
 /*
 * CL_FreeServerlist
 */
-static void CL_FreeServerlist( serverlist_t **serversList ) {
+static void CL_FreeServerlist( serverlisthead_t *serversList ) {
 	serverlist_t *ptr;
 
-	while( *serversList ) {
-		ptr = *serversList;
-		*serversList = ptr->pnext;
+	while( serversList->first ) {
+		ptr = serversList->first;
+		serversList->first = ptr->pnext;
+		CL_CancelServerPing( ptr );
 		Mem_ZoneFree( ptr );
 	}
+
+	memset( serversList->hash, 0, sizeof( serversList->hash ) );
 }
 
 /*
-* CL_ServerIsInList
+* CL_ServerHashKey
+*
+* Addresses are compared case-insensitively
 */
-static serverlist_t *CL_ServerFindInList( serverlist_t *serversList, char *adr ) {
+static unsigned int CL_ServerHashKey( const char *adr ) {
+	unsigned int hash = 0;
+
+	while( *adr ) {
+		hash = hash * 31 + tolower( *adr++ );
+	}
+	return hash;
+}
 
+/*
+* CL_ServerIsInList
+*/
+static serverlist_t *CL_ServerFindInList( serverlisthead_t *serversList, const char *adr ) {
+	unsigned int hashKey;
 	serverlist_t *server;
 
-	server = serversList;
-	while( server ) {
-		if( !Q_stricmp( server->address, adr ) ) {
+	hashKey = CL_ServerHashKey( adr );
+	for( server = serversList->hash[hashKey & ( SERVERLIST_HASH_SIZE - 1 )]; server; server = server->hnext ) {
+		if( server->hashKey == hashKey && !Q_stricmp( server->address, adr ) ) {
 			return server;
 		}
-		server = server->pnext;
 	}
 
 	return NULL;
@@ -99,9 +192,10 @@ static serverlist_t *CL_ServerFindInList( serverlist_t *serversList, char *adr )
 /*
 * CL_AddServerToList
 */
-static bool CL_AddServerToList( serverlist_t **serversList, char *adr, unsigned int days ) {
+static bool CL_AddServerToList( serverlisthead_t *serversList, char *adr, unsigned int days ) {
 	serverlist_t *newserv;
 	netadr_t nadr;
+	serverlist_t **bucket;
 
 	if( !adr || !strlen( adr ) ) {
 		return false;
@@ -111,7 +205,7 @@ static bool CL_AddServerToList( serverlist_t **serversList, char *adr, unsigned
 		return false;
 	}
 
-	newserv = CL_ServerFindInList( *serversList, adr );
+	newserv = CL_ServerFindInList( serversList, adr );
 	if( newserv ) {
 		// ignore excessive updates for about a second or so, which may happen
 		// when we're querying multiple master servers at once
@@ -125,6 +219,11 @@ static bool CL_AddServerToList( serverlist_t **serversList, char *adr, unsigned
 
 	newserv = (serverlist_t *)Mem_ZoneMalloc( sizeof( serverlist_t ) );
 	Q_strncpyz( newserv->address, adr, sizeof( newserv->address ) );
+	newserv->adr = nadr;
+	if( NET_GetAddressPort( &newserv->adr ) == 0 ) {
+		NET_SetAddressPort( &newserv->adr, PORT_SERVER );
+	}
+	newserv->pingState = PING_IDLE;
 	newserv->pingTimeStamp = 0;
 	if( days == 0 ) {
 		newserv->lastValidPing = Com_DaysSince1900();
@@ -133,9 +232,14 @@ static bool CL_AddServerToList( serverlist_t **serversList, char *adr, unsigned
 	}
 	newserv->lastUpdatedByMasterServer = Sys_Milliseconds();
 	newserv->masterServerUpdateSeq = masterServerUpdateSeq;
-	newserv->pnext = *serversList;
+	newserv->pnext = serversList->first;
 	newserv->isLocal = NET_IsLocalAddress( &nadr );
-	*serversList = newserv;
+	serversList->first = newserv;
+
+	newserv->hashKey = CL_ServerHashKey( adr );
+	bucket = &serversList->hash[newserv->hashKey & ( SERVERLIST_HASH_SIZE - 1 )];
+	newserv->hnext = *bucket;
+	*bucket = newserv;
 
 	return true;
 }
@@ -159,7 +263,7 @@ void CL_WriteServerCache( void ) {
 	FS_Print( filehandle, str );
 
 	FS_Print( filehandle, "master\n" );
-	server = masterList;
+	server = masterList.first;
 	while( server ) {
 		if( !server->isLocal && server->lastValidPing + 7 > Com_DaysSince1900() ) {
 			if( NET_StringToAddress( server->address, &adr ) ) {
@@ -172,7 +276,7 @@ void CL_WriteServerCache( void ) {
 	}
 
 	FS_Print( filehandle, "favorites\n" );
-	server = favoritesList;
+	server = favoritesList.first;
 	while( server ) {
 		if( !server->isLocal && server->lastValidPing + 7 > Com_DaysSince1900() ) {
 			if( NET_StringToAddress( server->address, &adr ) ) {
@@ -316,13 +420,13 @@ void CL_QueryGetStatusMessage_f( void ) {
 
 /*
 * CL_PingServer_f
+*
+* Queues the server for pinging, the requests go out from CL_ServerListFrame
 */
 void CL_PingServer_f( void ) {
 	char *address_string;
-	char requestString[64];
 	netadr_t adr;
 	serverlist_t *pingserver;
-	socket_t *socket;
 
 	if( Cmd_Argc() < 2 ) {
 		Com_Printf( "Usage: pingserver [ip:port]\n" );
@@ -334,27 +438,85 @@ void CL_PingServer_f( void ) {
 		return;
 	}
 
-	pingserver = CL_ServerFindInList( masterList, address_string );
+	pingserver = CL_ServerFindInList( &masterList, address_string );
 	if( !pingserver ) {
-		pingserver = CL_ServerFindInList( favoritesList, address_string );
+		pingserver = CL_ServerFindInList( &favoritesList, address_string );
 	}
 	if( !pingserver ) {
 		return;
 	}
 
 	// never request a second ping while awaiting for a ping reply
-	if( pingserver->pingTimeStamp + SERVER_PINGING_TIMEOUT > Sys_Milliseconds() ) {
+	if( pingserver->pingState == PING_WAITING ) {
+		return;
+	}
+	if( pingserver->pingState == PING_SENT &&
+		pingserver->pingTimeStamp + SERVER_PINGING_TIMEOUT * 1000 > Sys_Microseconds() ) {
 		return;
 	}
 
-	pingserver->pingTimeStamp = Sys_Milliseconds();
+	CL_CancelServerPing( pingserver );
+
+	pingserver->pingState = PING_WAITING;
+	CL_PingQueueAppend( &pingWaiting, pingserver );
+}
+
+/*
+* CL_SendServerPings
+*
+* Sends queued pings at cl_serverQueryRate per second, keeping at most
+* cl_serverQueryMax requests awaiting a reply
+*/
+static void CL_SendServerPings( void ) {
+	char requestString[64];
+	serverlist_t *server;
+	socket_t *socket;
+	int64_t now;
+	uint64_t usec;
+	int maxSent;
+
+	now = Sys_Milliseconds();
+
+	// free the slots of servers that don't reply, a late reply still carries a valid ping
+	usec = Sys_Microseconds();
+	while( pingSent.head && pingSent.head->pingTimeStamp + SERVER_QUERY_TIMEOUT * 1000 < usec ) {
+		server = pingSent.head;
+		CL_PingQueueRemove( &pingSent, server );
+		server->pingState = PING_IDLE;
+	}
+
+	if( !pingWaiting.head ) {
+		pingAllowance = 0;
+		pingLastFrameTime = now;
+		return;
+	}
+
+	maxSent = max( cl_serverQueryMax->integer, 1 );
+	pingAllowance += ( now - pingLastFrameTime ) * 0.001 * max( cl_serverQueryRate->value, 1 );
+	pingAllowance = min( pingAllowance, maxSent );
+	pingLastFrameTime = now;
+
+	if( pingAllowance < 1 || pingSent.count >= maxSent ) {
+		return;
+	}
 
 	Q_snprintfz( requestString, sizeof( requestString ), "info %i %s %s", SERVERBROWSER_PROTOCOL_VERSION,
 				 filter_allow_full ? "full" : "",
 				 filter_allow_empty ? "empty" : "" );
 
-	socket = ( adr.type == NA_IP6 ? &cls.socket_udp6 : &cls.socket_udp );
-	Netchan_OutOfBandPrint( socket, &adr, "%s", requestString );
+	while( pingWaiting.head && pingAllowance >= 1 && pingSent.count < maxSent ) {
+		server = pingWaiting.head;
+		CL_PingQueueRemove( &pingWaiting, server );
+
+		socket = ( server->adr.type == NA_IP6 ? &cls.socket_udp6 : &cls.socket_udp );
+		Netchan_OutOfBandPrint( socket, &server->adr, "%s", requestString );
+
+		server->pingState = PING_SENT;
+		server->pingTimeStamp = Sys_Microseconds();
+		CL_PingQueueAppend( &pingSent, server );
+
+		pingAllowance -= 1;
+	}
 }
 
 /*
@@ -371,13 +533,16 @@ void CL_ParseStatusMessage( const socket_t *socket, const netadr_t *address, msg
 	Q_strncpyz( adrString, NET_AddressToString( address ), sizeof( adrString ) );
 
 	// ping response
-	pingserver = CL_ServerFindInList( masterList, adrString );
+	pingserver = CL_ServerFindInList( &masterList, adrString );
 	if( !pingserver ) {
-		pingserver = CL_ServerFindInList( favoritesList, adrString );
+		pingserver = CL_ServerFindInList( &favoritesList, adrString );
 	}
 
 	if( pingserver && pingserver->pingTimeStamp ) { // valid ping
-		int ping = (int)(Sys_Milliseconds() - pingserver->pingTimeStamp);
+		int ping = (int)( ( Sys_Microseconds() - pingserver->pingTimeStamp + 500 ) / 1000 );
+		if( pingserver->pingState == PING_SENT ) {
+			CL_CancelServerPing( pingserver );
+		}
 		CL_UIModule_AddToServerList( adrString, va( "\\\\ping\\\\%i%s", ping, s ) );
 		pingserver->pingTimeStamp = 0;
 		pingserver->lastValidPing = Com_DaysSince1900();
@@ -478,7 +643,7 @@ void CL_ParseGetServersResponse( const socket_t *socket, const netadr_t *address
 //	CL_WriteServerCache();
 
 	// dump servers we just received an update on from the master server
-	server = masterList;
+	server = masterList.first;
 	while( server ) {
 		if( server->masterServerUpdateSeq == masterServerUpdateSeq
 			&& !( server->isLocal && Com_ServerState() )
@@ -707,12 +872,17 @@ void CL_ServerListFrame( void ) {
 		}
 		master->delayedRequestModName[0] = '\0';
 	}
+
+	CL_SendServerPings();
 }
 
 /*
 * CL_InitServerList
 */
 void CL_InitServerList( void ) {
+	cl_serverQueryRate = Cvar_Get( "cl_serverQueryRate", "200", CVAR_ARCHIVE );
+	cl_serverQueryMax = Cvar_Get( "cl_serverQueryMax", "64", CVAR_ARCHIVE );
+
 	CL_FreeServerlist( &masterList );
 	CL_FreeServerlist( &favoritesList );
 
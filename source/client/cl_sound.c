@@ -228,6 +228,7 @@ void CL_SoundModule_Init( bool verbose ) {
 	import.Cvar_SetValue = Cvar_SetValue;
 	import.Cvar_ForceSet = Cvar_ForceSet;
 	import.Cvar_String = Cvar_String;
+	import.Cvar_ReadNumbers = Cvar_ReadNumbers;
 	import.Cvar_Value = Cvar_Value;
 
 	import.Cmd_Argc = Cmd_Argc;
@@ -254,6 +255,7 @@ void CL_SoundModule_Init( bool verbose ) {
 	import.FS_IsUrl = FS_IsUrl;
 
 	import.Sys_Milliseconds = Sys_Milliseconds;
+	import.Sys_Microseconds = Sys_Microseconds;
 	import.Sys_Sleep = Sys_Sleep;
 
 	import.Sys_LoadLibrary = Com_LoadSysLibrary;
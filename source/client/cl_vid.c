@@ -349,6 +349,8 @@ static bool VID_LoadRefresh( const char *name ) {
 	import.Sys_Microseconds = &Sys_Microseconds;
 	import.Sys_Sleep = &Sys_Sleep;
 
+	import.Com_CPUFeatures = &COM_CPUFeatures;
+
 	import.Com_LoadSysLibrary = Com_LoadSysLibrary;
 	import.Com_UnloadLibrary = Com_UnloadLibrary;
 	import.Com_LibraryProcAddress = Com_LibraryProcAddress;
@@ -386,6 +388,8 @@ static bool VID_LoadRefresh( const char *name ) {
 	import.FS_MoveFile = &FS_MoveFile;
 	import.FS_IsUrl = &FS_IsUrl;
 	import.FS_FileMTime = &FS_FileMTime;
+	import.FS_PakNameForFile = &FS_PakNameForFile;
+	import.FS_ChecksumBaseFile = &FS_ChecksumBaseFile;
 	import.FS_RemoveDirectory = &FS_RemoveDirectory;
 	import.FS_GameDirectory = &FS_GameDirectory;
 	import.FS_WriteDirectory = &FS_WriteDirectory;
@@ -422,6 +426,11 @@ static bool VID_LoadRefresh( const char *name ) {
 	import.BufPipe_ReadCmds = QBufPipe_ReadCmds;
 	import.BufPipe_Wait = QBufPipe_Wait;
 
+	import.Jobs_NumThreads = QJobs_NumThreads;
+	import.Jobs_Add = QJobs_Add;
+	import.Jobs_ParallelFor = QJobs_ParallelFor;
+	import.Jobs_Wait = QJobs_Wait;
+
 	file_size = strlen( LIB_DIRECTORY "/" LIB_PREFIX ) + strlen( name ) + strlen( LIB_SUFFIX ) + 1;
 	file = Mem_TempMalloc( file_size );
 	Q_snprintfz( file, file_size, LIB_DIRECTORY "/" LIB_PREFIX "%s" LIB_SUFFIX, name );
@@ -271,6 +271,15 @@ void FTLIB_FreeFonts( bool verbose ) {
 	}
 }
 
+/*
+* FTLIB_Frame
+*/
+void FTLIB_Frame( void ) {
+	if( ftlib_export ) {
+		ftlib_export->Frame();
+	}
+}
+
 // drawing functions
 
 /*
@@ -27,6 +27,7 @@ void FTLIB_TouchFont( struct qfontface_s *qfont );
 void FTLIB_TouchAllFonts( void );
 void FTLIB_PrecacheFonts( bool verbose );
 void FTLIB_FreeFonts( bool verbose );
+void FTLIB_Frame( void );
 
 // drawing functions
 
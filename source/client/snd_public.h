@@ -20,7 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // snd_public.h -- sound dll information visible to engine
 
-#define SOUND_API_VERSION   40
+#define SOUND_API_VERSION   42
 
 #define ATTN_NONE 0
 
@@ -48,6 +48,7 @@ typedef struct {
 	cvar_t *( *Cvar_ForceSet )( const char *name, const char *value );      // will return 0 0 if not found
 	float ( *Cvar_Value )( const char *name );
 	const char *( *Cvar_String )( const char *name );
+	void ( *Cvar_ReadNumbers )( const cvar_t *var, float *value, int *integer );    // safe to call from any thread
 
 	int ( *Cmd_Argc )( void );
 	char *( *Cmd_Argv )( int arg );
@@ -78,6 +79,7 @@ typedef struct {
 	bool ( *FS_IsUrl )( const char *url );
 
 	int64_t ( *Sys_Milliseconds )( void );
+	uint64_t ( *Sys_Microseconds )( void );
 	void ( *Sys_Sleep )( unsigned int milliseconds );
 
 	void *( *Sys_LoadLibrary )( const char *name, dllfunc_t * funcs );
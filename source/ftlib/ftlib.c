@@ -41,6 +41,10 @@ static qfontfamily_t *fontFamilies;
 #define QFTGLYPH_SEARCHED_MAIN      1           // the main font has been searched for the gindex
 #define QFTGLYPH_SEARCHED_FALLBACK  ( 1 << 1 )  // the fallback font has been searched for the gindex
 #define QFTGLYPH_FROM_FALLBACK      ( 1 << 2 )  // the fallback gindex should be used
+#define QFTGLYPH_PENDING            ( 1 << 3 )  // shows the replacement glyph until rasterized in QFT_Frame
+
+#define QFT_KERNING_CACHE_SIZE      512         // must be a power of two
+#define QFT_MAX_PENDING_GLYPHS      256
 
 static uint8_t *qftGlyphTempBitmap;
 static unsigned int qftGlyphTempBitmapHeight;
@@ -48,6 +52,20 @@ static unsigned int qftGlyphTempBitmapHeight;
 
 FT_Library ftLibrary = NULL;
 
+static cvar_t *ft_glyphsPerFrame;
+static cvar_t *ft_maxFontImages;
+
+typedef struct {
+	unsigned int rasterized;
+	unsigned int deferred;
+	unsigned int evicted;
+	unsigned int kerningHits, kerningMisses;
+} qftstats_t;
+
+static unsigned int qftFrameNum;
+static qftstats_t qftFrameStats, qftLastFrameStats, qftTotalStats;
+static unsigned int qftPeakRasterized;
+
 typedef struct qftfallback_s {
 	FT_Size ftsize;
 	unsigned int size;
@@ -60,17 +78,31 @@ typedef struct {
 	qftfallback_t *fallbacks;
 } qftfamily_t;
 
+typedef struct {
+	FT_UInt gindex1, gindex2;
+	bool fallback;
+	int kerning;
+} qftkerning_t;
+
 typedef struct {
 	unsigned int imageCurX, imageCurY, imageCurLineHeight;
+	unsigned int imageCurShader;
+	unsigned int *shaderFrames;     // last frame each image was used in, for LRU eviction
 
 	FT_Size ftsize, ftfallbacksize;
 	qfontfamily_t *fallbackFamily;
 	bool fallbackLoaded;
+
+	qftkerning_t kerningCache[QFT_KERNING_CACHE_SIZE];
+
+	unsigned int numPending;
+	wchar_t pending[QFT_MAX_PENDING_GLYPHS];
 } qftface_t;
 
 typedef struct {
 	qglyph_t qglyph;
 	unsigned int flags;
+	unsigned int shaderNum;
 	FT_UInt gindex;
 } qftglyph_t;
 
@@ -233,7 +265,14 @@ static qglyph_t *QFT_GetGlyph( qfontface_t *qfont, void *glyphArray, unsigned in
 		}
 	}
 
-	return qftglyph->gindex ? &( qftglyph->qglyph ) : NULL;
+	if( !qftglyph->gindex ) {
+		return NULL;
+	}
+
+	if( qftglyph->qglyph.shader ) {
+		qttf->shaderFrames[qftglyph->shaderNum] = qftFrameNum;
+	}
+	return &( qftglyph->qglyph );
 }
 
 /*
@@ -243,6 +282,8 @@ static int QFT_GetKerning( qfontface_t *qfont, qglyph_t *g1_, qglyph_t *g2_ ) {
 	qftglyph_t *g1, *g2;
 	FT_UInt gi1, gi2;
 	qftface_t *qttf;
+	qftkerning_t *cached;
+	bool fallback;
 	FT_Size ftsize;
 	FT_Vector kvec;
 
@@ -271,10 +312,24 @@ static int QFT_GetKerning( qfontface_t *qfont, qglyph_t *g1_, qglyph_t *g2_ ) {
 	}
 
 	qttf = ( qftface_t * )( qfont->facedata );
-	ftsize = ( ( g1->flags & QFTGLYPH_FROM_FALLBACK ) ? qttf->ftfallbacksize : qttf->ftsize );
+	fallback = ( g1->flags & QFTGLYPH_FROM_FALLBACK ) ? true : false;
+
+	cached = &qttf->kerningCache[( gi1 * 31 + gi2 ) & ( QFT_KERNING_CACHE_SIZE - 1 )];
+	if( cached->gindex1 == gi1 && cached->gindex2 == gi2 && cached->fallback == fallback ) {
+		qftFrameStats.kerningHits++;
+		return cached->kerning;
+	}
+	qftFrameStats.kerningMisses++;
+
+	ftsize = ( fallback ? qttf->ftfallbacksize : qttf->ftsize );
 	q_FT_Activate_Size( ftsize );
 	q_FT_Get_Kerning( ftsize->face, gi1, gi2, FT_KERNING_DEFAULT, &kvec );
-	return kvec.x >> 6;
+
+	cached->gindex1 = gi1;
+	cached->gindex2 = gi2;
+	cached->fallback = fallback;
+	cached->kerning = kvec.x >> 6;
+	return cached->kerning;
 }
 
 /*
@@ -295,6 +350,107 @@ static void QFT_UploadRenderedGlyphs( uint8_t *pic, struct shader_s *shader, int
 	trap_R_ReplaceRawSubPic( shader, x, y, width, height, pic );
 }
 
+/*
+* QFT_EvictImage
+*
+* Drops all glyphs rendered into the image so it can be reused.
+*/
+static void QFT_EvictImage( qfontface_t *qfont, unsigned int shaderNum ) {
+	unsigned int i, j;
+	qftglyph_t *qftglyph;
+
+	for( i = 0; i < ( sizeof( qfont->glyphs ) / sizeof( qfont->glyphs[0] ) ); i++ ) {
+		if( !qfont->glyphs[i] ) {
+			continue;
+		}
+
+		qftglyph = ( qftglyph_t * )qfont->glyphs[i];
+		for( j = 0; j < 256; j++, qftglyph++ ) {
+			if( qftglyph->qglyph.shader && ( qftglyph->shaderNum == shaderNum ) ) {
+				qftglyph->qglyph.shader = NULL;
+				qftglyph->flags &= ~QFTGLYPH_PENDING;
+			}
+		}
+	}
+
+	qftFrameStats.evicted++;
+}
+
+/*
+* QFT_NextImage
+*
+* Returns a fresh image to continue rendering glyphs to. Once the font has ft_maxFontImages
+* images, the least recently used one is recycled instead. The first image, which contains
+* the pre-rendered ASCII glyphs, and the images drawn from during the current frame are kept.
+*/
+static struct shader_s *QFT_NextImage( qfontface_t *qfont ) {
+	qftface_t *qttf = ( qftface_t * )( qfont->facedata );
+	unsigned int i, shaderNum = 0;
+
+	if( ft_maxFontImages->integer > 0 && qfont->numShaders >= (unsigned int)ft_maxFontImages->integer ) {
+		for( i = 1; i < qfont->numShaders; i++ ) {
+			if( i == qttf->imageCurShader || qttf->shaderFrames[i] == qftFrameNum ) {
+				continue;
+			}
+			if( !shaderNum || qttf->shaderFrames[i] < qttf->shaderFrames[shaderNum] ) {
+				shaderNum = i;
+			}
+		}
+	}
+
+	if( shaderNum ) {
+		QFT_EvictImage( qfont, shaderNum );
+	} else {
+		shaderNum = ( qfont->numShaders )++;
+		qfont->shaders = FTLIB_Realloc( qfont->shaders, qfont->numShaders * sizeof( struct shader_s * ) );
+		qfont->shaders[shaderNum] = trap_R_RegisterRawAlphaMask( FTLIB_FontShaderName( qfont, shaderNum ),
+																 qfont->shaderWidth, qfont->shaderHeight, NULL );
+		qttf->shaderFrames = FTLIB_Realloc( qttf->shaderFrames, qfont->numShaders * sizeof( unsigned int ) );
+	}
+
+	qttf->imageCurX = 0;
+	qttf->imageCurY = 0;
+	qttf->imageCurLineHeight = 0;
+	qttf->imageCurShader = shaderNum;
+	qttf->shaderFrames[shaderNum] = qftFrameNum;
+
+	return qfont->shaders[shaderNum];
+}
+
+/*
+* QFT_DeferGlyph
+*
+* Once ft_glyphsPerFrame glyphs have been rasterized during the frame, shows the replacement
+* glyph in place of a non-ASCII one and queues it to be rasterized in one of the next frames.
+*/
+static bool QFT_DeferGlyph( qfontface_t *qfont, qftglyph_t *qftglyph, wchar_t num ) {
+	qftface_t *qttf = ( qftface_t * )( qfont->facedata );
+	qftglyph_t *replacement;
+
+	if( num < 128 || ft_glyphsPerFrame->integer <= 0 ) {
+		return false;
+	}
+	if( qftFrameStats.rasterized < (unsigned int)ft_glyphsPerFrame->integer ) {
+		return false;
+	}
+	if( qttf->numPending == QFT_MAX_PENDING_GLYPHS ) {
+		return false;
+	}
+
+	replacement = ( qftglyph_t * )FTLIB_GetGlyph( qfont, FTLIB_REPLACEMENT_GLYPH );
+	if( !replacement || !replacement->qglyph.shader ) {
+		return false;
+	}
+
+	qftglyph->qglyph = replacement->qglyph;
+	qftglyph->shaderNum = replacement->shaderNum;
+	qftglyph->flags |= QFTGLYPH_PENDING;
+	qttf->pending[qttf->numPending++] = num;
+
+	qftFrameStats.deferred++;
+	return true;
+}
+
 /*
 * QFT_RenderString
 */
@@ -311,8 +467,7 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 	int srcStride = 0;
 	unsigned int bitmapWidth, bitmapHeight;
 	unsigned int tempWidth = 0, tempLineHeight = 0;
-	struct shader_s *shader = qfont->shaders[qfont->numShaders - 1];
-	int shaderNum;
+	struct shader_s *shader = qfont->shaders[qttf->imageCurShader];
 	int x, y;
 	uint8_t *src, *dest;
 
@@ -341,6 +496,12 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 		// from now, it is assumed that the current glyph's shader will be valid after this function
 		// so if continue is used, any shader, even an empty one, should be assigned to the glyph
 
+		if( QFT_DeferGlyph( qfont, qftglyph, num ) ) {
+			continue;
+		}
+
+		qftFrameStats.rasterized++;
+
 		ftsize = ( ( qftglyph->flags & QFTGLYPH_FROM_FALLBACK ) ? qttf->ftfallbacksize : qttf->ftsize );
 		q_FT_Activate_Size( ftsize );
 		fterror = q_FT_Load_Glyph( ftsize->face, qftglyph->gindex, FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL );
@@ -348,6 +509,7 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 			Com_Printf( S_COLOR_YELLOW "Warning: Failed to load and render glyph %i for '%s', error %i\n",
 						num, qfont->family->name, fterror );
 			qglyph->shader = shader;
+			qftglyph->shaderNum = qttf->imageCurShader;
 			continue;
 		}
 		ftglyph = ftsize->face->glyph;
@@ -396,13 +558,7 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 				if( ( qttf->imageCurY + bitmapHeight ) > qfont->shaderHeight ) {
 					QFT_UploadRenderedGlyphs( qftGlyphTempBitmap, shader, qttf->imageCurX, qttf->imageCurY, qfont->shaderWidth, tempWidth, tempLineHeight );
 					tempWidth = 0;
-					qttf->imageCurX = 0;
-					qttf->imageCurY = 0;
-					shaderNum = ( qfont->numShaders )++;
-					shader = trap_R_RegisterRawAlphaMask( FTLIB_FontShaderName( qfont, shaderNum ),
-														  qfont->shaderWidth, qfont->shaderHeight, NULL );
-					qfont->shaders = FTLIB_Realloc( qfont->shaders, qfont->numShaders * sizeof( struct shader_s * ) );
-					qfont->shaders[shaderNum] = shader;
+					shader = QFT_NextImage( qfont );
 				}
 				qttf->imageCurLineHeight = bitmapHeight;
 			}
@@ -415,6 +571,8 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 		qglyph->x_offset = ftglyph->bitmap_left;
 		qglyph->y_offset = -( (int)( ftglyph->bitmap_top ) );
 		qglyph->shader = shader;
+		qftglyph->shaderNum = qttf->imageCurShader;
+		qttf->shaderFrames[qttf->imageCurShader] = qftFrameNum;
 		qglyph->s1 = ( float )( qttf->imageCurX + tempWidth + 1 ) / ( float )qfont->shaderWidth;
 		qglyph->t1 = ( float )( qttf->imageCurY + 1 ) / ( float )qfont->shaderHeight;
 		qglyph->s2 = ( float )( qttf->imageCurX + tempWidth + 1 + qglyph->width ) / ( float )qfont->shaderWidth;
@@ -462,6 +620,38 @@ static void QFT_SetFallback( qfontface_t *qfont, qfontfamily_t *qfamily ) {
 	}
 }
 
+/*
+* QFT_RenderPendingGlyphs
+*/
+static void QFT_RenderPendingGlyphs( qfontface_t *qfont ) {
+	qftface_t *qttf = ( qftface_t * )( qfont->facedata );
+	qftglyph_t *qftglyph;
+	unsigned int i, numPending;
+	wchar_t pending[QFT_MAX_PENDING_GLYPHS + 1];
+	char renderStr[QFT_MAX_PENDING_GLYPHS * 4 + 1];
+
+	if( !qttf || !qttf->numPending ) {
+		return;
+	}
+
+	// the glyphs deferred again are appended back to the queue by QFT_RenderString
+	numPending = qttf->numPending;
+	memcpy( pending, qttf->pending, numPending * sizeof( wchar_t ) );
+	qttf->numPending = 0;
+
+	for( i = 0; i < numPending; i++ ) {
+		qftglyph = ( qftglyph_t * )FTLIB_GetGlyph( qfont, pending[i] );
+		if( qftglyph && ( qftglyph->flags & QFTGLYPH_PENDING ) ) {
+			qftglyph->flags &= ~QFTGLYPH_PENDING;
+			qftglyph->qglyph.shader = NULL;
+		}
+	}
+	pending[numPending] = 0;
+
+	Q_WCharToUtf8String( pending, renderStr, sizeof( renderStr ) );
+	QFT_RenderString( qfont, renderStr );
+}
+
 static const qfontface_funcs_t qft_face_funcs =
 {
 	QFT_AllocGlyphs,
@@ -561,6 +751,8 @@ static qfontface_t *QFT_LoadFace( qfontfamily_t *family, unsigned int size ) {
 	qfont->shaders = FTLIB_Alloc( ftlibPool, sizeof( struct shader_s * ) );
 	qfont->shaders[0] = trap_R_RegisterRawAlphaMask( FTLIB_FontShaderName( qfont, 0 ),
 													 qfont->shaderWidth, qfont->shaderHeight, NULL );
+	qttf->shaderFrames = FTLIB_Alloc( ftlibPool, sizeof( unsigned int ) );
+	qttf->shaderFrames[0] = qftFrameNum;
 	qfont->hasKerning = hasKerning;
 	qfont->f = &qft_face_funcs;
 	qfont->facedata = ( void * )qttf;
@@ -590,6 +782,10 @@ static void QFT_UnloadFace( qfontface_t *qfont ) {
 
 	q_FT_Done_Size( qttf->ftsize );
 
+	if( qttf->shaderFrames ) {
+		FTLIB_Free( qttf->shaderFrames );
+	}
+
 	FTLIB_Free( qttf );
 }
 
@@ -784,6 +980,14 @@ static void QFT_Init( bool verbose ) {
 		}
 	}
 
+	ft_glyphsPerFrame = trap_Cvar_Get( "ft_glyphsPerFrame", "8", CVAR_ARCHIVE );
+	ft_maxFontImages = trap_Cvar_Get( "ft_maxFontImages", "8", CVAR_ARCHIVE );
+
+	memset( &qftFrameStats, 0, sizeof( qftFrameStats ) );
+	memset( &qftLastFrameStats, 0, sizeof( qftLastFrameStats ) );
+	memset( &qftTotalStats, 0, sizeof( qftTotalStats ) );
+	qftPeakRasterized = 0;
+
 	assert( !qftGlyphTempBitmap );
 	qftGlyphTempBitmap = FTLIB_Alloc( ftlibPool, FTLIB_FONT_MAX_IMAGE_WIDTH * QFT_GLYPH_BITMAP_HEIGHT_INCREMENT );
 	qftGlyphTempBitmapHeight = QFT_GLYPH_BITMAP_HEIGHT_INCREMENT;
@@ -807,6 +1011,34 @@ static void QFT_Shutdown( void ) {
 	QFT_UnloadFreetypeLibrary();
 }
 
+/*
+* QFT_Frame
+*/
+static void QFT_Frame( void ) {
+	qfontfamily_t *qfamily;
+	qfontface_t *qface;
+
+	qftLastFrameStats = qftFrameStats;
+	qftTotalStats.rasterized += qftFrameStats.rasterized;
+	qftTotalStats.deferred += qftFrameStats.deferred;
+	qftTotalStats.evicted += qftFrameStats.evicted;
+	qftTotalStats.kerningHits += qftFrameStats.kerningHits;
+	qftTotalStats.kerningMisses += qftFrameStats.kerningMisses;
+	if( qftFrameStats.rasterized > qftPeakRasterized ) {
+		qftPeakRasterized = qftFrameStats.rasterized;
+	}
+
+	memset( &qftFrameStats, 0, sizeof( qftFrameStats ) );
+	qftFrameNum++;
+
+	// rasterize the glyphs deferred during the previous frames
+	for( qfamily = fontFamilies; qfamily; qfamily = qfamily->next ) {
+		for( qface = qfamily->faces; qface; qface = qface->next ) {
+			QFT_RenderPendingGlyphs( qface );
+		}
+	}
+}
+
 // ============================================================================
 
 /*
@@ -1005,6 +1237,26 @@ void FTLIB_PrintFontList( void ) {
 	}
 }
 
+/*
+* FTLIB_PrintFontStats
+*/
+void FTLIB_PrintFontStats( void ) {
+	Com_Printf( "Last frame: %u glyphs rasterized, %u deferred, %u images evicted, kerning %u hits / %u misses\n",
+				qftLastFrameStats.rasterized, qftLastFrameStats.deferred, qftLastFrameStats.evicted,
+				qftLastFrameStats.kerningHits, qftLastFrameStats.kerningMisses );
+	Com_Printf( "Total: %u glyphs rasterized, %u deferred, %u images evicted, kerning %u hits / %u misses\n",
+				qftTotalStats.rasterized, qftTotalStats.deferred, qftTotalStats.evicted,
+				qftTotalStats.kerningHits, qftTotalStats.kerningMisses );
+	Com_Printf( "Peak: %u glyphs rasterized in a frame\n", qftPeakRasterized );
+}
+
+/*
+* FTLIB_Frame
+*/
+void FTLIB_Frame( void ) {
+	QFT_Frame();
+}
+
 /*
 * FTLIB_GetGlyph
 *
@@ -161,6 +161,8 @@ void FTLIB_TouchFont( qfontface_t *qfont );
 void FTLIB_TouchAllFonts( void );
 void FTLIB_FreeFonts( bool verbose );
 void FTLIB_PrintFontList( void );
+void FTLIB_PrintFontStats( void );
+void FTLIB_Frame( void );
 qglyph_t *FTLIB_GetGlyph( qfontface_t *font, wchar_t num );
 const char *FTLIB_FontShaderName( qfontface_t *qfont, unsigned int shaderNum );
 
@@ -42,6 +42,7 @@ QF_DLL_EXPORT ftlib_export_t *GetFTLibAPI( ftlib_import_t *import ) {
 	globals.TouchFont = &FTLIB_TouchFont;
 	globals.TouchAllFonts = &FTLIB_TouchAllFonts;
 	globals.FreeFonts = &FTLIB_FreeFonts;
+	globals.Frame = &FTLIB_Frame;
 
 	globals.FontSize = &FTLIB_FontSize;
 	globals.FontHeight = &FTLIB_FontHeight;
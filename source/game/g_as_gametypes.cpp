@@ -35,6 +35,168 @@ static void GT_ResetScriptData( void ) {
 	level.gametype.shutdownFunc = NULL;
 }
 
+/*
+* Gametype script callbacks
+*
+* Every callback owns a script context which stays prepared with the
+* callback function between calls, so that AngelScript can skip most
+* of the setup when the same function is executed again. Execution
+* time of each callback is accounted for the gtprofile command.
+*/
+typedef enum {
+	GT_CALLBACK_INIT,
+	GT_CALLBACK_SPAWN,
+	GT_CALLBACK_MATCHSTATESTARTED,
+	GT_CALLBACK_MATCHSTATEFINISHED,
+	GT_CALLBACK_THINKRULES,
+	GT_CALLBACK_PLAYERRESPAWN,
+	GT_CALLBACK_SCOREEVENT,
+	GT_CALLBACK_SCOREBOARDMESSAGE,
+	GT_CALLBACK_SELECTSPAWNPOINT,
+	GT_CALLBACK_COMMAND,
+	GT_CALLBACK_BOTSTATUS,
+	GT_CALLBACK_SHUTDOWN,
+
+	GT_CALLBACK_TOTAL
+} gtCallbackNum_t;
+
+typedef struct {
+	const char *name;
+	asIScriptContext *ctx;
+
+	unsigned calls;
+	unsigned overBudget;
+	uint64_t totalTime;
+	uint64_t maxTime;
+	int64_t nextWarning;
+} gtCallback_t;
+
+static gtCallback_t gtCallbacks[GT_CALLBACK_TOTAL] = {
+	{ "GT_InitGametype" },
+	{ "GT_SpawnGametype" },
+	{ "GT_MatchStateStarted" },
+	{ "GT_MatchStateFinished" },
+	{ "GT_ThinkRules" },
+	{ "GT_PlayerRespawn" },
+	{ "GT_ScoreEvent" },
+	{ "GT_ScoreboardMessage" },
+	{ "GT_SelectSpawnPoint" },
+	{ "GT_Command" },
+	{ "GT_UpdateBotStatus" },
+	{ "GT_Shutdown" },
+};
+
+/*
+* GT_asPrepareCallback
+*
+* Returns the context of the callback, prepared to execute the function.
+* Falls back to a shared context if the callback has been reentered.
+*/
+static asIScriptContext *GT_asPrepareCallback( gtCallbackNum_t num, void *func ) {
+	gtCallback_t *cb = &gtCallbacks[num];
+	asIScriptContext *ctx = cb->ctx;
+
+	if( !ctx ) {
+		ctx = game.asExport->asCreateUnmanagedContext( GAME_AS_ENGINE() );
+		cb->ctx = ctx;
+	}
+
+	if( !ctx || ctx->GetState() == asEXECUTION_ACTIVE || ctx->GetState() == asEXECUTION_SUSPENDED ) {
+		ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
+		if( !ctx ) {
+			return NULL;
+		}
+	}
+
+	if( ctx->Prepare( static_cast<asIScriptFunction *>( func ) ) < 0 ) {
+		return NULL;
+	}
+	return ctx;
+}
+
+/*
+* GT_asExecuteCallback
+*/
+static int GT_asExecuteCallback( gtCallbackNum_t num, asIScriptContext *ctx ) {
+	int error;
+	uint64_t start, time;
+	gtCallback_t *cb = &gtCallbacks[num];
+
+	start = trap_Microseconds();
+	error = ctx->Execute();
+	time = trap_Microseconds() - start;
+
+	cb->calls++;
+	cb->totalTime += time;
+	if( time > cb->maxTime ) {
+		cb->maxTime = time;
+	}
+
+	if( g_asGT_budget->value > 0 && time > (uint64_t)( g_asGT_budget->value * 1000 ) ) {
+		cb->overBudget++;
+
+		// don't flood the console
+		if( game.realtime >= cb->nextWarning ) {
+			G_Printf( S_COLOR_YELLOW "WARNING: %s took %.2f ms, frame budget is %.2f ms\n",
+					  cb->name, time / 1000.0, g_asGT_budget->value );
+			cb->nextWarning = game.realtime + 5000;
+		}
+	}
+
+	return error;
+}
+
+/*
+* GT_asReleaseCallbackContexts
+*
+* Must be called before the script engine is released.
+*/
+void GT_asReleaseCallbackContexts( void ) {
+	int i;
+
+	for( i = 0; i < GT_CALLBACK_TOTAL; i++ ) {
+		if( gtCallbacks[i].ctx ) {
+			gtCallbacks[i].ctx->Release();
+			gtCallbacks[i].ctx = NULL;
+		}
+	}
+}
+
+/*
+* GT_asProfile_f
+*
+* Prints execution time statistics of the gametype script callbacks. With
+* angelwrap built with ANGELWRAP_USE_JIT, run the same gametype with as_jit
+* 0 and 1 to compare the interpreter to the JIT.
+*/
+void GT_asProfile_f( void ) {
+	int i;
+	const gtCallback_t *cb;
+
+	if( !Q_stricmp( trap_Cmd_Argv( 1 ), "reset" ) ) {
+		for( i = 0; i < GT_CALLBACK_TOTAL; i++ ) {
+			gtCallbacks[i].calls = gtCallbacks[i].overBudget = 0;
+			gtCallbacks[i].totalTime = gtCallbacks[i].maxTime = 0;
+		}
+		return;
+	}
+
+	if( game.asEngine ) {
+		G_Printf( "Gametype scripts run %s\n",
+				  GAME_AS_ENGINE()->GetEngineProperty( asEP_INCLUDE_JIT_INSTRUCTIONS ) ? "JIT compiled" : "in the interpreter" );
+	}
+
+	G_Printf( "%-24s %8s %10s %8s %8s %6s\n", "callback", "calls", "total ms", "avg us", "max us", "over" );
+	for( i = 0; i < GT_CALLBACK_TOTAL; i++ ) {
+		cb = &gtCallbacks[i];
+		if( !cb->calls ) {
+			continue;
+		}
+		G_Printf( "%-24s %8u %10.2f %8.1f %8" PRIu64 " %6u\n", cb->name, cb->calls, cb->totalTime / 1000.0,
+				  (double)cb->totalTime / cb->calls, cb->maxTime, cb->overBudget );
+	}
+}
+
 void GT_asShutdownScript( void ) {
 	int i;
 	edict_t *e;
@@ -56,6 +218,14 @@ void GT_asShutdownScript( void ) {
 
 	GT_ResetScriptData();
 
+	// drop references to the script functions, the contexts are reused with the next script
+	for( i = 0; i < GT_CALLBACK_TOTAL; i++ ) {
+		asIScriptContext *ctx = gtCallbacks[i].ctx;
+		if( ctx && ctx->GetState() != asEXECUTION_ACTIVE && ctx->GetState() != asEXECUTION_SUSPENDED ) {
+			ctx->Unprepare();
+		}
+	}
+
 	GAME_AS_ENGINE()->DiscardModule( GAMETYPE_SCRIPTS_MODULE_NAME );
 }
 
@@ -68,14 +238,12 @@ void GT_asCallSpawn( void ) {
 		return;
 	}
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.spawnFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_SPAWN, level.gametype.spawnFunc );
+	if( !ctx ) {
 		return;
 	}
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_SPAWN, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -90,14 +258,12 @@ void GT_asCallMatchStateStarted( void ) {
 		return;
 	}
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.matchStateStartedFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_MATCHSTATESTARTED, level.gametype.matchStateStartedFunc );
+	if( !ctx ) {
 		return;
 	}
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_MATCHSTATESTARTED, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -113,17 +279,15 @@ bool GT_asCallMatchStateFinished( int incomingMatchState ) {
 		return true;
 	}
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.matchStateFinishedFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_MATCHSTATEFINISHED, level.gametype.matchStateFinishedFunc );
+	if( !ctx ) {
 		return true;
 	}
 
 	// Now we need to pass the parameters to the script function.
 	ctx->SetArgDWord( 0, incomingMatchState );
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_MATCHSTATEFINISHED, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -143,14 +307,12 @@ void GT_asCallThinkRules( void ) {
 		return;
 	}
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.thinkRulesFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_THINKRULES, level.gametype.thinkRulesFunc );
+	if( !ctx ) {
 		return;
 	}
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_THINKRULES, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -165,10 +327,8 @@ void GT_asCallPlayerRespawn( edict_t *ent, int old_team, int new_team ) {
 		return;
 	}
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.playerRespawnFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_PLAYERRESPAWN, level.gametype.playerRespawnFunc );
+	if( !ctx ) {
 		return;
 	}
 
@@ -177,7 +337,7 @@ void GT_asCallPlayerRespawn( edict_t *ent, int old_team, int new_team ) {
 	ctx->SetArgDWord( 1, old_team );
 	ctx->SetArgDWord( 2, new_team );
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_PLAYERRESPAWN, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -201,10 +361,8 @@ void GT_asCallScoreEvent( gclient_t *client, const char *score_event, const char
 		args = "";
 	}
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.scoreEventFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_SCOREEVENT, level.gametype.scoreEventFunc );
+	if( !ctx ) {
 		return;
 	}
 
@@ -216,7 +374,7 @@ void GT_asCallScoreEvent( gclient_t *client, const char *score_event, const char
 	ctx->SetArgObject( 1, s1 );
 	ctx->SetArgObject( 2, s2 );
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_SCOREEVENT, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -238,17 +396,15 @@ void GT_asCallScoreboardMessage( unsigned int maxlen ) {
 		return;
 	}
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.scoreboardMessageFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_SCOREBOARDMESSAGE, level.gametype.scoreboardMessageFunc );
+	if( !ctx ) {
 		return;
 	}
 
 	// Now we need to pass the parameters to the script function.
 	ctx->SetArgDWord( 0, maxlen );
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_SCOREBOARDMESSAGE, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -271,17 +427,15 @@ edict_t *GT_asCallSelectSpawnPoint( edict_t *ent ) {
 		return SelectDeathmatchSpawnPoint( ent ); // should have a hardcoded backup
 
 	}
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.selectSpawnPointFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_SELECTSPAWNPOINT, level.gametype.selectSpawnPointFunc );
+	if( !ctx ) {
 		return SelectDeathmatchSpawnPoint( ent );
 	}
 
 	// Now we need to pass the parameters to the script function.
 	ctx->SetArgObject( 0, ent );
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_SELECTSPAWNPOINT, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -310,10 +464,8 @@ bool GT_asCallGameCommand( gclient_t *client, const char *cmd, const char *args,
 		return false;
 	}
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.clientCommandFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_COMMAND, level.gametype.clientCommandFunc );
+	if( !ctx ) {
 		return false;
 	}
 
@@ -326,7 +478,7 @@ bool GT_asCallGameCommand( gclient_t *client, const char *cmd, const char *args,
 	ctx->SetArgObject( 2, s2 );
 	ctx->SetArgDWord( 3, argc );
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_COMMAND, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -347,16 +499,14 @@ bool GT_asCallBotStatus( edict_t *ent )
 	if( !level.gametype.botStatusFunc )
 		return false; // should have a hardcoded backup
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.botStatusFunc ) );
-	if( error < 0 )
+	ctx = GT_asPrepareCallback( GT_CALLBACK_BOTSTATUS, level.gametype.botStatusFunc );
+	if( !ctx )
 		return false;
 
 	// Now we need to pass the parameters to the script function.
 	ctx->SetArgObject( 0, ent );
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_BOTSTATUS, ctx );
 	if( G_ExecutionErrorReport( error ) )
 		GT_asShutdownScript();
 
@@ -373,14 +523,12 @@ void GT_asCallShutdown( void ) {
 		return;
 	}
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.shutdownFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_SHUTDOWN, level.gametype.shutdownFunc );
+	if( !ctx ) {
 		return;
 	}
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_SHUTDOWN, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -508,14 +656,12 @@ static bool G_asInitializeGametypeScript( asIScriptModule *asModule ) {
 	// execute the GT_InitGametype function
 	//
 
-	ctx = game.asExport->asAcquireContext( GAME_AS_ENGINE() );
-
-	error = ctx->Prepare( static_cast<asIScriptFunction *>( level.gametype.initFunc ) );
-	if( error < 0 ) {
+	ctx = GT_asPrepareCallback( GT_CALLBACK_INIT, level.gametype.initFunc );
+	if( !ctx ) {
 		return false;
 	}
 
-	error = ctx->Execute();
+	error = GT_asExecuteCallback( GT_CALLBACK_INIT, ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		return false;
 	}
@@ -1364,6 +1364,7 @@ static asstring_t *objectGameEntity_getTargetname( edict_t *self ) {
 
 static void objectGameEntity_setTargetname( asstring_t *targetname, edict_t *self ) {
 	self->targetname = G_RegisterLevelString( targetname->buffer );
+	G_EdictIndex_Touch( self );
 }
 
 static asstring_t *objectGameEntity_getTarget( edict_t *self ) {
@@ -1384,6 +1385,7 @@ static asstring_t *objectGameEntity_getSoundName( edict_t *self ) {
 
 static void objectGameEntity_setClassname( asstring_t *classname, edict_t *self ) {
 	self->classname = G_RegisterLevelString( classname->buffer );
+	G_EdictIndex_Touch( self );
 }
 
 static void objectGameEntity_setMap( asstring_t *map, edict_t *self ) {
@@ -2839,6 +2841,8 @@ void G_asShutdownGameModuleEngine( void ) {
 		return;
 	}
 
+	GT_asReleaseCallbackContexts();
+
 	game.asExport->asReleaseEngine( static_cast<asIScriptEngine *>( game.asEngine ) );
 	G_ResetGameModuleScriptData();
 }
@@ -708,6 +708,8 @@ void G_RunFrame( unsigned int msec, int64_t serverTime ) {
 
 	G_CheckCvars();
 
+	G_EdictIndex_Settle();
+
 	game.localTime = time( NULL );
 	game.prevServerTime = game.serverTime;
 	game.serverTime = serverTime;
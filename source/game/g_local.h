@@ -400,6 +400,7 @@ extern cvar_t *g_instashield;
 
 extern cvar_t *g_asGC_stats;
 extern cvar_t *g_asGC_interval;
+extern cvar_t *g_asGT_budget;
 
 extern cvar_t *g_skillRating;
 
@@ -513,6 +514,8 @@ edict_t *GT_asCallSelectSpawnPoint( edict_t *ent );
 bool GT_asCallGameCommand( gclient_t *client, const char *cmd, const char *args, int argc );
 bool GT_asCallBotStatus( edict_t *ent );
 void GT_asCallShutdown( void );
+void GT_asReleaseCallbackContexts( void );
+void GT_asProfile_f( void );
 
 void G_asCallMapEntityThink( edict_t *ent );
 void G_asCallMapEntityTouch( edict_t *ent, edict_t *other, cplane_t *plane, int surfFlags );
@@ -640,10 +643,18 @@ void G_InitEdict( edict_t *e );
 edict_t *G_Spawn( void );
 void G_FreeEdict( edict_t *e );
 
+void G_EdictIndex_Init( void );
+void G_EdictIndex_Shutdown( void );
+void G_EdictIndex_Reset( void );
+void G_EdictIndex_Settle( void );
+void G_EdictIndex_Touch( edict_t *ent );
+
 void G_LevelInitPool( size_t size );
 void G_LevelFreePool( void );
 void *_G_LevelMalloc( size_t size, const char *filename, int fileline );
 void _G_LevelFree( void *data, const char *filename, int fileline );
+void *_G_LevelMallocStatic( size_t size, const char *filename, int fileline );
+void G_LevelMemStats_f( void );
 char *_G_LevelCopyString( const char *in, const char *filename, int fileline );
 void G_LevelGarbageCollect( void );
 
@@ -1019,6 +1030,7 @@ int G_BoxSlideMove( edict_t *ent, int contentmask, float slideBounce, float fric
 
 #define G_LevelMalloc( size ) _G_LevelMalloc( ( size ), __FILE__, __LINE__ )
 #define G_LevelFree( data ) _G_LevelFree( ( data ), __FILE__, __LINE__ )
+#define G_LevelMallocStatic( size ) _G_LevelMallocStatic( ( size ), __FILE__, __LINE__ )
 #define G_LevelCopyString( in ) _G_LevelCopyString( ( in ), __FILE__, __LINE__ )
 
 int G_API( void );
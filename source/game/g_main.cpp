@@ -106,6 +106,7 @@ cvar_t *g_allow_spectator_voting;
 
 cvar_t *g_asGC_stats;
 cvar_t *g_asGC_interval;
+cvar_t *g_asGT_budget;
 
 cvar_t *g_skillRating;
 
@@ -343,6 +344,7 @@ void G_Init( unsigned int seed, unsigned int framemsec, int protocol, const char
 
 	g_asGC_stats = trap_Cvar_Get( "g_asGC_stats", "0", CVAR_ARCHIVE );
 	g_asGC_interval = trap_Cvar_Get( "g_asGC_interval", "10", CVAR_ARCHIVE );
+	g_asGT_budget = trap_Cvar_Get( "g_asGT_budget", "2", CVAR_ARCHIVE );
 
 	g_skillRating = trap_Cvar_Get( "sv_skillRating", va( "%.0f", MM_RATING_DEFAULT ), CVAR_SERVERINFO | CVAR_READONLY );
 	// trap_Cvar_ForceSet( "sv_skillRating", va("%d", MM_RATING_DEFAULT) );
@@ -362,6 +364,8 @@ void G_Init( unsigned int seed, unsigned int framemsec, int protocol, const char
 
 	game.numentities = gs.maxclients + 1;
 
+	G_EdictIndex_Init();
+
 	trap_LocateEntities( game.edicts, sizeof( game.edicts[0] ), game.numentities, game.maxentities );
 
 	// server console commands
@@ -416,6 +420,8 @@ void G_Shutdown( void ) {
 
 	G_Free( game.edicts );
 	G_Free( game.clients );
+
+	G_EdictIndex_Shutdown();
 }
 
 //======================================================================
@@ -20,7 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // g_public.h -- game dll information visible to server
 
-#define GAME_API_VERSION    51
+#define GAME_API_VERSION    53
 
 //===============================================================
 
@@ -97,6 +97,13 @@ typedef struct {
 	int ( *SkinIndex )( const char *name );
 
 	int64_t ( *Milliseconds )( void );
+	uint64_t ( *Microseconds )( void );
+
+	// job system
+	int ( *Jobs_NumThreads )( void );
+	void ( *Jobs_Add )( qjobcounter_t *counter, qjobcounter_t *dependency, qjobfunc_t func, void *arg );
+	void ( *Jobs_ParallelFor )( qjobcounter_t *counter, unsigned items, unsigned grain, qjobrangefunc_t func, void *arg );
+	void ( *Jobs_Wait )( qjobcounter_t *counter );
 
 	bool ( *inPVS )( const vec3_t p1, const vec3_t p2 );
 
@@ -719,6 +719,8 @@ static void G_FreeEntities( void ) {
 	}
 
 	game.numentities = gs.maxclients + 1;
+
+	G_EdictIndex_Reset();
 }
 
 /*
@@ -866,14 +868,14 @@ void G_InitLevel( char *mapname, char *entities, int entstrlen, int64_t levelTim
 
 	// get the strings back
 	Q_strncpyz( level.mapname, name, sizeof( level.mapname ) );
-	level.mapString = ( char * )G_LevelMalloc( entstrlen + 1 );
+	level.mapString = ( char * )G_LevelMallocStatic( entstrlen + 1 );
 	level.mapStrlen = entstrlen;
 	memcpy( level.mapString, mapString, entstrlen );
 	G_Free( mapString );
 	mapString = NULL;
 
 	// make a copy of the raw entities string for parsing
-	level.map_parsed_ents = ( char * )G_LevelMalloc( entstrlen + 1 );
+	level.map_parsed_ents = ( char * )G_LevelMallocStatic( entstrlen + 1 );
 	level.map_parsed_ents[0] = 0;
 
 	level.skillLevel = (int)trap_Cvar_Value( "sv_skilllevel" );
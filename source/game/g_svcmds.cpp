@@ -382,11 +382,14 @@ void G_AddServerCommands( void ) {
 	trap_Cmd_AddCommand( "addbotroam", AITools_AddBotRoamNode_Cmd );
 
 	trap_Cmd_AddCommand( "dumpASapi", G_asDumpAPI_f );
+	trap_Cmd_AddCommand( "gtprofile", GT_asProfile_f );
 
 	trap_Cmd_AddCommand( "listratings", G_ListRatings_f );
 	trap_Cmd_AddCommand( "listraces", G_ListRaces_f );
 
 	trap_Cmd_AddCommand( "listlocations", Cmd_ListLocations_f );
+
+	trap_Cmd_AddCommand( "levelmem", G_LevelMemStats_f );
 }
 
 /*
@@ -417,9 +420,12 @@ void G_RemoveCommands( void ) {
 	trap_Cmd_RemoveCommand( "addbotroam" );
 
 	trap_Cmd_RemoveCommand( "dumpASapi" );
+	trap_Cmd_RemoveCommand( "gtprofile" );
 
 	trap_Cmd_RemoveCommand( "listratings" );
 	trap_Cmd_RemoveCommand( "listraces" );
 
 	trap_Cmd_RemoveCommand( "listlocations" );
+
+	trap_Cmd_RemoveCommand( "levelmem" );
 }
@@ -78,6 +78,26 @@ static inline int64_t trap_Milliseconds( void ) {
 	return GAME_IMPORT.Milliseconds();
 }
 
+static inline uint64_t trap_Microseconds( void ) {
+	return GAME_IMPORT.Microseconds();
+}
+
+static inline int trap_Jobs_NumThreads( void ) {
+	return GAME_IMPORT.Jobs_NumThreads();
+}
+
+static inline void trap_Jobs_Add( qjobcounter_t *counter, qjobcounter_t *dependency, qjobfunc_t func, void *arg ) {
+	GAME_IMPORT.Jobs_Add( counter, dependency, func, arg );
+}
+
+static inline void trap_Jobs_ParallelFor( qjobcounter_t *counter, unsigned items, unsigned grain, qjobrangefunc_t func, void *arg ) {
+	GAME_IMPORT.Jobs_ParallelFor( counter, items, grain, func, arg );
+}
+
+static inline void trap_Jobs_Wait( qjobcounter_t *counter ) {
+	GAME_IMPORT.Jobs_Wait( counter );
+}
+
 static inline bool trap_inPVS( const vec3_t p1, const vec3_t p2 ) {
 	return GAME_IMPORT.inPVS( p1, p2 ) == true;
 }
@@ -25,14 +25,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 /*
 ==============================================================================
 
-ZONE MEMORY ALLOCATION
+LEVEL MEMORY ALLOCATION
 
-There is never any space between memblocks, and there will never be two
-contiguous free memblocks.
+Blocks are rounded up to a number of size classes, each of which keeps its
+own list of freed blocks, so allocation and freeing never have to walk the
+pool. New blocks are carved from the bottom of the pool with a bump pointer.
+Blocks larger than the biggest size class are rounded up to whole pages and
+reused on a best fit basis.
 
-The rover can be left pointing at a non-empty block.
-
-Ported over from Quake 1 and Quake 3.
+Data which lives until the level is unloaded is carved from the top of the
+pool, without a header.
 ==============================================================================
 */
 
@@ -40,180 +42,253 @@ Ported over from Quake 1 and Quake 3.
 #define TAG_LEVEL   1
 
 #define ZONEID      0x1d4a11
-#define MINFRAGMENT 64
 
-typedef struct memblock_s
+#define LEVELMEM_ALIGN          16
+#define LEVELMEM_MAX_SMALL      8192
+#define LEVELMEM_LARGE_ALIGN    4096
+#define LEVELMEM_MAX_CLASSES    32
+
+typedef struct levelblock_s
 {
-	int size;               // including the header and possibly tiny fragments
-	int tag;                // a tag of 0 is a free block
-	struct memblock_s       *next, *prev;
+	int size;               // including the header and the trash tester
+	short sizeclass;        // -1 for large blocks
+	short tag;              // a tag of 0 is a free block
+	int used;               // bytes requested by the caller
 	int id;                 // should be ZONEID
-} memblock_t;
+} levelblock_t;
+
+typedef struct
+{
+	int size;
+	levelblock_t *freelist;
+	int numused, numfree;
+	int peakused;
+} levelsizeclass_t;
 
 typedef struct
 {
-	int size;           // total bytes malloced, including header
-	int count, used;
-	memblock_t blocklist;       // start / end cap for linked list
-	memblock_t  *rover;
-} memzone_t;
+	uint8_t *base;
+	size_t size;
+	size_t bump;            // blocks are carved upwards from the base
+	size_t top;             // level-lifetime data is carved downwards from the end
+	size_t highwater;
+
+	int count;
+	size_t requested, allocated;
+	size_t peakallocated;
+
+	int numclasses;
+	levelsizeclass_t classes[LEVELMEM_MAX_CLASSES];
+	uint8_t classforsize[LEVELMEM_MAX_SMALL / LEVELMEM_ALIGN + 1];
+
+	levelblock_t *largefree;
+	int numlargefree;
+	size_t largefreebytes;
+} levelpool_t;
 
-static memzone_t *levelzone;
+static levelpool_t *levelpool;
+
+#define LEVELMEM_NEXTFREE( block ) ( *(levelblock_t **)( (uint8_t *)( block ) + sizeof( levelblock_t ) ) )
 
 /*
-* G_Z_ClearZone
+* G_LevelPool_InitClasses
+*
+* Size classes go in steps of 16 bytes up to 128 bytes and
+* in quarters of a power of two after that.
 */
-static void G_Z_ClearZone( memzone_t *zone, int size ) {
-	memblock_t  *block;
+static void G_LevelPool_InitClasses( levelpool_t *pool ) {
+	int i, size, step = 16, c;
 
-	// set the entire zone to one free block
-	zone->blocklist.next = zone->blocklist.prev = block =
-													  (memblock_t *)( (uint8_t *)zone + sizeof( memzone_t ) );
-	zone->blocklist.tag = 1;    // in use block
-	zone->blocklist.id = 0;
-	zone->blocklist.size = 0;
-	zone->size = size;
-	zone->rover = block;
-	zone->used = 0;
-	zone->count = 0;
+	pool->numclasses = 0;
+	for( size = 32; size <= LEVELMEM_MAX_SMALL; size += step ) {
+		step = size < 128 ? 16 : Q_bitcount( size ) == 1 ? size / 4 : step;
+		pool->classes[pool->numclasses++].size = size;
+	}
 
-	block->prev = block->next = &zone->blocklist;
-	block->tag = 0;         // free block
-	block->id = ZONEID;
-	block->size = size - sizeof( memzone_t );
+	c = 0;
+	for( i = 0; i <= LEVELMEM_MAX_SMALL / LEVELMEM_ALIGN; i++ ) {
+		while( pool->classes[c].size < i * LEVELMEM_ALIGN ) {
+			c++;
+		}
+		pool->classforsize[i] = c;
+	}
 }
 
 /*
-* G_Z_Free
+* G_LevelPool_Carve
 */
-static void G_Z_Free( void *ptr, const char *filename, int fileline ) {
-	memblock_t *block, *other;
-	memzone_t *zone;
+static levelblock_t *G_LevelPool_Carve( levelpool_t *pool, size_t size ) {
+	levelblock_t *block;
 
-	if( !ptr ) {
-		G_Error( "G_Z_Free: NULL pointer" );
+	if( pool->bump + size > pool->top ) {
+		return NULL;
 	}
 
-	block = (memblock_t *) ( (uint8_t *)ptr - sizeof( memblock_t ) );
-	if( block->id != ZONEID ) {
-		G_Error( "G_Z_Free: freed a pointer without ZONEID (file %s at line %i)", filename, fileline );
+	block = (levelblock_t *)( pool->base + pool->bump );
+	pool->bump += size;
+	if( pool->bump + pool->size - pool->top > pool->highwater ) {
+		pool->highwater = pool->bump + pool->size - pool->top;
 	}
-	if( block->tag == 0 ) {
-		G_Error( "G_Z_Free: freed a freed pointer (file %s at line %i)", filename, fileline );
+
+	block->size = size;
+	return block;
+}
+
+/*
+* G_LevelPool_AllocLarge
+*/
+static levelblock_t *G_LevelPool_AllocLarge( levelpool_t *pool, size_t size ) {
+	levelblock_t *block, **prev, **best;
+
+	// pick the smallest free block which is big enough
+	best = NULL;
+	for( prev = &pool->largefree; *prev; prev = &LEVELMEM_NEXTFREE( *prev ) ) {
+		if( ( size_t )( *prev )->size >= size && ( !best || ( *prev )->size < ( *best )->size ) ) {
+			best = prev;
+		}
 	}
 
-	// check the memory trash tester
-	if( *(int *)( (uint8_t *)block + block->size - 4 ) != ZONEID ) {
-		G_Error( "G_Z_Free: memory block wrote past end" );
+	if( !best ) {
+		return G_LevelPool_Carve( pool, size );
 	}
 
-	zone = levelzone;
-	zone->used -= block->size;
-	zone->count--;
+	block = *best;
+	*best = LEVELMEM_NEXTFREE( block );
+	pool->numlargefree--;
+	pool->largefreebytes -= block->size;
 
-	block->tag = 0;     // mark as free
+	// give the remainder back to the free list
+	if( block->size - size > LEVELMEM_MAX_SMALL ) {
+		levelblock_t *rest = (levelblock_t *)( (uint8_t *)block + size );
+		rest->size = block->size - size;
+		rest->sizeclass = -1;
+		rest->tag = TAG_FREE;
+		rest->used = 0;
+		rest->id = ZONEID;
+		LEVELMEM_NEXTFREE( rest ) = pool->largefree;
+		pool->largefree = rest;
+		pool->numlargefree++;
+		pool->largefreebytes += rest->size;
 
-	other = block->prev;
-	if( !other->tag ) {
-		// merge with previous free block
-		other->size += block->size;
-		other->next = block->next;
-		other->next->prev = other;
-		if( block == zone->rover ) {
-			zone->rover = other;
-		}
-		block = other;
+		block->size = size;
 	}
 
-	other = block->next;
-	if( !other->tag ) {
-		// merge the next free block onto the end
-		block->size += other->size;
-		block->next = other->next;
-		block->next->prev = block;
-		if( other == zone->rover ) {
-			zone->rover = block;
-		}
-	}
+	return block;
 }
 
 /*
-* G_Z_TagMalloc
+* G_LevelPool_Malloc
 */
-static void *G_Z_TagMalloc( int size, int tag, const char *filename, int fileline ) {
-	int extra;
-	memblock_t *start, *rover, *newb, *base;
-	memzone_t *zone;
+static void *G_LevelPool_Malloc( size_t size, const char *filename, int fileline ) {
+	size_t blocksize;
+	int sizeclass;
+	levelblock_t *block;
+	levelsizeclass_t *sc;
+	levelpool_t *pool = levelpool;
 
-	if( !tag ) {
-		G_Error( "G_Z_TagMalloc: tried to use a 0 tag (file %s at line %i)", filename, fileline );
-	}
-
-	//
-	// scan through the block list looking for the first free block
-	// of sufficient size
-	//
-	size += sizeof( memblock_t ); // account for size of block header
-	size += 4;                  // space for memory trash tester
-	size = ( size + 3 ) & ~3;     // align to 32-bit boundary
+	blocksize = sizeof( levelblock_t ) + size + 4;  // space for memory trash tester
+	blocksize = ( blocksize + LEVELMEM_ALIGN - 1 ) & ~( LEVELMEM_ALIGN - 1 );
 
-	zone = levelzone;
-	base = rover = zone->rover;
-	start = base->prev;
+	if( blocksize <= LEVELMEM_MAX_SMALL ) {
+		sizeclass = pool->classforsize[blocksize / LEVELMEM_ALIGN];
+		sc = &pool->classes[sizeclass];
 
-	do {
-		if( rover == start ) {  // scaned all the way around the list
-			return NULL;
-		}
-		if( rover->tag ) {
-			base = rover = rover->next;
+		block = sc->freelist;
+		if( block ) {
+			sc->freelist = LEVELMEM_NEXTFREE( block );
+			sc->numfree--;
 		} else {
-			rover = rover->next;
+			block = G_LevelPool_Carve( pool, sc->size );
 		}
-	} while( base->tag || base->size < size );
 
-	//
-	// found a block big enough
-	//
-	extra = base->size - size;
-	if( extra > MINFRAGMENT ) {
-		// there will be a free fragment after the allocated block
-		newb = (memblock_t *) ( (uint8_t *)base + size );
-		newb->size = extra;
-		newb->tag = 0;          // free block
-		newb->prev = base;
-		newb->id = ZONEID;
-		newb->next = base->next;
-		newb->next->prev = newb;
-		base->next = newb;
-		base->size = size;
-	}
-
-	base->tag = tag;                // no longer a free block
-	zone->rover = base->next;   // next allocation will start looking here
-	zone->used += base->size;
-	zone->count++;
-	base->id = ZONEID;
+		if( block ) {
+			sc->numused++;
+			if( sc->numused > sc->peakused ) {
+				sc->peakused = sc->numused;
+			}
+		}
+	} else {
+		sizeclass = -1;
+		blocksize = ( blocksize + LEVELMEM_LARGE_ALIGN - 1 ) & ~( LEVELMEM_LARGE_ALIGN - 1 );
+		block = G_LevelPool_AllocLarge( pool, blocksize );
+	}
+
+	if( !block ) {
+		G_Error( "G_LevelMalloc: failed on allocation of %u bytes (file %s at line %i)",
+				 (unsigned)size, filename, fileline );
+		return NULL;
+	}
+
+	block->sizeclass = sizeclass;
+	block->tag = TAG_LEVEL;
+	block->used = size;
+	block->id = ZONEID;
 
 	// marker for memory trash testing
-	*(int *)( (uint8_t *)base + base->size - 4 ) = ZONEID;
+	*(int *)( (uint8_t *)block + block->size - 4 ) = ZONEID;
 
-	return (void *) ( (uint8_t *)base + sizeof( memblock_t ) );
+	pool->count++;
+	pool->requested += size;
+	pool->allocated += block->size;
+	if( pool->allocated > pool->peakallocated ) {
+		pool->peakallocated = pool->allocated;
+	}
+
+	memset( block + 1, 0, size );
+	return (void *)( block + 1 );
 }
 
 /*
-* G_Z_Malloc
+* G_LevelPool_Free
 */
-static void *G_Z_Malloc( int size, const char *filename, int fileline ) {
-	void    *buf;
+static void G_LevelPool_Free( void *ptr, const char *filename, int fileline ) {
+	levelblock_t *block;
+	levelsizeclass_t *sc;
+	levelpool_t *pool = levelpool;
 
-	buf = G_Z_TagMalloc( size, TAG_LEVEL, filename, fileline );
-	if( !buf ) {
-		G_Error( "G_Z_Malloc: failed on allocation of %i bytes", size );
+	if( !ptr ) {
+		G_Error( "G_LevelFree: NULL pointer" );
 	}
-	memset( buf, 0, size );
 
-	return buf;
+	block = (levelblock_t *)( (uint8_t *)ptr - sizeof( levelblock_t ) );
+	if( block->id != ZONEID ) {
+		G_Error( "G_LevelFree: freed a pointer without ZONEID (file %s at line %i)", filename, fileline );
+	}
+	if( block->tag == TAG_FREE ) {
+		G_Error( "G_LevelFree: freed a freed pointer (file %s at line %i)", filename, fileline );
+	}
+
+	// check the memory trash tester
+	if( *(int *)( (uint8_t *)block + block->size - 4 ) != ZONEID ) {
+		G_Error( "G_LevelFree: memory block wrote past end (file %s at line %i)", filename, fileline );
+	}
+
+	pool->count--;
+	pool->requested -= block->used;
+	pool->allocated -= block->size;
+
+	block->tag = TAG_FREE;
+	block->used = 0;
+
+	if( block->sizeclass >= 0 ) {
+		sc = &pool->classes[block->sizeclass];
+		LEVELMEM_NEXTFREE( block ) = sc->freelist;
+		sc->freelist = block;
+		sc->numused--;
+		sc->numfree++;
+		return;
+	}
+
+	// the last carved block simply goes back to the bump pointer
+	if( (uint8_t *)block + block->size == pool->base + pool->bump ) {
+		pool->bump -= block->size;
+		return;
+	}
+
+	LEVELMEM_NEXTFREE( block ) = pool->largefree;
+	pool->largefree = block;
+	pool->numlargefree++;
+	pool->largefreebytes += block->size;
 }
 
 //==============================================================================
@@ -222,19 +297,31 @@ static void *G_Z_Malloc( int size, const char *filename, int fileline ) {
 * G_LevelInitPool
 */
 void G_LevelInitPool( size_t size ) {
+	levelpool_t *pool;
+
 	G_LevelFreePool();
 
-	levelzone = ( memzone_t * )G_Malloc( size );
-	G_Z_ClearZone( levelzone, size );
+	size = ( size + LEVELMEM_LARGE_ALIGN - 1 ) & ~( LEVELMEM_LARGE_ALIGN - 1 );
+
+	pool = ( levelpool_t * )G_Malloc( sizeof( levelpool_t ) + size + LEVELMEM_ALIGN );
+	memset( pool, 0, sizeof( *pool ) );
+	pool->base = ( uint8_t * )( ( ( uintptr_t )( pool + 1 ) + LEVELMEM_ALIGN - 1 ) & ~( uintptr_t )( LEVELMEM_ALIGN - 1 ) );
+	pool->size = size;
+	pool->bump = 0;
+	pool->top = size;
+
+	G_LevelPool_InitClasses( pool );
+
+	levelpool = pool;
 }
 
 /*
 * G_LevelFreePool
 */
 void G_LevelFreePool( void ) {
-	if( levelzone ) {
-		G_Free( levelzone );
-		levelzone = NULL;
+	if( levelpool ) {
+		G_Free( levelpool );
+		levelpool = NULL;
 	}
 }
 
@@ -242,14 +329,81 @@ void G_LevelFreePool( void ) {
 * G_LevelMalloc
 */
 void *_G_LevelMalloc( size_t size, const char *filename, int fileline ) {
-	return G_Z_Malloc( size, filename, fileline );
+	return G_LevelPool_Malloc( size, filename, fileline );
 }
 
 /*
 * G_LevelFree
 */
 void _G_LevelFree( void *data, const char *filename, int fileline ) {
-	G_Z_Free( data, filename, fileline );
+	G_LevelPool_Free( data, filename, fileline );
+}
+
+/*
+* G_LevelMallocStatic
+*
+* Allocates memory which stays around until the level is unloaded.
+* It can't be passed to G_LevelFree.
+*/
+void *_G_LevelMallocStatic( size_t size, const char *filename, int fileline ) {
+	levelpool_t *pool = levelpool;
+
+	size = ( size + LEVELMEM_ALIGN - 1 ) & ~( LEVELMEM_ALIGN - 1 );
+	if( pool->top - pool->bump < size ) {
+		G_Error( "G_LevelMallocStatic: failed on allocation of %u bytes (file %s at line %i)",
+				 (unsigned)size, filename, fileline );
+		return NULL;
+	}
+
+	pool->top -= size;
+	if( pool->bump + pool->size - pool->top > pool->highwater ) {
+		pool->highwater = pool->bump + pool->size - pool->top;
+	}
+
+	memset( pool->base + pool->top, 0, size );
+	return pool->base + pool->top;
+}
+
+/*
+* G_LevelMemStats_f
+*/
+void G_LevelMemStats_f( void ) {
+	int i;
+	size_t freebytes;
+	levelpool_t *pool = levelpool;
+
+	if( !pool ) {
+		G_Printf( "Level pool is not initialized\n" );
+		return;
+	}
+
+	freebytes = pool->largefreebytes;
+	for( i = 0; i < pool->numclasses; i++ ) {
+		freebytes += (size_t)pool->classes[i].size * pool->classes[i].numfree;
+	}
+
+	G_Printf( "size class     used     free     peak\n" );
+	for( i = 0; i < pool->numclasses; i++ ) {
+		const levelsizeclass_t *sc = &pool->classes[i];
+		if( !sc->peakused ) {
+			continue;
+		}
+		G_Printf( "%10i %8i %8i %8i\n", sc->size, sc->numused, sc->numfree, sc->peakused );
+	}
+	G_Printf( "%10s %8s %8i\n", "large", "", pool->numlargefree );
+	G_Printf( "\n" );
+
+	G_Printf( "pool:       %8u KiB\n", (unsigned)( pool->size / 1024 ) );
+	G_Printf( "static:     %8u KiB\n", (unsigned)( ( pool->size - pool->top ) / 1024 ) );
+	G_Printf( "carved:     %8u KiB\n", (unsigned)( pool->bump / 1024 ) );
+	G_Printf( "untouched:  %8u KiB\n", (unsigned)( ( pool->top - pool->bump ) / 1024 ) );
+	G_Printf( "high-water: %8u KiB\n", (unsigned)( pool->highwater / 1024 ) );
+	G_Printf( "in use:     %8u KiB in %i blocks, %u KiB requested, peak %u KiB\n",
+			  (unsigned)( pool->allocated / 1024 ), pool->count, (unsigned)( pool->requested / 1024 ),
+			  (unsigned)( pool->peakallocated / 1024 ) );
+	G_Printf( "fragmentation: %.1f%% internal, %.1f%% external (%u KiB in free lists)\n",
+			  pool->allocated ? 100.0 * ( pool->allocated - pool->requested ) / pool->allocated : 0.0,
+			  pool->bump ? 100.0 * freebytes / pool->bump : 0.0, (unsigned)( freebytes / 1024 ) );
 }
 
 /*
@@ -267,7 +421,6 @@ char *_G_LevelCopyString( const char *in, const char *filename, int fileline ) {
 * G_LevelGarbageCollect
 */
 void G_LevelGarbageCollect( void ) {
-	//G_Z_Print( levelzone );
 }
 
 //==============================================================================
@@ -292,7 +445,7 @@ static g_poolstring_t *g_stringpool_hash[STRINGPOOL_HASH_SIZE];
 void G_StringPoolInit( void ) {
 	memset( g_stringpool_hash, 0, sizeof( g_stringpool_hash ) );
 
-	g_stringpool = ( uint8_t * )G_LevelMalloc( STRINGPOOL_SIZE );
+	g_stringpool = ( uint8_t * )G_LevelMallocStatic( STRINGPOOL_SIZE );
 	g_stringpool_offset = 0;
 }
 
@@ -462,6 +615,341 @@ void G_ProjectSource( vec3_t point, vec3_t distance, vec3_t forward, vec3_t righ
 }
 
 
+//==============================================================================
+//
+//EDICT INDEX
+//
+//==============================================================================
+
+// Freed edicts are kept in a list ordered by freetime, so G_Spawn only has to
+// look at its head to apply the reuse policy. classname and targetname are
+// hashed, so lookups by those fields don't have to walk all edicts.
+//
+// Names are assigned directly all over the place, so the name index is
+// reconciled lazily: edicts initialized during the current frame, edicts
+// touched with G_EdictIndex_Touch and the world and client edicts are checked
+// for changes on each lookup.
+
+#define EDICTINDEX_HASH_SIZE    256
+
+enum {
+	EDICTNAME_CLASSNAME,
+	EDICTNAME_TARGETNAME,
+
+	EDICTNAME_TOTAL
+};
+
+typedef struct {
+	const char *name[EDICTNAME_TOTAL];  // names as indexed, NULL if not in the index
+	unsigned int hashkey[EDICTNAME_TOTAL];
+	int hashprev[EDICTNAME_TOTAL], hashnext[EDICTNAME_TOTAL];
+
+	int freeprev, freenext;
+	bool isfree;
+	bool touched;
+} g_edictindex_t;
+
+static g_edictindex_t *g_edictindex;
+static int g_edicthash[EDICTNAME_TOTAL][EDICTINDEX_HASH_SIZE];
+static int g_freehead, g_freetail;
+static int *g_touched;
+static int g_numtouched;
+
+/*
+* G_EdictIndex_Init
+*/
+void G_EdictIndex_Init( void ) {
+	g_edictindex = ( g_edictindex_t * )G_Malloc( game.maxentities * sizeof( *g_edictindex ) );
+	g_touched = ( int * )G_Malloc( game.maxentities * sizeof( *g_touched ) );
+	G_EdictIndex_Reset();
+}
+
+/*
+* G_EdictIndex_Shutdown
+*/
+void G_EdictIndex_Shutdown( void ) {
+	G_Free( g_edictindex );
+	G_Free( g_touched );
+	g_edictindex = NULL;
+	g_touched = NULL;
+}
+
+/*
+* G_EdictIndex_Reset
+*
+* Must be called whenever game.numentities is reset
+*/
+void G_EdictIndex_Reset( void ) {
+	int i, j;
+
+	for( i = 0; i < game.maxentities; i++ ) {
+		g_edictindex_t *idx = &g_edictindex[i];
+		for( j = 0; j < EDICTNAME_TOTAL; j++ ) {
+			idx->name[j] = NULL;
+			idx->hashprev[j] = idx->hashnext[j] = -1;
+		}
+		idx->freeprev = idx->freenext = -1;
+		idx->isfree = false;
+		idx->touched = false;
+	}
+
+	for( j = 0; j < EDICTNAME_TOTAL; j++ ) {
+		for( i = 0; i < EDICTINDEX_HASH_SIZE; i++ ) {
+			g_edicthash[j][i] = -1;
+		}
+	}
+
+	g_freehead = g_freetail = -1;
+	g_numtouched = 0;
+}
+
+/*
+* G_EdictIndex_HashKey
+*/
+static unsigned int G_EdictIndex_HashKey( const char *name ) {
+	unsigned int v = 0;
+
+	for( ; *name; name++ ) {
+		v = v * 37 + tolower( *name );
+	}
+
+	return v & ( EDICTINDEX_HASH_SIZE - 1 );
+}
+
+/*
+* G_EdictIndex_NameField
+*/
+static const char *G_EdictIndex_NameField( const edict_t *ent, int field ) {
+	if( !ent->r.inuse ) {
+		return NULL;
+	}
+	return field == EDICTNAME_CLASSNAME ? ent->classname : ent->targetname;
+}
+
+/*
+* G_EdictIndex_UnlinkName
+*/
+static void G_EdictIndex_UnlinkName( int num, int field ) {
+	g_edictindex_t *idx = &g_edictindex[num];
+	int prev = idx->hashprev[field], next = idx->hashnext[field];
+
+	if( !idx->name[field] ) {
+		return;
+	}
+
+	if( prev >= 0 ) {
+		g_edictindex[prev].hashnext[field] = next;
+	} else {
+		g_edicthash[field][idx->hashkey[field]] = next;
+	}
+	if( next >= 0 ) {
+		g_edictindex[next].hashprev[field] = prev;
+	}
+
+	idx->name[field] = NULL;
+	idx->hashprev[field] = idx->hashnext[field] = -1;
+}
+
+/*
+* G_EdictIndex_LinkName
+*
+* Hash chains are kept sorted by entity number so lookups return
+* edicts in the same order as a linear scan would.
+*/
+static void G_EdictIndex_LinkName( int num, int field, const char *name ) {
+	g_edictindex_t *idx = &g_edictindex[num];
+	unsigned int hashkey = G_EdictIndex_HashKey( name );
+	int prev, next;
+
+	prev = -1;
+	next = g_edicthash[field][hashkey];
+	while( next >= 0 && next < num ) {
+		prev = next;
+		next = g_edictindex[next].hashnext[field];
+	}
+
+	idx->name[field] = name;
+	idx->hashkey[field] = hashkey;
+	idx->hashprev[field] = prev;
+	idx->hashnext[field] = next;
+
+	if( prev >= 0 ) {
+		g_edictindex[prev].hashnext[field] = num;
+	} else {
+		g_edicthash[field][hashkey] = num;
+	}
+	if( next >= 0 ) {
+		g_edictindex[next].hashprev[field] = num;
+	}
+}
+
+/*
+* G_EdictIndex_UpdateNames
+*/
+static void G_EdictIndex_UpdateNames( int num ) {
+	int field;
+	const char *name;
+
+	for( field = 0; field < EDICTNAME_TOTAL; field++ ) {
+		name = G_EdictIndex_NameField( &game.edicts[num], field );
+		if( name == g_edictindex[num].name[field] ) {
+			continue;
+		}
+
+		G_EdictIndex_UnlinkName( num, field );
+		if( name && *name ) {
+			G_EdictIndex_LinkName( num, field, name );
+		}
+	}
+}
+
+/*
+* G_EdictIndex_Sync
+*/
+static void G_EdictIndex_Sync( void ) {
+	int i;
+
+	for( i = 0; i <= gs.maxclients && i < game.numentities; i++ ) {
+		G_EdictIndex_UpdateNames( i );
+	}
+	for( i = 0; i < g_numtouched; i++ ) {
+		G_EdictIndex_UpdateNames( g_touched[i] );
+	}
+}
+
+/*
+* G_EdictIndex_Touch
+*
+* Schedules the edict names to be reindexed. Only needed when changing
+* classname or targetname of an edict which wasn't initialized this frame.
+*/
+void G_EdictIndex_Touch( edict_t *ent ) {
+	int num = ENTNUM( ent );
+
+	if( g_edictindex[num].touched ) {
+		return;
+	}
+
+	g_edictindex[num].touched = true;
+	g_touched[g_numtouched++] = num;
+}
+
+/*
+* G_EdictIndex_Settle
+*
+* Called once per frame to bring the name index up to date and
+* stop checking the edicts touched during the previous frame.
+*/
+void G_EdictIndex_Settle( void ) {
+	int i;
+
+	G_EdictIndex_Sync();
+
+	for( i = 0; i < g_numtouched; i++ ) {
+		g_edictindex[g_touched[i]].touched = false;
+	}
+	g_numtouched = 0;
+}
+
+/*
+* G_EdictIndex_RemoveEdict
+*/
+static void G_EdictIndex_RemoveEdict( int num ) {
+	int field;
+
+	for( field = 0; field < EDICTNAME_TOTAL; field++ ) {
+		G_EdictIndex_UnlinkName( num, field );
+	}
+}
+
+/*
+* G_EdictIndex_Find
+*/
+static edict_t *G_EdictIndex_Find( edict_t *from, int field, const char *match ) {
+	int num, fromnum;
+	unsigned int hashkey;
+	const char *s;
+	edict_t *ent;
+
+	G_EdictIndex_Sync();
+
+	hashkey = G_EdictIndex_HashKey( match );
+
+	fromnum = from ? ENTNUM( from ) : -1;
+	if( fromnum >= 0 && g_edictindex[fromnum].name[field] && g_edictindex[fromnum].hashkey[field] == hashkey ) {
+		num = g_edictindex[fromnum].hashnext[field];
+	} else {
+		num = g_edicthash[field][hashkey];
+		while( num >= 0 && num <= fromnum ) {
+			num = g_edictindex[num].hashnext[field];
+		}
+	}
+
+	// the chain may hold other names with the same hash key
+	for( ; num >= 0; num = g_edictindex[num].hashnext[field] ) {
+		ent = &game.edicts[num];
+		s = G_EdictIndex_NameField( ent, field );
+		if( s && !Q_stricmp( s, match ) ) {
+			return ent;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* G_EdictIndex_UnlinkFree
+*/
+static void G_EdictIndex_UnlinkFree( int num ) {
+	g_edictindex_t *idx = &g_edictindex[num];
+
+	if( !idx->isfree ) {
+		return;
+	}
+
+	if( idx->freeprev >= 0 ) {
+		g_edictindex[idx->freeprev].freenext = idx->freenext;
+	} else {
+		g_freehead = idx->freenext;
+	}
+	if( idx->freenext >= 0 ) {
+		g_edictindex[idx->freenext].freeprev = idx->freeprev;
+	} else {
+		g_freetail = idx->freeprev;
+	}
+
+	idx->isfree = false;
+	idx->freeprev = idx->freenext = -1;
+}
+
+/*
+* G_EdictIndex_LinkFree
+*
+* Edicts which can be reused immediately go to the head of the list,
+* the rest to the tail, which keeps the list sorted by freetime.
+*/
+static void G_EdictIndex_LinkFree( int num ) {
+	g_edictindex_t *idx = &g_edictindex[num];
+
+	if( game.edicts[num].freetime == 0 || g_freehead < 0 ) {
+		idx->freeprev = -1;
+		idx->freenext = g_freehead;
+		if( g_freehead >= 0 ) {
+			g_edictindex[g_freehead].freeprev = num;
+		} else {
+			g_freetail = num;
+		}
+		g_freehead = num;
+	} else {
+		idx->freeprev = g_freetail;
+		idx->freenext = -1;
+		g_edictindex[g_freetail].freenext = num;
+		g_freetail = num;
+	}
+
+	idx->isfree = true;
+}
+
 /*
 * G_Find
 *
@@ -471,10 +959,18 @@ void G_ProjectSource( vec3_t point, vec3_t distance, vec3_t forward, vec3_t righ
 * Searches beginning at the edict after from, or the beginning if NULL
 * NULL will be returned if the end of the list is reached.
 *
+* Lookups by classname and targetname go through the edict index.
 */
 edict_t *G_Find( edict_t *from, size_t fieldofs, const char *match ) {
 	char *s;
 
+	if( fieldofs == FOFS( classname ) ) {
+		return G_EdictIndex_Find( from, EDICTNAME_CLASSNAME, match );
+	}
+	if( fieldofs == FOFS( targetname ) ) {
+		return G_EdictIndex_Find( from, EDICTNAME_TARGETNAME, match );
+	}
+
 	if( !from ) {
 		from = world;
 	} else {
@@ -708,6 +1204,8 @@ void G_FreeEdict( edict_t *ed ) {
 
 	G_asReleaseEntityBehaviors( ed );
 
+	G_EdictIndex_RemoveEdict( ENTNUM( ed ) );
+
 	memset( ed, 0, sizeof( *ed ) );
 	ed->r.inuse = false;
 	ed->s.number = ENTNUM( ed );
@@ -717,6 +1215,11 @@ void G_FreeEdict( edict_t *ed ) {
 	if( !evt && ( level.spawnedTimeStamp != game.realtime ) ) {
 		ed->freetime = game.realtime; // ET_EVENT or ET_SOUND don't need to wait to be reused
 	}
+
+	if( ENTNUM( ed ) > gs.maxclients && ENTNUM( ed ) < game.numentities ) {
+		G_EdictIndex_UnlinkFree( ENTNUM( ed ) );
+		G_EdictIndex_LinkFree( ENTNUM( ed ) );
+	}
 }
 
 /*
@@ -746,6 +1249,9 @@ void G_InitEdict( edict_t *e ) {
 
 	//wsw clean up the backpack counts
 	memset( e->invpak, 0, sizeof( e->invpak ) );
+
+	G_EdictIndex_UnlinkFree( ENTNUM( e ) );
+	G_EdictIndex_Touch( e );
 }
 
 /*
@@ -756,37 +1262,29 @@ void G_InitEdict( edict_t *e ) {
 * can cause the client to think the entity morphed into something else
 * instead of being removed and recreated, which can cause interpolated
 * angles and bad trails.
+*
+* The free list is sorted by freetime, so only its head needs to be checked.
 */
 edict_t *G_Spawn( void ) {
-	int i;
 	edict_t *e, *freed;
 
 	if( !level.canSpawnEntities ) {
 		G_Printf( "WARNING: Spawning entity before map entities have been spawned\n" );
 	}
 
-	freed = NULL;
-	e = &game.edicts[gs.maxclients + 1];
-	for( i = gs.maxclients + 1; i < game.numentities; i++, e++ ) {
-		if( e->r.inuse ) {
-			continue;
-		}
-
+	freed = g_freehead >= 0 ? &game.edicts[g_freehead] : NULL;
+	if( freed ) {
 		// the first couple seconds of server time can involve a lot of
 		// freeing and allocating, so relax the replacement policy
-		if( e->freetime < level.spawnedTimeStamp + 2000 || game.realtime > e->freetime + 500 ) {
-			G_InitEdict( e );
-			return e;
+		if( freed->freetime < level.spawnedTimeStamp + 2000 || game.realtime > freed->freetime + 500 ) {
+			G_InitEdict( freed );
+			return freed;
 		}
+	}
 
+	if( game.numentities == game.maxentities ) {
 		// this is going to be our second chance to spawn an entity in case all free
 		// entities have been freed only recently
-		if( !freed ) {
-			freed = e;
-		}
-	}
-
-	if( i == game.maxentities ) {
 		if( freed ) {
 			G_InitEdict( freed );
 			return freed;
@@ -794,6 +1292,7 @@ edict_t *G_Spawn( void ) {
 		G_Error( "G_Spawn: no free edicts" );
 	}
 
+	e = &game.edicts[game.numentities];
 	game.numentities++;
 
 	trap_LocateEntities( game.edicts, sizeof( game.edicts[0] ), game.numentities, game.maxentities );
@@ -44,6 +44,27 @@ void G_UpdateScoreBoardMessages( void ) {
 	char command[MAX_STRING_CHARS];
 	size_t maxlen, staticlen;
 
+	// don't build the scoreboard if no one is going to receive it this frame
+	if( nexttime - game.snapFrameTime > 0 ) {
+		for( i = 0; i < gs.maxclients; i++ ) {
+			ent = game.edicts + 1 + i;
+			if( !ent->r.inuse || !ent->r.client ) {
+				continue;
+			}
+			if( game.realtime <= ent->r.client->level.scoreboard_time + scoreboardInterval ) {
+				continue;
+			}
+			if( ent->r.client->ps.stats[STAT_LAYOUTS] & STAT_LAYOUT_SCOREBOARD ) {
+				break;
+			}
+		}
+
+		if( i == gs.maxclients ) {
+			nexttime -= game.snapFrameTime;
+			return;
+		}
+	}
+
 	// fixme : mess of copying
 	maxlen = MAX_STRING_CHARS - ( strlen( "scb \"\"" + 4 ) );
 
@@ -128,12 +128,14 @@ typedef struct angelwrap_api_s {
 	// engine
 	asIScriptEngine *( *asCreateEngine )( bool *asMaxPortability );
 	void ( *asReleaseEngine )( asIScriptEngine *engine );
+	void ( *asFinalizeJIT )( asIScriptEngine *engine );
 	void ( *asWriteEngineDocsToFile )( asIScriptEngine *engine, const char *path, bool markdown, bool singleFile, unsigned andMask, unsigned notMask );
 
 	// context
 	asIScriptContext *( *asAcquireContext )( asIScriptEngine * engine );
 	void ( *asReleaseContext )( asIScriptContext *context );
 	asIScriptContext *( *asGetActiveContext )( void );
+	asIScriptContext *( *asCreateUnmanagedContext )( asIScriptEngine * engine );
 
 	// strings
 	asstring_t *( *asStringFactoryBuffer )( const char *buffer, unsigned int length );
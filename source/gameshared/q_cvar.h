@@ -58,6 +58,7 @@ typedef struct cvar_s {
 	bool modified;          // set each time the cvar is changed
 	float value;
 	int integer;
+	volatile int sequence;      // odd while the values are being changed
 } cvar_t;
 
 #ifdef __cplusplus
@@ -406,6 +406,25 @@ typedef enum {
 // equals to INFINITE on Windows and SDL_MUTEX_MAXWAIT
 #define Q_THREADS_WAIT_INFINITE 0xFFFFFFFF
 
+// job system, see qcommon/jobs.c
+typedef void ( *qjobfunc_t )( void *arg );
+typedef void ( *qjobrangefunc_t )( unsigned first, unsigned count, void *arg );
+
+// counts unfinished jobs, jobs may be set to wait on a counter to reach zero
+typedef struct qjobcounter_s {
+	volatile int pending;
+	struct qjobwaiter_s *waiters;
+} qjobcounter_t;
+
+// CPU features, see COM_CPUFeatures
+#define QCPU_HAS_RDTSC      0x00000001
+#define QCPU_HAS_MMX        0x00000002
+#define QCPU_HAS_MMXEXT     0x00000004
+#define QCPU_HAS_3DNOW      0x00000010
+#define QCPU_HAS_3DNOWEXT   0x00000020
+#define QCPU_HAS_SSE        0x00000040
+#define QCPU_HAS_SSE2       0x00000080
+
 //==============================================================
 
 // connection state of the client in the server
@@ -114,6 +114,9 @@ struct cmodel_state_s {
 	struct cmodel_state_s *parent;
 	struct mempool_s *mempool;
 
+	bool ownareas;                  // instance of a shared map with private area portal state
+	struct cmodel_state_s *nextshared;
+
 	const bspFormatDesc_t *cmap_bspFormat;
 
 	char map_name[MAX_CONFIGSTRING_CHARS];
@@ -163,10 +166,10 @@ struct cmodel_state_s {
 	carea_t *map_areas;             // = &map_area_empty;
 	int *map_areaportals;
 
-	dvis_t *map_pvs, *map_phs;
+	dvis_t *map_pvs, *map_phs;      // rowsize is always a multiple of 8 bytes, see CM_ClusterRowWords
 	int map_visdatasize;
 
-	uint8_t nullrow[MAX_CM_LEAFS / 8];
+	uint64_t nullrow[MAX_CM_LEAFS / 64];
 
 	int numentitychars;
 	char map_entitystring_empty;
@@ -211,6 +214,8 @@ struct cmodel_state_s {
 
 //=======================================================================
 
+extern cvar_t *cm_mapCache;
+
 void    CM_InitBoxHull( cmodel_state_t *cms );
 void    CM_InitOctagonHull( cmodel_state_t *cms );
 
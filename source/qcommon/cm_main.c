@@ -29,6 +29,7 @@ static mempool_t *cmap_mempool;
 
 static cvar_t *cm_noAreas;
 cvar_t *cm_noCurves;
+cvar_t *cm_mapCache;
 
 void CM_LoadQ2BrushModel( cmodel_state_t *cms, void *parent, void *buf, bspFormatDesc_t *format );
 void CM_LoadQ1BrushModel( cmodel_state_t *cms, void *parent, void *buffer, bspFormatDesc_t *format );
@@ -226,6 +227,11 @@ cmodel_t *CM_LoadMap( cmodel_state_t *cms, const char *name, bool clientload, un
 	assert( name && strlen( name ) < MAX_CONFIGSTRING_CHARS );
 	assert( checksum );
 
+	if( cms->parent ) {
+		Com_Error( ERR_FATAL, "CM_LoadMap: tried to load a map into a shared model" );
+		return NULL;
+	}
+
 	if( name && !strcmp( cms->map_name, name ) && ( clientload || !Cvar_Value( "flushmap" ) ) ) {
 		*checksum = cms->checksum;
 
@@ -290,7 +296,7 @@ cmodel_t *CM_LoadMap( cmodel_state_t *cms, const char *name, bool clientload, un
 
 	CM_AllocateCheckCounts( cms );
 
-	memset( cms->nullrow, 255, MAX_CM_LEAFS / 8 );
+	memset( cms->nullrow, 255, sizeof( cms->nullrow ) );
 
 	Q_strncpyz( cms->map_name, name, sizeof( cms->map_name ) );
 
@@ -531,10 +537,14 @@ int CM_ClusterRowSize( cmodel_state_t *cms ) {
 }
 
 /*
-* CM_ClusterRowLongs
+* CM_ClusterRowWords
+*
+* Returns the number of 64-bit words in a cluster visibility row. The BSP loaders pad
+* the rows of the decompressed PVS to a multiple of 8 bytes, and buffers for merging
+* are expected to be at least CM_ClusterRowSize bytes and 8-byte aligned.
 */
-static int CM_ClusterRowLongs( cmodel_state_t *cms ) {
-	return cms->map_pvs ? ( cms->map_pvs->rowsize + 3 ) / 4 : MAX_CM_LEAFS / 32;
+static int CM_ClusterRowWords( cmodel_state_t *cms ) {
+	return cms->map_pvs ? cms->map_pvs->rowsize / 8 : MAX_CM_LEAFS / 64;
 }
 
 /*
@@ -554,20 +564,39 @@ dvis_t *CM_PVSData( cmodel_state_t *cms ) {
 /*
 * CM_ClusterVS
 */
-static inline uint8_t *CM_ClusterVS( int cluster, dvis_t *vis, uint8_t *nullrow ) {
+static inline const uint8_t *CM_ClusterVS( int cluster, const dvis_t *vis, const uint64_t *nullrow ) {
 	if( cluster == -1 || !vis ) {
-		return nullrow;
+		return ( const uint8_t * )nullrow;
 	}
-	return ( uint8_t * )vis->data + cluster * vis->rowsize;
+	return ( const uint8_t * )vis->data + cluster * vis->rowsize;
 }
 
 /*
 * CM_ClusterPVS
+*
+* Returns the decompressed PVS row of the cluster, CM_ClusterRowSize bytes long
 */
-static inline uint8_t *CM_ClusterPVS( cmodel_state_t *cms, int cluster ) {
+const uint8_t *CM_ClusterPVS( cmodel_state_t *cms, int cluster ) {
 	return CM_ClusterVS( cluster, cms->map_pvs, cms->nullrow );
 }
 
+/*
+* CM_ClusterInPVS
+*
+* Returns true if cluster2 is potentially visible from cluster1. Clusters outside
+* of the map (-1) see and are seen from everywhere.
+*/
+bool CM_ClusterInPVS( cmodel_state_t *cms, int cluster1, int cluster2 ) {
+	const uint8_t *row;
+
+	if( cluster1 == -1 || cluster2 == -1 || !cms->map_pvs ) {
+		return true;
+	}
+
+	row = CM_ClusterPVS( cms, cluster1 );
+	return ( row[cluster2 >> 3] & ( 1 << ( cluster2 & 7 ) ) ) != 0;
+}
+
 /*
 * CM_NumAreas
 */
@@ -829,8 +858,9 @@ bool CM_HeadnodeVisible( cmodel_state_t *cms, int nodenum, uint8_t *visbits ) {
 void CM_MergePVS( cmodel_state_t *cms, const vec3_t org, uint8_t *out ) {
 	int leafs[128];
 	int i, j, count;
-	int longs;
-	uint8_t *src;
+	int words;
+	const uint64_t *src;
+	uint64_t *dest = ( uint64_t * )out;
 	vec3_t mins, maxs;
 
 	for( i = 0; i < 3; i++ ) {
@@ -842,7 +872,7 @@ void CM_MergePVS( cmodel_state_t *cms, const vec3_t org, uint8_t *out ) {
 	if( count < 1 ) {
 		Com_Error( ERR_FATAL, "CM_MergePVS: count < 1" );
 	}
-	longs = CM_ClusterRowLongs( cms );
+	words = CM_ClusterRowWords( cms );
 
 	// convert leafs to clusters
 	for( i = 0; i < count; i++ )
@@ -857,12 +887,22 @@ void CM_MergePVS( cmodel_state_t *cms, const vec3_t org, uint8_t *out ) {
 		if( j != i ) {
 			continue; // already have the cluster we want
 		}
-		src = CM_ClusterPVS( cms, leafs[i] );
-		for( j = 0; j < longs; j++ )
-			( (int *)out )[j] |= ( (int *)src )[j];
+		src = ( const uint64_t * )CM_ClusterPVS( cms, leafs[i] );
+		for( j = 0; j < words; j++ )
+			dest[j] |= src[j];
 	}
 }
 
+/*
+* CM_FatPVS
+*
+* Same as CM_MergePVS, but overwrites out instead of merging into it
+*/
+void CM_FatPVS( cmodel_state_t *cms, const vec3_t org, uint8_t *out ) {
+	memset( out, 0, CM_ClusterRowSize( cms ) );
+	CM_MergePVS( cms, org, out );
+}
+
 /*
 * CM_MergeVisSets
 */
@@ -892,23 +932,18 @@ int CM_MergeVisSets( cmodel_state_t *cms, const vec3_t org, uint8_t *pvs, uint8_
 */
 bool CM_InPVS( cmodel_state_t *cms, const vec3_t p1, const vec3_t p2 ) {
 	int leafnum1, leafnum2;
-	int		 cluster;
-	int		 area1, area2;
-	uint8_t *mask;
+	int area1, area2;
 
 	leafnum1 = CM_PointLeafnum( cms, p1 );
 	leafnum2 = CM_PointLeafnum( cms, p2 );
 
-	cluster = CM_LeafCluster( cms, leafnum1 );
-	area1 = CM_LeafArea( cms, leafnum1 );
-	mask = CM_ClusterPVS( cms, cluster );
+	if( !CM_ClusterInPVS( cms, CM_LeafCluster( cms, leafnum1 ), CM_LeafCluster( cms, leafnum2 ) ) ) {
+		return false;
+	}
 
-	cluster = CM_LeafCluster( cms, leafnum2 );
+	area1 = CM_LeafArea( cms, leafnum1 );
 	area2 = CM_LeafArea( cms, leafnum2 );
 
-	if( ( !( mask[cluster >> 3] & ( 1 << ( cluster & 7 ) ) ) ) ) {
-		return false;
-	}
 	if( !CM_AreasConnected( cms, area1, area2 ) ) {
 		return false; // a door blocks sight
 	}
@@ -938,6 +973,8 @@ static cmodel_state_t *CM_New_( cmodel_state_t *parent, void *mempool ) {
 	cms->refcount = 0;
 	cms->parent = parent;
 	cms->mempool = cms_mempool;
+	cms->ownareas = false;
+	cms->nextshared = NULL;
 
 	CM_InitBoxHull( cms );
 
@@ -962,6 +999,11 @@ static void CM_Free( cmodel_state_t *cms ) {
 
 	if( parent ) {
 		CM_FreeCheckCounts( cms );
+
+		if( cms->ownareas && cms->numareas ) {
+			Mem_Free( cms->map_areas );
+			Mem_Free( cms->map_areaportals );
+		}
 	} else {
 		CM_Clear( cms );
 	}
@@ -1011,7 +1053,7 @@ void CM_ReleaseReference( cmodel_state_t *cms ) {
 cmodel_state_t *CM_ThreadLocalCopy( cmodel_state_t *cms, void *mempool ) {
 	cmodel_state_t *copy;
 
-	if( cms->parent ) {
+	if( cms->parent && !cms->ownareas ) {
 		Com_Error( ERR_FATAL, "CM_ThreadLocalCopy: tried to copy a thread-local model" );
 		return NULL;
 	}
@@ -1021,6 +1063,156 @@ cmodel_state_t *CM_ThreadLocalCopy( cmodel_state_t *cms, void *mempool ) {
 	return copy;
 }
 
+/*
+===============================================================================
+
+SHARED MAPS
+
+===============================================================================
+*/
+
+static qmutex_t *cm_sharedmaps_mutex;
+static cmodel_state_t *cm_sharedmaps;   // each loaded map holds a reference on behalf of the list
+static cmodel_state_t *cm_loadingmap;   // still set if CM_LoadMap dropped to console
+
+/*
+* CM_NewInstance
+*/
+static cmodel_state_t *CM_NewInstance( cmodel_state_t *cms ) {
+	cmodel_state_t *inst;
+
+	inst = CM_New_( cms, NULL );
+	inst->ownareas = true;
+
+	if( inst->numareas ) {
+		inst->map_areas = Mem_Alloc( inst->mempool, inst->numareas * sizeof( *inst->map_areas ) );
+		inst->map_areaportals = Mem_Alloc( inst->mempool, inst->numareas * inst->numareas * sizeof( *inst->map_areaportals ) );
+		CM_FloodAreaConnections( inst );
+	}
+
+	CM_AllocateCheckCounts( inst );
+	return inst;
+}
+
+/*
+* CM_FreeFailedLoad
+*
+* ERR_DROP unwinds the stack past CM_AcquireSharedMap, so a map which failed
+* to load is freed here later. Maps are only loaded by the main thread, which
+* is the one ERR_DROP unwinds, so this is never called during a load.
+*/
+static void CM_FreeFailedLoad( void ) {
+	cmodel_state_t *cms;
+
+	QMutex_Lock( cm_sharedmaps_mutex );
+	cms = cm_loadingmap;
+	cm_loadingmap = NULL;
+	QMutex_Unlock( cm_sharedmaps_mutex );
+
+	if( cms ) {
+		CM_Free( cms );
+	}
+}
+
+/*
+* CM_AcquireSharedMap
+*/
+cmodel_state_t *CM_AcquireSharedMap( const char *name, bool clientload, unsigned *checksum ) {
+	cmodel_state_t *cms, *inst, *prev, *stale;
+	bool flush;
+
+	assert( name );
+	assert( checksum );
+
+	flush = !clientload && Cvar_Value( "flushmap" );
+
+	QMutex_Lock( cm_sharedmaps_mutex );
+	if( !flush ) {
+		for( cms = cm_sharedmaps; cms; cms = cms->nextshared ) {
+			if( !strcmp( cms->map_name, name ) ) {
+				inst = CM_NewInstance( cms );
+				QMutex_Unlock( cm_sharedmaps_mutex );
+
+				*checksum = cms->checksum;
+				return inst;
+			}
+		}
+	}
+	QMutex_Unlock( cm_sharedmaps_mutex );
+
+	CM_FreeFailedLoad();
+
+	// load outside of the lock, CM_LoadMap drops to console on errors
+	cms = CM_New( NULL );
+
+	QMutex_Lock( cm_sharedmaps_mutex );
+	cm_loadingmap = cms;
+	QMutex_Unlock( cm_sharedmaps_mutex );
+
+	CM_LoadMap( cms, name, clientload, checksum );
+
+	// replace whatever was loaded for the same name in the meantime
+	QMutex_Lock( cm_sharedmaps_mutex );
+	cm_loadingmap = NULL;
+	for( prev = NULL, stale = cm_sharedmaps; stale; prev = stale, stale = stale->nextshared ) {
+		if( !strcmp( stale->map_name, cms->map_name ) ) {
+			if( prev ) {
+				prev->nextshared = stale->nextshared;
+			} else {
+				cm_sharedmaps = stale->nextshared;
+			}
+			break;
+		}
+	}
+
+	CM_AddReference( cms );
+	cms->nextshared = cm_sharedmaps;
+	cm_sharedmaps = cms;
+
+	inst = CM_NewInstance( cms );
+	QMutex_Unlock( cm_sharedmaps_mutex );
+
+	// outstanding instances keep the replaced map alive
+	CM_ReleaseReference( stale );
+
+	return inst;
+}
+
+/*
+* CM_PurgeSharedMaps
+*/
+void CM_PurgeSharedMaps( void ) {
+	cmodel_state_t *cms, *next, *prev, *unused;
+
+	CM_FreeFailedLoad();
+
+	unused = NULL;
+
+	QMutex_Lock( cm_sharedmaps_mutex );
+	for( prev = NULL, cms = cm_sharedmaps; cms; cms = next ) {
+		next = cms->nextshared;
+
+		if( QAtomic_Add( &cms->refcount, 0 ) != 1 ) {
+			prev = cms;
+			continue;
+		}
+
+		if( prev ) {
+			prev->nextshared = next;
+		} else {
+			cm_sharedmaps = next;
+		}
+		cms->nextshared = unused;
+		unused = cms;
+	}
+	QMutex_Unlock( cm_sharedmaps_mutex );
+
+	for( cms = unused; cms; cms = next ) {
+		next = cms->nextshared;
+		CM_ReleaseReference( cms );
+	}
+}
+
 /*
 * CM_Init
 */
@@ -1031,6 +1223,9 @@ void CM_Init( void ) {
 
 	cm_noAreas =        Cvar_Get( "cm_noAreas", "0", CVAR_CHEAT );
 	cm_noCurves =       Cvar_Get( "cm_noCurves", "0", CVAR_CHEAT );
+	cm_mapCache =       Cvar_Get( "cm_mapCache", "1", CVAR_ARCHIVE );
+
+	cm_sharedmaps_mutex = QMutex_Create();
 
 	cm_initialized = true;
 }
@@ -1043,6 +1238,11 @@ void CM_Shutdown( void ) {
 		return;
 	}
 
+	// the pool takes down maps that are still referenced
+	cm_sharedmaps = NULL;
+	cm_loadingmap = NULL;
+	QMutex_Destroy( &cm_sharedmaps_mutex );
+
 	Mem_FreePool( &cmap_mempool );
 
 	cm_initialized = false;
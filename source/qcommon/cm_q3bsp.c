@@ -299,6 +299,259 @@ static void CM_CreatePatch( cmodel_state_t *cms, cface_t *patch, cshaderref_t *s
 /*
 ===============================================================================
 
+PATCH CACHE
+
+===============================================================================
+*/
+
+// patch collision is the most expensive part of loading a map, so the facets
+// are cached to a file keyed by the BSP checksum. the file is only read back
+// by the same binary, so the structures are stored in native layout:
+// header
+// cpatchcachebrush_t faces[numfaces]
+// cpatchcachebrush_t facets[numfacets]
+// cbrushside_t sides[numsides]
+#define CM_PATCHCACHE_DIR           "cache/collision"
+#define CM_PATCHCACHE_FILE_MAGIC    "QFCM"
+#define CM_PATCHCACHE_FILE_VERSION  1
+
+typedef struct {
+	char magic[4];
+	int version;
+	unsigned int checksum;
+	int subdivLevel;
+	int numfaces;
+	int numfacets;
+	int numsides;
+} cpatchcacheheader_t;
+
+// both patches and their facets, numchildren is the number of facets or brush sides
+typedef struct {
+	int contents;
+	int numchildren;
+	vec3_t mins, maxs;
+} cpatchcachebrush_t;
+
+/*
+* CM_PatchCacheFileName
+*/
+static void CM_PatchCacheFileName( cmodel_state_t *cms, char *filename, size_t size ) {
+	Q_snprintfz( filename, size, "%s/%08x.bin", CM_PATCHCACHE_DIR, cms->checksum );
+}
+
+/*
+* CM_ParsePatchCache
+*/
+static bool CM_ParsePatchCache( cmodel_state_t *cms, const uint8_t *data, size_t size, int numfaces ) {
+	int i, j;
+	int numfacets, numsides;
+	size_t expectedSize;
+	cpatchcacheheader_t header;
+	const cpatchcachebrush_t *inface, *infacet;
+	const cbrushside_t *inside;
+	cface_t *out;
+	cbrush_t *facet;
+
+	if( size < sizeof( header ) ) {
+		return false;
+	}
+
+	memcpy( &header, data, sizeof( header ) );
+	if( memcmp( header.magic, CM_PATCHCACHE_FILE_MAGIC, sizeof( header.magic ) ) ||
+		header.version != CM_PATCHCACHE_FILE_VERSION || header.checksum != cms->checksum ||
+		header.subdivLevel != CM_SUBDIV_LEVEL || header.numfaces != numfaces ) {
+		return false;
+	}
+	if( header.numfacets < 0 || header.numsides < 0 ) {
+		return false;
+	}
+
+	expectedSize = sizeof( header ) + ( header.numfaces + header.numfacets ) * sizeof( cpatchcachebrush_t ) +
+				   header.numsides * sizeof( cbrushside_t );
+	if( size != expectedSize ) {
+		return false;
+	}
+
+	inface = ( const cpatchcachebrush_t * )( data + sizeof( header ) );
+	infacet = inface + header.numfaces;
+	inside = ( const cbrushside_t * )( infacet + header.numfacets );
+
+	// make sure the counts add up before allocating anything
+	numfacets = numsides = 0;
+	for( i = 0; i < header.numfaces; i++ ) {
+		if( inface[i].numchildren < 0 || inface[i].numchildren > header.numfacets - numfacets ) {
+			return false;
+		}
+		numfacets += inface[i].numchildren;
+	}
+	for( i = 0; i < header.numfacets; i++ ) {
+		if( infacet[i].numchildren < 0 || infacet[i].numchildren > header.numsides - numsides ) {
+			return false;
+		}
+		numsides += infacet[i].numchildren;
+	}
+	if( numfacets != header.numfacets || numsides != header.numsides ) {
+		return false;
+	}
+
+	out = cms->map_faces = Mem_Alloc( cms->mempool, numfaces * sizeof( *out ) );
+	cms->numfaces = numfaces;
+
+	for( i = 0; i < numfaces; i++, inface++, out++ ) {
+		uint8_t *fdata;
+
+		out->contents = inface->contents;
+		out->numfacets = inface->numchildren;
+		VectorCopy( inface->mins, out->mins );
+		VectorCopy( inface->maxs, out->maxs );
+		out->facets = NULL;
+		if( !out->numfacets ) {
+			continue;
+		}
+
+		for( j = 0, numsides = 0; j < out->numfacets; j++ )
+			numsides += infacet[j].numchildren;
+
+		// same layout as CM_CreatePatch, so CM_Clear can free it
+		fdata = Mem_Alloc( cms->mempool, out->numfacets * sizeof( cbrush_t ) + numsides * sizeof( cbrushside_t ) );
+		out->facets = ( cbrush_t * )fdata; fdata += out->numfacets * sizeof( cbrush_t );
+
+		for( j = 0, facet = out->facets; j < out->numfacets; j++, facet++, infacet++ ) {
+			facet->contents = infacet->contents;
+			facet->numsides = infacet->numchildren;
+			VectorCopy( infacet->mins, facet->mins );
+			VectorCopy( infacet->maxs, facet->maxs );
+			facet->brushsides = ( cbrushside_t * )fdata; fdata += facet->numsides * sizeof( cbrushside_t );
+			memcpy( facet->brushsides, inside, facet->numsides * sizeof( cbrushside_t ) );
+			inside += facet->numsides;
+		}
+	}
+
+	return true;
+}
+
+/*
+* CM_LoadPatchCache
+*
+* Loads the patch facets from the cache, returns false if the cache
+* is missing or doesn't match the map
+*/
+static bool CM_LoadPatchCache( cmodel_state_t *cms, int numfaces ) {
+	int file, length;
+	uint8_t *data;
+	bool mapped, loaded;
+	char filename[MAX_QPATH];
+
+	if( !cm_mapCache->integer ) {
+		return false;
+	}
+
+	CM_PatchCacheFileName( cms, filename, sizeof( filename ) );
+
+	length = FS_FOpenFile( filename, &file, FS_READ | FS_CACHE );
+	if( length <= 0 ) {
+		if( file ) {
+			FS_FCloseFile( file );
+		}
+		return false;
+	}
+
+	data = FS_MMapBaseFile( file, length, 0 );
+	mapped = data != NULL;
+	if( !mapped ) {
+		data = Mem_TempMalloc( length );
+		if( FS_Read( data, length, file ) != length ) {
+			Mem_TempFree( data );
+			FS_FCloseFile( file );
+			return false;
+		}
+	}
+
+	loaded = CM_ParsePatchCache( cms, data, length, numfaces );
+
+	if( mapped ) {
+		FS_UnMMapBaseFile( file, data );
+	} else {
+		Mem_TempFree( data );
+	}
+	FS_FCloseFile( file );
+
+	if( loaded ) {
+		Com_DPrintf( "Loaded patch collision from %s\n", filename );
+	}
+	return loaded;
+}
+
+/*
+* CM_WritePatchCache
+*/
+static void CM_WritePatchCache( cmodel_state_t *cms ) {
+	int i, j, file;
+	cpatchcacheheader_t header;
+	cpatchcachebrush_t brush;
+	const cface_t *face;
+	const cbrush_t *facet;
+	char filename[MAX_QPATH];
+
+	if( !cm_mapCache->integer ) {
+		return;
+	}
+
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, CM_PATCHCACHE_FILE_MAGIC, sizeof( header.magic ) );
+	header.version = CM_PATCHCACHE_FILE_VERSION;
+	header.checksum = cms->checksum;
+	header.subdivLevel = CM_SUBDIV_LEVEL;
+	header.numfaces = cms->numfaces;
+	for( i = 0, face = cms->map_faces; i < cms->numfaces; i++, face++ ) {
+		header.numfacets += face->numfacets;
+		for( j = 0, facet = face->facets; j < face->numfacets; j++, facet++ )
+			header.numsides += facet->numsides;
+	}
+
+	// maps without patches load fast enough
+	if( !header.numfacets ) {
+		return;
+	}
+
+	CM_PatchCacheFileName( cms, filename, sizeof( filename ) );
+	if( FS_FOpenFile( filename, &file, FS_WRITE | FS_CACHE ) == -1 ) {
+		Com_Printf( S_COLOR_YELLOW "Could not open %s for writing.\n", filename );
+		return;
+	}
+
+	FS_Write( &header, sizeof( header ), file );
+
+	memset( &brush, 0, sizeof( brush ) );
+	for( i = 0, face = cms->map_faces; i < cms->numfaces; i++, face++ ) {
+		brush.contents = face->contents;
+		brush.numchildren = face->numfacets;
+		VectorCopy( face->mins, brush.mins );
+		VectorCopy( face->maxs, brush.maxs );
+		FS_Write( &brush, sizeof( brush ), file );
+	}
+
+	for( i = 0, face = cms->map_faces; i < cms->numfaces; i++, face++ ) {
+		for( j = 0, facet = face->facets; j < face->numfacets; j++, facet++ ) {
+			brush.contents = facet->contents;
+			brush.numchildren = facet->numsides;
+			VectorCopy( facet->mins, brush.mins );
+			VectorCopy( facet->maxs, brush.maxs );
+			FS_Write( &brush, sizeof( brush ), file );
+		}
+	}
+
+	for( i = 0, face = cms->map_faces; i < cms->numfaces; i++, face++ ) {
+		for( j = 0, facet = face->facets; j < face->numfacets; j++, facet++ )
+			FS_Write( facet->brushsides, facet->numsides * sizeof( cbrushside_t ), file );
+	}
+
+	FS_FCloseFile( file );
+}
+
+/*
+===============================================================================
+
 MAP LOADING
 
 ===============================================================================
@@ -506,6 +759,44 @@ static void CMod_LoadFaces_RBSP( cmodel_state_t *cms, lump_t *l ) {
 	}
 }
 
+/*
+* CMod_CountFaces
+*
+* Validates the vertex and face lumps the way their loaders do, since the
+* loaders are skipped when the patch collision cache is used, and returns
+* the number of faces.
+*/
+static int CMod_CountFaces( cmodel_state_t *cms, lump_t *vertexes, lump_t *faces ) {
+	int count;
+
+	if( cms->cmap_bspFormat->flags & BSP_RAVEN ) {
+		if( vertexes->filelen % sizeof( rdvertex_t ) ) {
+			Com_Error( ERR_DROP, "CMod_LoadVertexes_RBSP: funny lump size" );
+		}
+		if( faces->filelen % sizeof( rdface_t ) ) {
+			Com_Error( ERR_DROP, "CMod_LoadFaces_RBSP: funny lump size" );
+		}
+		count = faces->filelen / sizeof( rdface_t );
+	} else {
+		if( vertexes->filelen % sizeof( dvertex_t ) ) {
+			Com_Error( ERR_DROP, "CMOD_LoadVertexes: funny lump size" );
+		}
+		if( faces->filelen % sizeof( dface_t ) ) {
+			Com_Error( ERR_DROP, "CMod_LoadFaces: funny lump size" );
+		}
+		count = faces->filelen / sizeof( dface_t );
+	}
+
+	if( vertexes->filelen < 1 ) {
+		Com_Error( ERR_DROP, "Map with no vertexes" );
+	}
+	if( count < 1 ) {
+		Com_Error( ERR_DROP, "Map with no faces" );
+	}
+
+	return count;
+}
+
 /*
 * CMod_LoadSubmodels
 */
@@ -843,17 +1134,39 @@ static void CMod_LoadBrushes( cmodel_state_t *cms, lump_t *l ) {
 * CMod_LoadVisibility
 */
 static void CMod_LoadVisibility( cmodel_state_t *cms, lump_t *l ) {
+	int i;
+	int numclusters, rowbytes, rowsize;
+	dvis_t *in;
+
 	cms->map_visdatasize = l->filelen;
 	if( !cms->map_visdatasize ) {
 		cms->map_pvs = NULL;
 		return;
 	}
 
+	if( l->filelen < (int)( 2 * sizeof( int ) ) ) {
+		Com_Error( ERR_DROP, "CMod_LoadVisibility: funny lump size" );
+	}
+
+	in = ( void * )( cms->cmod_base + l->fileofs );
+
+	numclusters = LittleLong( in->numclusters );
+	rowbytes = LittleLong( in->rowsize );
+	if( numclusters < 0 || rowbytes < 0 || (size_t)numclusters * rowbytes > l->filelen - 2 * sizeof( int ) ) {
+		Com_Error( ERR_DROP, "CMod_LoadVisibility: funny lump size" );
+	}
+
+	// pad the rows to whole 64-bit words so they can be merged a word at a time
+	rowsize = ( rowbytes + 7 ) & ~7;
+	cms->map_visdatasize = sizeof( *( cms->map_pvs ) ) + numclusters * rowsize;
+
 	cms->map_pvs = Mem_Alloc( cms->mempool, cms->map_visdatasize );
-	memcpy( cms->map_pvs, cms->cmod_base + l->fileofs, cms->map_visdatasize );
+	cms->map_pvs->numclusters = numclusters;
+	cms->map_pvs->rowsize = rowsize;
 
-	cms->map_pvs->numclusters = LittleLong( cms->map_pvs->numclusters );
-	cms->map_pvs->rowsize = LittleLong( cms->map_pvs->rowsize );
+	for( i = 0; i < numclusters; i++ ) {
+		memcpy( cms->map_pvs->data + i * rowsize, in->data + i * rowbytes, rowbytes );
+	}
 }
 
 /*
@@ -873,7 +1186,7 @@ static void CMod_LoadEntityString( cmodel_state_t *cms, lump_t *l ) {
 * CM_LoadQ3BrushModel
 */
 void CM_LoadQ3BrushModel( cmodel_state_t *cms, void *parent, void *buf, bspFormatDesc_t *format ) {
-	int i;
+	int i, numfaces;
 	dheader_t header;
 
 	cms->cmap_bspFormat = format;
@@ -893,12 +1206,16 @@ void CM_LoadQ3BrushModel( cmodel_state_t *cms, void *parent, void *buf, bspForma
 	}
 	CMod_LoadBrushes( cms, &header.lumps[LUMP_BRUSHES] );
 	CMod_LoadMarkBrushes( cms, &header.lumps[LUMP_LEAFBRUSHES] );
-	if( cms->cmap_bspFormat->flags & BSP_RAVEN ) {
-		CMod_LoadVertexes_RBSP( cms, &header.lumps[LUMP_VERTEXES] );
-		CMod_LoadFaces_RBSP( cms, &header.lumps[LUMP_FACES] );
-	} else {
-		CMod_LoadVertexes( cms, &header.lumps[LUMP_VERTEXES] );
-		CMod_LoadFaces( cms, &header.lumps[LUMP_FACES] );
+	numfaces = CMod_CountFaces( cms, &header.lumps[LUMP_VERTEXES], &header.lumps[LUMP_FACES] );
+	if( !CM_LoadPatchCache( cms, numfaces ) ) {
+		if( cms->cmap_bspFormat->flags & BSP_RAVEN ) {
+			CMod_LoadVertexes_RBSP( cms, &header.lumps[LUMP_VERTEXES] );
+			CMod_LoadFaces_RBSP( cms, &header.lumps[LUMP_FACES] );
+		} else {
+			CMod_LoadVertexes( cms, &header.lumps[LUMP_VERTEXES] );
+			CMod_LoadFaces( cms, &header.lumps[LUMP_FACES] );
+		}
+		CM_WritePatchCache( cms );
 	}
 	CMod_LoadMarkFaces( cms, &header.lumps[LUMP_LEAFFACES] );
 	CMod_LoadLeafs( cms, &header.lumps[LUMP_LEAFS] );
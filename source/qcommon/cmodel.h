@@ -73,7 +73,11 @@ bool CM_HeadnodeVisible( cmodel_state_t *cms, int headnode, uint8_t *visbits );
 void CM_WritePortalState( cmodel_state_t *cms, int file );
 void CM_ReadPortalState( cmodel_state_t *cms, int file );
 
+// visibility rows are CM_ClusterRowSize bytes long, buffers for them must be 8-byte aligned
+const uint8_t *CM_ClusterPVS( cmodel_state_t *cms, int cluster );
+bool CM_ClusterInPVS( cmodel_state_t *cms, int cluster1, int cluster2 );
 void CM_MergePVS( cmodel_state_t *cms, const vec3_t org, uint8_t *out );
+void CM_FatPVS( cmodel_state_t *cms, const vec3_t org, uint8_t *out );
 int CM_MergeVisSets( cmodel_state_t *cms, const vec3_t org, uint8_t *pvs, uint8_t *areabits );
 
 bool CM_InPVS( cmodel_state_t *cms, const vec3_t p1, const vec3_t p2 );
@@ -91,6 +95,22 @@ void CM_ReleaseReference( cmodel_state_t *cms );
 */
 cmodel_state_t *CM_ThreadLocalCopy( cmodel_state_t *cms, void *mempool );
 
+/*
+* CM_AcquireSharedMap
+*
+* Returns a new instance of the map, loading it only if no other instance
+* in the process has it loaded. Collision data is shared between instances,
+* area portal state is not. Release with CM_ReleaseReference.
+*/
+cmodel_state_t *CM_AcquireSharedMap( const char *name, bool clientload, unsigned *checksum );
+
+/*
+* CM_PurgeSharedMaps
+*
+* Frees loaded maps that have no instances left.
+*/
+void CM_PurgeSharedMaps( void );
+
 //
 void CM_Init( void );
 void CM_Shutdown( void );
@@ -19,8 +19,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // common.c -- misc functions used in client and server
 #include "qcommon.h"
-#if defined( __GNUC__ ) && defined( i386 )
+#if defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
 #include <cpuid.h>
+#elif defined( _MSC_VER ) && ( defined( _M_IX86 ) || defined( _M_X64 ) )
+#include <intrin.h>
 #endif
 #include <setjmp.h>
 #include "wswcurl.h"
@@ -40,6 +42,8 @@ static char com_errormsg[MAX_PRINTMSG];
 
 static bool com_quit;
 
+static uint64_t com_frameclock;     // microsecond time of the last frame boundary
+
 static jmp_buf abortframe;     // an ERR_DROP occured, exit the entire frame
 
 cvar_t *host_speeds;
@@ -53,7 +57,10 @@ static cvar_t *logconsole = NULL;
 static cvar_t *logconsole_append;
 static cvar_t *logconsole_flush;
 static cvar_t *logconsole_timestamp;
+static cvar_t *logconsole_json;
+static cvar_t *logconsole_norepeat;
 static cvar_t *com_showtrace;
+static cvar_t *com_showcvarlookups;
 static cvar_t *com_introPlayed3;
 
 static qmutex_t *com_print_mutex;
@@ -116,6 +123,312 @@ void Com_EndRedirect( void ) {
 	QMutex_Unlock( com_print_mutex );
 }
 
+/*
+============================================================================
+
+CONSOLE LOG
+
+Lines for the log file are handed over to a writer thread through a
+non-blocking pipe, so that disk I/O never stalls the caller. The writer
+formats them and writes them out in batches. Lines which don't fit in
+the pipe are dropped and accounted for in the log.
+
+============================================================================
+*/
+
+#define LOG_PIPE_SIZE           0x40000
+#define LOG_BATCH_SIZE          0x10000
+#define LOG_MAX_SUBSYSTEM       16
+
+enum {
+	LOG_CMD_PRINT,
+	LOG_CMD_QUIT,
+
+	LOG_NUM_CMDS
+};
+
+typedef struct {
+	int id;
+	int size;
+	int64_t time;
+	int severity;
+	int client;
+	char subsystem[LOG_MAX_SUBSYSTEM];
+	char text[1];
+} com_logprintcmd_t;
+
+static qbufPipe_t *com_log_pipe;
+static qthread_t *com_log_thread;
+static char com_log_batch[LOG_BATCH_SIZE];
+static size_t com_log_batchlen;
+
+// these are only accessed with com_print_mutex held
+static int com_log_dropped;
+static int com_log_repeats;
+static char com_log_lastline[MAX_PRINTMSG];
+static int64_t com_log_lastlinetime;
+
+static const char *com_log_severities[] = { "debug", "info", "warning", "error" };
+
+/*
+* Com_Log_FlushBatch
+*/
+static void Com_Log_FlushBatch( void ) {
+	if( !com_log_batchlen ) {
+		return;
+	}
+
+	FS_Write( com_log_batch, com_log_batchlen, log_file );
+	if( logconsole_flush && logconsole_flush->integer ) {
+		FS_Flush( log_file ); // force it to save every time
+	}
+	com_log_batchlen = 0;
+}
+
+/*
+* Com_Log_Append
+*/
+static void Com_Log_Append( const char *text, size_t len ) {
+	if( com_log_batchlen + len > LOG_BATCH_SIZE ) {
+		Com_Log_FlushBatch();
+		if( len > LOG_BATCH_SIZE ) {
+			FS_Write( text, len, log_file );
+			return;
+		}
+	}
+
+	memcpy( com_log_batch + com_log_batchlen, text, len );
+	com_log_batchlen += len;
+}
+
+/*
+* Com_Log_AppendJSONString
+*/
+static void Com_Log_AppendJSONString( const char *s, size_t len ) {
+	size_t i, n;
+	char buf[256];
+
+	buf[0] = '"';
+	n = 1;
+	for( i = 0; i < len; i++ ) {
+		unsigned char c = s[i];
+
+		if( n + 8 > sizeof( buf ) ) {
+			Com_Log_Append( buf, n );
+			n = 0;
+		}
+
+		if( c == '"' || c == '\\' ) {
+			buf[n++] = '\\';
+			buf[n++] = c;
+		} else if( c == '\n' ) {
+			buf[n++] = '\\';
+			buf[n++] = 'n';
+		} else if( c < 0x20 ) {
+			n += Q_snprintfz( buf + n, sizeof( buf ) - n, "\\u%04x", c );
+		} else {
+			buf[n++] = c;
+		}
+	}
+	buf[n++] = '"';
+
+	Com_Log_Append( buf, n );
+}
+
+/*
+* Com_Log_FormatTime
+*/
+static size_t Com_Log_FormatTime( int64_t time, char *buf, size_t size ) {
+	time_t t = (time_t)time;
+	struct tm tm;
+
+#ifdef _WIN32
+	gmtime_s( &tm, &t );
+#else
+	gmtime_r( &t, &tm );
+#endif
+	return strftime( buf, size, "%Y-%m-%dT%H:%M:%SZ", &tm );
+}
+
+/*
+* Com_Log_PrintCmd
+*/
+static unsigned Com_Log_PrintCmd( const void *pcmd ) {
+	const com_logprintcmd_t *cmd = pcmd;
+	size_t len = strlen( cmd->text );
+	char buf[192];
+	size_t n;
+
+	if( logconsole_json && logconsole_json->integer ) {
+		// one object per line, the trailing newline is implied
+		if( len && cmd->text[len - 1] == '\n' ) {
+			len--;
+		}
+
+		n = Q_snprintfz( buf, sizeof( buf ), "{\"time\":\"" );
+		n += Com_Log_FormatTime( cmd->time, buf + n, sizeof( buf ) - n );
+		n += Q_snprintfz( buf + n, sizeof( buf ) - n, "\",\"severity\":\"%s\"", com_log_severities[cmd->severity] );
+		if( cmd->subsystem[0] ) {
+			n += Q_snprintfz( buf + n, sizeof( buf ) - n, ",\"subsystem\":\"%s\"", cmd->subsystem );
+		}
+		if( cmd->client >= 0 ) {
+			n += Q_snprintfz( buf + n, sizeof( buf ) - n, ",\"client\":%i", cmd->client );
+		}
+		n += Q_snprintfz( buf + n, sizeof( buf ) - n, ",\"msg\":" );
+
+		Com_Log_Append( buf, n );
+		Com_Log_AppendJSONString( cmd->text, len );
+		Com_Log_Append( "}\n", 2 );
+	} else {
+		if( logconsole_timestamp && logconsole_timestamp->integer ) {
+			n = Com_Log_FormatTime( cmd->time, buf, sizeof( buf ) - 1 );
+			buf[n++] = ' ';
+			Com_Log_Append( buf, n );
+		}
+		Com_Log_Append( cmd->text, len );
+	}
+
+	return cmd->size;
+}
+
+/*
+* Com_Log_QuitCmd
+*/
+static unsigned Com_Log_QuitCmd( const void *pcmd ) {
+	return 0;
+}
+
+/*
+* Com_Log_CmdsWaiter
+*/
+static int Com_Log_CmdsWaiter( qbufPipe_t *queue, unsigned( **cmdHandlers )( const void * ), bool timeout ) {
+	int read = QBufPipe_ReadCmds( queue, cmdHandlers );
+
+	// everything that has piled up goes out in a single write
+	Com_Log_FlushBatch();
+
+	return read;
+}
+
+/*
+* Com_Log_Thread
+*/
+static void *Com_Log_Thread( void *param ) {
+	unsigned( *cmdHandlers[LOG_NUM_CMDS] )( const void * ) = { Com_Log_PrintCmd, Com_Log_QuitCmd };
+
+	QBufPipe_Wait( com_log_pipe, Com_Log_CmdsWaiter, cmdHandlers, Q_THREADS_WAIT_INFINITE );
+
+	return NULL;
+}
+
+/*
+* Com_Log_WriteLine
+*/
+static bool Com_Log_WriteLine( const char *subsystem, int severity, int client, int64_t time, const char *text ) {
+	size_t len = strlen( text );
+	size_t size = ( offsetof( com_logprintcmd_t, text ) + len + 1 + 7 ) & ~7;
+	static uint8_t buf[( sizeof( com_logprintcmd_t ) + MAX_PRINTMSG + 7 ) & ~7];
+	com_logprintcmd_t *cmd = (com_logprintcmd_t *)buf;
+
+	cmd->id = LOG_CMD_PRINT;
+	cmd->size = size;
+	cmd->time = time;
+	cmd->severity = severity;
+	cmd->client = client;
+	Q_strncpyz( cmd->subsystem, subsystem ? subsystem : "", sizeof( cmd->subsystem ) );
+	memcpy( cmd->text, text, len + 1 );
+
+	return QBufPipe_TryWriteCmd( com_log_pipe, cmd, size );
+}
+
+/*
+* Com_Log_FlushRepeats
+*/
+static void Com_Log_FlushRepeats( void ) {
+	char text[64];
+
+	if( com_log_repeats ) {
+		Q_snprintfz( text, sizeof( text ), "(last message repeated %i times)\n", com_log_repeats );
+		Com_Log_WriteLine( "log", COM_LOG_INFO, -1, com_log_lastlinetime, text );
+		com_log_repeats = 0;
+	}
+}
+
+/*
+* Com_Log_Print
+*
+* Called with com_print_mutex held.
+*/
+static void Com_Log_Print( const char *subsystem, int severity, int client, const char *text ) {
+	int64_t now = time( NULL );
+
+	// fold floods of the same line into a counter
+	if( logconsole_norepeat && logconsole_norepeat->integer ) {
+		if( !strcmp( text, com_log_lastline ) ) {
+			com_log_repeats++;
+			com_log_lastlinetime = now;
+			return;
+		}
+		Com_Log_FlushRepeats();
+		Q_strncpyz( com_log_lastline, text, sizeof( com_log_lastline ) );
+		com_log_lastlinetime = now;
+	}
+
+	if( com_log_dropped ) {
+		char notice[64];
+
+		Q_snprintfz( notice, sizeof( notice ), "%i log lines dropped\n", com_log_dropped );
+		if( !Com_Log_WriteLine( "log", COM_LOG_WARNING, -1, now, notice ) ) {
+			com_log_dropped++;
+			return;
+		}
+		com_log_dropped = 0;
+	}
+
+	if( !Com_Log_WriteLine( subsystem, severity, client, now, text ) ) {
+		com_log_dropped++;
+	}
+}
+
+/*
+* Com_Log_Stop
+*
+* Called with com_print_mutex held. Blocks until all lines are written out.
+*/
+static void Com_Log_Stop( void ) {
+	int cmd = LOG_CMD_QUIT;
+
+	if( !com_log_thread ) {
+		return;
+	}
+
+	QBufPipe_Finish( com_log_pipe );
+
+	Com_Log_FlushRepeats();
+	com_log_lastline[0] = '\0';
+
+	QBufPipe_WriteCmd( com_log_pipe, &cmd, sizeof( cmd ) );
+	QThread_Join( com_log_thread );
+	com_log_thread = NULL;
+
+	QBufPipe_Destroy( &com_log_pipe );
+}
+
+/*
+* Com_Log_Start
+*
+* Called with com_print_mutex held.
+*/
+static void Com_Log_Start( void ) {
+	com_log_dropped = 0;
+	com_log_repeats = 0;
+	com_log_lastline[0] = '\0';
+	com_log_batchlen = 0;
+
+	com_log_pipe = QBufPipe_Create( LOG_PIPE_SIZE, 0 );
+	com_log_thread = QThread_Create( Com_Log_Thread, NULL );
+}
+
 void Com_DeferConsoleLogReopen( void ) {
 	if( logconsole != NULL ) {
 		logconsole->modified = true;
@@ -131,6 +444,8 @@ static void Com_CloseConsoleLog( bool lock, bool shutdown ) {
 		QMutex_Lock( com_print_mutex );
 	}
 
+	Com_Log_Stop();
+
 	if( log_file ) {
 		FS_FCloseFile( log_file );
 		log_file = 0;
@@ -164,6 +479,8 @@ static void Com_ReopenConsoleLog( void ) {
 		if( FS_FOpenFile( name, &log_file, ( logconsole_append && logconsole_append->integer ? FS_APPEND : FS_WRITE ) ) == -1 ) {
 			log_file = 0;
 			Q_snprintfz( errmsg, MAX_PRINTMSG, "Couldn't open: %s\n", name );
+		} else {
+			Com_Log_Start();
 		}
 
 		Mem_TempFree( name );
@@ -177,26 +494,12 @@ static void Com_ReopenConsoleLog( void ) {
 }
 
 /*
-* Com_Printf
+* Com_PrintMessage
 *
 * Both client and server can use this, and it will output
 * to the apropriate place.
 */
-void Com_Printf( const char *format, ... ) {
-	va_list argptr;
-	char msg[MAX_PRINTMSG];
-
-	time_t timestamp;
-	char timestamp_str[MAX_PRINTMSG];
-	struct tm *timestampptr;
-	timestamp = time( NULL );
-	timestampptr = gmtime( &timestamp );
-	strftime( timestamp_str, MAX_PRINTMSG, "%Y-%m-%dT%H:%M:%SZ ", timestampptr );
-
-	va_start( argptr, format );
-	Q_vsnprintfz( msg, sizeof( msg ), format, argptr );
-	va_end( argptr );
-
+static void Com_PrintMessage( const char *subsystem, int severity, int client, const char *msg ) {
 	QMutex_Lock( com_print_mutex );
 
 	if( rd_target ) {
@@ -211,23 +514,47 @@ void Com_Printf( const char *format, ... ) {
 	}
 
 	// also echo to debugging console
-	Sys_ConsoleOutput( msg );
+	Sys_ConsoleOutput( (char *)msg );
 
 	Con_Print( msg );
 
-	if( log_file ) {
-		if( logconsole_timestamp && logconsole_timestamp->integer ) {
-			FS_Printf( log_file, "%s", timestamp_str );
-		}
-		FS_Printf( log_file, "%s", msg );
-		if( logconsole_flush && logconsole_flush->integer ) {
-			FS_Flush( log_file ); // force it to save every time
-		}
+	if( com_log_thread ) {
+		Com_Log_Print( subsystem, severity, client, msg );
 	}
 
 	QMutex_Unlock( com_print_mutex );
 }
 
+/*
+* Com_Printf
+*/
+void Com_Printf( const char *format, ... ) {
+	va_list argptr;
+	char msg[MAX_PRINTMSG];
+
+	va_start( argptr, format );
+	Q_vsnprintfz( msg, sizeof( msg ), format, argptr );
+	va_end( argptr );
+
+	Com_PrintMessage( NULL, COM_LOG_INFO, -1, msg );
+}
+
+/*
+* Com_LogPrintf
+*
+* A Com_Printf which tags the line for the structured log
+*/
+void Com_LogPrintf( const char *subsystem, com_log_severity_t severity, int client, const char *format, ... ) {
+	va_list argptr;
+	char msg[MAX_PRINTMSG];
+
+	va_start( argptr, format );
+	Q_vsnprintfz( msg, sizeof( msg ), format, argptr );
+	va_end( argptr );
+
+	Com_PrintMessage( subsystem, severity, client, msg );
+}
+
 
 /*
 * Com_DPrintf
@@ -246,7 +573,7 @@ void Com_DPrintf( const char *format, ... ) {
 	Q_vsnprintfz( msg, sizeof( msg ), format, argptr );
 	va_end( argptr );
 
-	Com_Printf( "%s", msg );
+	Com_PrintMessage( NULL, COM_LOG_DEBUG, -1, msg );
 }
 
 
@@ -273,22 +600,19 @@ void Com_Error( com_error_code_t code, const char *format, ... ) {
 	va_end( argptr );
 
 	if( code == ERR_DROP ) {
-		Com_Printf( "********************\nERROR: %s\n********************\n", msg );
+		Com_LogPrintf( NULL, COM_LOG_ERROR, -1, "********************\nERROR: %s\n********************\n", msg );
 		SV_ShutdownGame( va( "Server crashed: %s\n", msg ), false );
 		CL_Disconnect( msg );
 		recursive = false;
 		longjmp( abortframe, -1 );
 	} else {
-		Com_Printf( "********************\nERROR: %s\n********************\n", msg );
+		Com_LogPrintf( NULL, COM_LOG_ERROR, -1, "********************\nERROR: %s\n********************\n", msg );
 		SV_Shutdown( va( "Server fatal crashed: %s\n", msg ) );
 		CL_Shutdown();
 		MM_Shutdown();
 	}
 
-	if( log_file ) {
-		FS_FCloseFile( log_file );
-		log_file = 0;
-	}
+	Com_CloseConsoleLog( true, false );
 
 	Sys_Error( "%s", msg );
 }
@@ -361,6 +685,48 @@ void Com_SetDemoPlaying( bool state ) {
 	demo_playing = state;
 }
 
+/*
+* COM_CPUFeatures
+*
+* Returns a mask of QCPU_HAS_* bits for the CPU we're running on.
+*/
+unsigned int COM_CPUFeatures( void ) {
+	static int features = -1;
+
+	if( features < 0 ) {
+		unsigned int edx = 0;
+
+#if defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
+		unsigned int eax, ebx, ecx;
+
+		if( __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) == 0 ) {
+			edx = 0;
+		}
+#elif defined( _MSC_VER ) && ( defined( _M_IX86 ) || defined( _M_X64 ) )
+		int regs[4];
+
+		__cpuid( regs, 1 );
+		edx = regs[3];
+#endif
+
+		features = 0;
+		if( edx & ( 1 << 4 ) ) {
+			features |= QCPU_HAS_RDTSC;
+		}
+		if( edx & ( 1 << 23 ) ) {
+			features |= QCPU_HAS_MMX;
+		}
+		if( edx & ( 1 << 25 ) ) {
+			features |= QCPU_HAS_SSE;
+		}
+		if( edx & ( 1 << 26 ) ) {
+			features |= QCPU_HAS_SSE2;
+		}
+	}
+
+	return (unsigned int)features;
+}
+
 unsigned int Com_DaysSince1900( void ) {
 	time_t long_time;
 	struct tm *newtime;
@@ -641,6 +1007,7 @@ void Qcommon_InitCommands( void ) {
 #ifndef PUBLIC_BUILD
 	Cmd_AddCommand( "error", Com_Error_f );
 	Cmd_AddCommand( "lag", Com_Lag_f );
+	Cmd_AddCommand( "pipebench", QBufPipe_Bench_f );
 #endif
 
 	if( dedicated->integer ) {
@@ -661,6 +1028,7 @@ void Qcommon_ShutdownCommands( void ) {
 #ifndef PUBLIC_BUILD
 	Cmd_RemoveCommand( "error" );
 	Cmd_RemoveCommand( "lag" );
+	Cmd_RemoveCommand( "pipebench" );
 #endif
 
 	if( dedicated->integer ) {
@@ -752,8 +1120,11 @@ void Qcommon_Init( int argc, char **argv ) {
 	logconsole_append = Cvar_Get( "logconsole_append", "1", CVAR_ARCHIVE );
 	logconsole_flush =  Cvar_Get( "logconsole_flush", "0", CVAR_ARCHIVE );
 	logconsole_timestamp =  Cvar_Get( "logconsole_timestamp", "0", CVAR_ARCHIVE );
+	logconsole_json =   Cvar_Get( "logconsole_json", "0", CVAR_ARCHIVE );
+	logconsole_norepeat =   Cvar_Get( "logconsole_norepeat", "1", CVAR_ARCHIVE );
 
 	com_showtrace =     Cvar_Get( "com_showtrace", "0", 0 );
+	com_showcvarlookups = Cvar_Get( "com_showcvarlookups", "0", 0 );
 	com_introPlayed3 =   Cvar_Get( "com_introPlayed3", "0", CVAR_ARCHIVE );
 
 	Cvar_Get( "gamename", APPLICATION, CVAR_READONLY );
@@ -761,6 +1132,8 @@ void Qcommon_Init( int argc, char **argv ) {
 
 	Sys_Init();
 
+	QJobs_Init();
+
 	NET_Init();
 	Netchan_Init();
 
@@ -811,6 +1184,36 @@ void Qcommon_Init( int argc, char **argv ) {
 	Cbuf_Execute();
 }
 
+/*
+* Qcommon_FrameMsec
+*
+* Returns the number of whole milliseconds which have passed since the
+* last frame. The remainder is carried over, so frame boundaries stay
+* in phase with the microsecond clock and can be scheduled precisely.
+*/
+unsigned int Qcommon_FrameMsec( void ) {
+	uint64_t now = Sys_Microseconds();
+	unsigned int msec;
+
+	if( !com_frameclock ) {
+		com_frameclock = now;
+		return 0;
+	}
+
+	msec = ( now - com_frameclock ) / 1000;
+	com_frameclock += (uint64_t)msec * 1000;
+	return msec;
+}
+
+/*
+* Qcommon_FrameDeadline
+*
+* Returns the microsecond time at which frames will have advanced by msec.
+*/
+uint64_t Qcommon_FrameDeadline( unsigned int msec ) {
+	return com_frameclock + (uint64_t)msec * 1000;
+}
+
 /*
 * Qcommon_Frame
 */
@@ -851,6 +1254,11 @@ void Qcommon_Frame( unsigned int realMsec ) {
 		c_pointcontents = 0;
 	}
 
+	// 1 - number of cvar lookups by name per frame, 2 - also list the names
+	Cvar_ReportLookups( com_showcvarlookups->integer );
+
+	Cvar_FreeRetiredStrings();
+
 	wswcurl_perform();
 
 	FS_Frame();
@@ -922,6 +1330,8 @@ void Qcommon_Shutdown( void ) {
 	NET_Shutdown();
 	Key_Shutdown();
 
+	QJobs_Shutdown();
+
 	Steam_UnloadLibrary();
 
 	Com_Autoupdate_Shutdown();
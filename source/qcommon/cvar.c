@@ -27,6 +27,26 @@ static bool cvar_preinitialized = false;
 
 static trie_t *cvar_trie = NULL;
 static qmutex_t *cvar_mutex = NULL;
+
+// name lookups since the last call to Cvar_ReportLookups, updated under cvar_mutex
+#define CVAR_MAX_TRACKED_LOOKUPS 32
+typedef struct {
+	const cvar_t *var;
+	unsigned count;
+} cvar_lookup_t;
+
+static unsigned cvar_numLookups;
+static bool cvar_trackLookups;
+static int cvar_numTrackedLookups;
+static cvar_lookup_t cvar_trackedLookups[CVAR_MAX_TRACKED_LOOKUPS];
+
+// replaced cvar strings, freed two calls to Cvar_FreeRetiredStrings later
+typedef struct cvar_retired_s {
+	char *string;
+	struct cvar_retired_s *next;
+} cvar_retired_t;
+
+static cvar_retired_t *cvar_retired[2];
 static const trie_casing_t CVAR_TRIE_CASING = CON_CASE_SENSITIVE ? TRIE_CASE_SENSITIVE : TRIE_CASE_INSENSITIVE;
 
 static int Cvar_HasFlags( void *cvar, void *flags ) {
@@ -61,6 +81,167 @@ static bool Cvar_InfoValidate( const char *s, bool name ) {
 			  ( name && strchr( s, Q_COLOR_ESCAPE ) ) );
 }
 
+/*
+* Cvar_RetireString
+*
+* Keeps the old string of a cvar alive for another frame, so that other
+* threads which have just read the string pointer can still use it.
+*/
+static void Cvar_RetireString( char *string ) {
+	cvar_retired_t *retired;
+
+	if( !cvar_mutex ) {
+		Mem_ZoneFree( string );
+		return;
+	}
+
+	retired = Mem_ZoneMalloc( sizeof( *retired ) );
+	retired->string = string;
+
+	QMutex_Lock( cvar_mutex );
+	retired->next = cvar_retired[0];
+	cvar_retired[0] = retired;
+	QMutex_Unlock( cvar_mutex );
+}
+
+/*
+* Cvar_FreeRetiredStrings
+*
+* Called once per frame. Frees the strings replaced before the previous call.
+*/
+void Cvar_FreeRetiredStrings( void ) {
+	cvar_retired_t *retired, *next;
+
+	QMutex_Lock( cvar_mutex );
+	retired = cvar_retired[1];
+	cvar_retired[1] = cvar_retired[0];
+	cvar_retired[0] = NULL;
+	QMutex_Unlock( cvar_mutex );
+
+	for( ; retired; retired = next ) {
+		next = retired->next;
+		Mem_ZoneFree( retired->string );
+		Mem_ZoneFree( retired );
+	}
+}
+
+/*
+* Cvar_SetString
+*
+* Takes ownership of the string. The new values are written between two
+* increments of the sequence counter, which Cvar_ReadNumbers uses to read
+* value and integer without locks and without seeing them out of sync. The
+* atomic increments also order the stores, so the new string pointer is never
+* visible before its values. The old string is retired rather than freed.
+*/
+static void Cvar_SetString( cvar_t *var, char *string ) {
+	char *old = var->string;
+	float value = atof( string );
+
+	QAtomic_Add( &var->sequence, 1 );
+	var->value = value;
+	var->integer = Q_rint( value );
+	var->string = string;
+	QAtomic_Add( &var->sequence, 1 );
+
+	if( old ) {
+		Cvar_RetireString( old );
+	}
+}
+
+/*
+* Cvar_ReadNumbers
+*
+* Reads the numeric values of a cvar without locking, for threads other
+* than the one setting cvars. Either pointer may be NULL.
+*/
+void Cvar_ReadNumbers( const cvar_t *var, float *value, int *integer ) {
+	volatile int *sequence = (volatile int *)&var->sequence;
+	int start;
+	float v;
+	int i;
+
+	do {
+		start = QAtomic_Add( sequence, 0 );
+		v = var->value;
+		i = var->integer;
+	} while( ( start & 1 ) || QAtomic_Add( sequence, 0 ) != start );
+
+	if( value ) {
+		*value = v;
+	}
+	if( integer ) {
+		*integer = i;
+	}
+}
+
+/*
+* Cvar_CountLookup
+*
+* Must be called with cvar_mutex locked
+*/
+static void Cvar_CountLookup( const cvar_t *var ) {
+	int i;
+
+	cvar_numLookups++;
+	if( !cvar_trackLookups ) {
+		return;
+	}
+
+	for( i = 0; i < cvar_numTrackedLookups; i++ ) {
+		if( cvar_trackedLookups[i].var == var ) {
+			cvar_trackedLookups[i].count++;
+			return;
+		}
+	}
+	if( cvar_numTrackedLookups < CVAR_MAX_TRACKED_LOOKUPS ) {
+		cvar_trackedLookups[cvar_numTrackedLookups].var = var;
+		cvar_trackedLookups[cvar_numTrackedLookups].count = 1;
+		cvar_numTrackedLookups++;
+	}
+}
+
+/*
+* Cvar_ReportLookups
+*
+* Prints the number of cvar lookups by name since the last call and resets
+* the counters. Code running every frame should keep the cvar_t pointers
+* returned by Cvar_Get instead of looking variables up by name.
+*/
+void Cvar_ReportLookups( int verbosity ) {
+	int i;
+	unsigned numLookups;
+	int numTracked;
+	struct {
+		unsigned count;
+		char name[MAX_QPATH];
+	} tracked[CVAR_MAX_TRACKED_LOOKUPS];
+
+	// copy the counters out so that printing doesn't happen under cvar_mutex
+	QMutex_Lock( cvar_mutex );
+
+	numLookups = cvar_numLookups;
+	numTracked = verbosity > 0 ? cvar_numTrackedLookups : 0;
+	for( i = 0; i < numTracked; i++ ) {
+		const cvar_t *var = cvar_trackedLookups[i].var;
+		tracked[i].count = cvar_trackedLookups[i].count;
+		Q_strncpyz( tracked[i].name, var ? var->name : "(undefined)", sizeof( tracked[i].name ) );
+	}
+
+	cvar_numLookups = 0;
+	cvar_numTrackedLookups = 0;
+	cvar_trackLookups = verbosity > 1;
+
+	QMutex_Unlock( cvar_mutex );
+
+	if( verbosity > 0 && numLookups ) {
+		Com_Printf( "%4u cvar lookups\n", numLookups );
+		for( i = 0; i < numTracked; i++ ) {
+			Com_Printf( "%4u %s\n", tracked[i].count, tracked[i].name );
+		}
+	}
+}
+
 /*
 * Cvar_Initialized
 */
@@ -76,6 +257,7 @@ cvar_t *Cvar_Find( const char *var_name ) {
 	assert( cvar_trie );
 	QMutex_Lock( cvar_mutex );
 	Trie_Find( cvar_trie, var_name, TRIE_EXACT_MATCH, (void **)&cvar );
+	Cvar_CountLookup( cvar );
 	QMutex_Unlock( cvar_mutex );
 	return cvar;
 }
@@ -87,7 +269,7 @@ cvar_t *Cvar_Find( const char *var_name ) {
 float Cvar_Value( const char *var_name ) {
 	const cvar_t *const var = Cvar_Find( var_name );
 	return var
-		   ? atof( var->string )
+		   ? var->value
 		   : 0;
 }
 
@@ -137,6 +319,7 @@ cvar_t *Cvar_Get( const char *var_name, const char *var_value, cvar_flag_t flags
 	assert( cvar_trie );
 	QMutex_Lock( cvar_mutex );
 	Trie_Find( cvar_trie, var_name, TRIE_EXACT_MATCH, (void **)&var );
+	Cvar_CountLookup( var );
 	QMutex_Unlock( cvar_mutex );
 
 	if( !var_value ) {
@@ -166,12 +349,7 @@ cvar_t *Cvar_Get( const char *var_name, const char *var_value, cvar_flag_t flags
 #endif
 		if( reset ) {
 			if( !var->string || strcmp( var->string, var_value ) ) {
-				if( var->string ) {
-					Mem_ZoneFree( var->string );
-				}
-				var->string = ZoneCopyString( (char *) var_value );
-				var->value = atof( var->string );
-				var->integer = Q_rint( var->value );
+				Cvar_SetString( var, ZoneCopyString( (char *) var_value ) );
 			}
 			var->flags = flags;
 		}
@@ -273,10 +451,7 @@ static cvar_t *Cvar_Set2( const char *var_name, const char *value, bool force )
 						Mem_ZoneFree( new_dir );
 						return var;
 					}
-					Mem_ZoneFree( var->string ); // free the old value string
-					var->string = ZoneCopyString( value );
-					var->value = atof( var->string );
-					var->integer = Q_rint( var->value );
+					Cvar_SetString( var, ZoneCopyString( value ) );
 					Cvar_SetModified( var );
 				}
 			}
@@ -297,11 +472,7 @@ static cvar_t *Cvar_Set2( const char *var_name, const char *value, bool force )
 		userinfo_modified = true; // transmit at next oportunity
 
 	}
-	Mem_ZoneFree( var->string ); // free the old value string
-
-	var->string = ZoneCopyString( (char *) value );
-	var->value = atof( var->string );
-	var->integer = Q_rint( var->value );
+	Cvar_SetString( var, ZoneCopyString( (char *) value ) );
 	Cvar_SetModified( var );
 
 	return var;
@@ -387,11 +558,8 @@ void Cvar_GetLatchedVars( cvar_flag_t flags ) {
 		if( !strcmp( var->name, "fs_game" ) ) {
 			changedGameDir = var;
 		}
-		Mem_ZoneFree( var->string );
-		var->string = var->latched_string;
+		Cvar_SetString( var, var->latched_string );
 		var->latched_string = NULL;
-		var->value = atof( var->string );
-		var->integer = Q_rint( var->value );
 	}
 	Trie_FreeDump( dump );
 
@@ -420,10 +588,7 @@ void Cvar_FixCheatVars( void ) {
 	QMutex_Unlock( cvar_mutex );
 	for( i = 0; i < dump->size; ++i ) {
 		cvar_t *const var = (cvar_t *) dump->key_value_vector[i].value;
-		Mem_ZoneFree( var->string );
-		var->string = ZoneCopyString( var->dvalue );
-		var->value = atof( var->string );
-		var->integer = Q_rint( var->value );
+		Cvar_SetString( var, ZoneCopyString( var->dvalue ) );
 	}
 	Trie_FreeDump( dump );
 }
@@ -922,6 +1087,9 @@ void Cvar_Shutdown( void ) {
 		}
 		Trie_FreeDump( dump );
 
+		Cvar_FreeRetiredStrings();
+		Cvar_FreeRetiredStrings();
+
 		cvar_initialized = false;
 	}
 
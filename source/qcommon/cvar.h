@@ -67,6 +67,9 @@ const char *Cvar_String( const char *var_name );
 int     Cvar_Integer( const char *var_name );
 void        Cmd_WriteAliases( int file );
 cvar_t      *Cvar_Find( const char *var_name );
+void        Cvar_ReportLookups( int verbosity );
+void        Cvar_FreeRetiredStrings( void );
+void        Cvar_ReadNumbers( const cvar_t *var, float *value, int *integer );
 int     Cvar_CompleteCountPossible( const char *partial );
 char **Cvar_CompleteBuildList( const char *partial );
 char *Cvar_TabComplete( const char *partial );
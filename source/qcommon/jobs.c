@@ -0,0 +1,597 @@
+/*
+Copyright (C) 2026 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// jobs.c -- work-stealing job system
+//
+// Every worker thread owns a deque of jobs: the owner pushes and pops jobs
+// at the bottom, idle workers steal from the top. Deque 0 is shared by all
+// threads outside of the pool, they submit jobs there. Threads waiting on a
+// counter claim one of the helper slots for the duration of the wait and
+// execute jobs as its owner, so every slot is used by one thread at a time.
+// Deques are guarded by tiny spin locks, which keeps them simple and portable
+// while contention stays low because threads mostly work on their own deque.
+//
+// Parallel-for jobs are split in halves when executed, the upper halves are
+// pushed onto the deque of the executing thread, so the biggest chunks of
+// work are the first to be stolen.
+
+#include "qcommon.h"
+#include "sys_threads.h"
+
+#define MAX_JOB_THREADS     32
+#define JOB_DEQUE_SIZE      1024    // must be a power of two
+#define JOB_IDLE_SPINS      64      // yields before a worker goes to sleep
+#define JOB_SLEEP_MSEC      100
+#define JOB_HELPER_SLOTS    4       // threads outside of the pool executing jobs at once
+
+typedef struct {
+	qjobfunc_t func;
+	qjobrangefunc_t rangeFunc;
+	void *arg;
+	unsigned first;
+	unsigned count;
+	unsigned grain;
+	qjobcounter_t *counter;
+} qjob_t;
+
+// a job waiting for another counter to reach zero
+typedef struct qjobwaiter_s {
+	qjob_t job;
+	struct qjobwaiter_s *next;
+} qjobwaiter_t;
+
+typedef struct {
+	volatile int lock;
+	unsigned top;       // stolen from
+	unsigned bottom;    // pushed to and popped from by the owner
+	qjob_t jobs[JOB_DEQUE_SIZE];
+} qjobdeque_t;
+
+typedef struct {
+	unsigned executed;
+	unsigned stolen;
+	unsigned splits;
+	unsigned sleeps;
+	uint64_t busyTime;
+} qjobstats_t;
+
+typedef struct {
+	int num;
+	qthread_t *thread;
+	volatile int busy;      // helper slots only, set while claimed by a waiting thread
+	qjobstats_t stats;
+	qjobdeque_t deque;
+} qjobworker_t;
+
+static int jobs_numThreads;
+static int jobs_numSlots;
+static qjobworker_t *jobs_workers;  // the shared slot, then jobs_numThreads workers and JOB_HELPER_SLOTS helpers
+
+static volatile int jobs_queued;
+static volatile int jobs_sleeping;
+static volatile int jobs_quit;
+
+static qmutex_t *jobs_mutex;
+static qcondvar_t *jobs_condvar;
+static qmutex_t *jobs_waitersMutex;
+
+static cvar_t *com_jobthreads;
+
+static void QJobs_Execute( qjobworker_t *worker, qjob_t *job );
+
+/*
+* QJobs_LockDeque
+*/
+static void QJobs_LockDeque( qjobdeque_t *deque ) {
+	while( !Sys_Atomic_CAS( &deque->lock, 0, 1 ) ) {
+		QThread_Yield();
+	}
+}
+
+/*
+* QJobs_UnlockDeque
+*/
+static void QJobs_UnlockDeque( qjobdeque_t *deque ) {
+	Sys_Atomic_CAS( &deque->lock, 1, 0 );
+}
+
+/*
+* QJobs_PushJob
+*
+* Returns false if the deque is full.
+*/
+static bool QJobs_PushJob( qjobdeque_t *deque, const qjob_t *job ) {
+	bool pushed = false;
+
+	Sys_Atomic_Add( &jobs_queued, 1 );
+
+	QJobs_LockDeque( deque );
+	if( deque->bottom - deque->top < JOB_DEQUE_SIZE ) {
+		deque->jobs[deque->bottom & ( JOB_DEQUE_SIZE - 1 )] = *job;
+		deque->bottom++;
+		pushed = true;
+	}
+	QJobs_UnlockDeque( deque );
+
+	if( !pushed ) {
+		Sys_Atomic_Add( &jobs_queued, -1 );
+		return false;
+	}
+
+	// wake up a sleeping worker, which is going to wake up another one
+	// if there's still work left after it splits the job
+	if( !Sys_Atomic_CAS( &jobs_sleeping, 0, 0 ) ) {
+		QMutex_Lock( jobs_mutex );
+		QCondVar_Wake( jobs_condvar );
+		QMutex_Unlock( jobs_mutex );
+	}
+
+	return true;
+}
+
+/*
+* QJobs_PopJob
+*/
+static bool QJobs_PopJob( qjobdeque_t *deque, qjob_t *job ) {
+	bool popped = false;
+
+	if( deque->top == deque->bottom ) {
+		return false;
+	}
+
+	QJobs_LockDeque( deque );
+	if( deque->top != deque->bottom ) {
+		deque->bottom--;
+		*job = deque->jobs[deque->bottom & ( JOB_DEQUE_SIZE - 1 )];
+		popped = true;
+	}
+	QJobs_UnlockDeque( deque );
+
+	if( popped ) {
+		Sys_Atomic_Add( &jobs_queued, -1 );
+	}
+	return popped;
+}
+
+/*
+* QJobs_StealJob
+*/
+static bool QJobs_StealJob( qjobdeque_t *deque, qjob_t *job ) {
+	bool stolen = false;
+
+	if( deque->top == deque->bottom ) {
+		return false;
+	}
+
+	QJobs_LockDeque( deque );
+	if( deque->top != deque->bottom ) {
+		*job = deque->jobs[deque->top & ( JOB_DEQUE_SIZE - 1 )];
+		deque->top++;
+		stolen = true;
+	}
+	QJobs_UnlockDeque( deque );
+
+	if( stolen ) {
+		Sys_Atomic_Add( &jobs_queued, -1 );
+	}
+	return stolen;
+}
+
+/*
+* QJobs_TakeJob
+*
+* Takes the most recently pushed job of the worker or steals the
+* oldest job of another one.
+*/
+static bool QJobs_TakeJob( qjobworker_t *worker, qjob_t *job ) {
+	int i, numDeques = jobs_numSlots;
+
+	if( QJobs_PopJob( &worker->deque, job ) ) {
+		return true;
+	}
+
+	for( i = 1; i < numDeques; i++ ) {
+		qjobworker_t *victim = &jobs_workers[( worker->num + i ) % numDeques];
+		if( QJobs_StealJob( &victim->deque, job ) ) {
+			worker->stats.stolen++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+* QJobs_Submit
+*/
+static void QJobs_Submit( qjobworker_t *worker, qjob_t *job ) {
+	if( !QJobs_PushJob( &worker->deque, job ) ) {
+		QJobs_Execute( worker, job );
+	}
+}
+
+/*
+* QJobs_Complete
+*
+* Decrements the counter, the last job to complete releases the jobs which
+* have been waiting for the counter. The final decrement happens under the
+* waiters mutex after the waiters have been taken, since the counter may go
+* out of scope as soon as a thread waiting on it sees it reach zero.
+*/
+static void QJobs_Complete( qjobworker_t *worker, qjobcounter_t *counter ) {
+	int pending;
+	qjobwaiter_t *waiter, *next;
+
+	if( !counter ) {
+		return;
+	}
+
+	for( ;; ) {
+		pending = Sys_Atomic_Add( &counter->pending, 0 );
+		if( pending != 1 ) {
+			if( Sys_Atomic_CAS( &counter->pending, pending, pending - 1 ) ) {
+				return;
+			}
+			continue;
+		}
+
+		// publishing zero must be the last access to the counter
+		QMutex_Lock( jobs_waitersMutex );
+		waiter = counter->waiters;
+		counter->waiters = NULL;
+		if( Sys_Atomic_CAS( &counter->pending, 1, 0 ) ) {
+			QMutex_Unlock( jobs_waitersMutex );
+			break;
+		}
+		counter->waiters = waiter;
+		QMutex_Unlock( jobs_waitersMutex );
+	}
+
+	for( ; waiter; waiter = next ) {
+		next = waiter->next;
+		QJobs_Submit( worker, &waiter->job );
+		Q_free( waiter );
+	}
+}
+
+/*
+* QJobs_Execute
+*/
+static void QJobs_Execute( qjobworker_t *worker, qjob_t *job ) {
+	uint64_t start = Sys_Microseconds();
+
+	if( job->rangeFunc ) {
+		// split the range, keeping the smallest part for ourselves
+		while( job->count > job->grain ) {
+			qjob_t half = *job;
+			unsigned count = job->count / 2;
+
+			half.first = job->first + count;
+			half.count = job->count - count;
+
+			if( job->counter ) {
+				Sys_Atomic_Add( &job->counter->pending, 1 );
+			}
+			if( !QJobs_PushJob( &worker->deque, &half ) ) {
+				if( job->counter ) {
+					Sys_Atomic_Add( &job->counter->pending, -1 );
+				}
+				break;
+			}
+
+			job->count = count;
+			if( worker->num ) {
+				worker->stats.splits++;
+			}
+		}
+
+		job->rangeFunc( job->first, job->count, job->arg );
+	} else {
+		job->func( job->arg );
+	}
+
+	// the shared slot only executes jobs when its deque overflows, from
+	// any thread, so it keeps no statistics
+	if( worker->num ) {
+		worker->stats.executed++;
+		worker->stats.busyTime += Sys_Microseconds() - start;
+	}
+
+	QJobs_Complete( worker, job->counter );
+}
+
+/*
+* QJobs_WorkerProc
+*/
+static void *QJobs_WorkerProc( void *param ) {
+	int spins = 0;
+	qjob_t job;
+	qjobworker_t *worker = param;
+
+	while( !jobs_quit ) {
+		if( QJobs_TakeJob( worker, &job ) ) {
+			QJobs_Execute( worker, &job );
+			spins = 0;
+			continue;
+		}
+
+		if( ++spins < JOB_IDLE_SPINS ) {
+			QThread_Yield();
+			continue;
+		}
+		spins = 0;
+
+		// announce we're going to sleep before checking for new jobs, so that
+		// either we see the job or the thread pushing it sees us sleeping
+		QMutex_Lock( jobs_mutex );
+		Sys_Atomic_Add( &jobs_sleeping, 1 );
+		if( Sys_Atomic_CAS( &jobs_queued, 0, 0 ) && !jobs_quit ) {
+			QCondVar_Wait( jobs_condvar, jobs_mutex, JOB_SLEEP_MSEC );
+			worker->stats.sleeps++;
+		}
+		Sys_Atomic_Add( &jobs_sleeping, -1 );
+		QMutex_Unlock( jobs_mutex );
+	}
+
+	return NULL;
+}
+
+/*
+* QJobs_NumThreads
+*
+* Returns the number of worker threads, the threads waiting on
+* counters execute jobs as well.
+*/
+int QJobs_NumThreads( void ) {
+	return jobs_numThreads;
+}
+
+/*
+* QJobs_Add
+*
+* Adds a job, which is going to be executed after the dependency counter
+* reaches zero if the dependency is not NULL. The counter is incremented
+* now and decremented once the job is done, it may be NULL too.
+*/
+void QJobs_Add( qjobcounter_t *counter, qjobcounter_t *dependency, qjobfunc_t func, void *arg ) {
+	qjob_t job;
+
+	if( !jobs_numThreads ) {
+		func( arg );
+		return;
+	}
+
+	memset( &job, 0, sizeof( job ) );
+	job.func = func;
+	job.arg = arg;
+	job.counter = counter;
+
+	if( counter ) {
+		Sys_Atomic_Add( &counter->pending, 1 );
+	}
+
+	if( dependency ) {
+		QMutex_Lock( jobs_waitersMutex );
+		if( !Sys_Atomic_CAS( &dependency->pending, 0, 0 ) ) {
+			qjobwaiter_t *waiter = Q_malloc( sizeof( *waiter ) );
+			waiter->job = job;
+			waiter->next = dependency->waiters;
+			dependency->waiters = waiter;
+			QMutex_Unlock( jobs_waitersMutex );
+			return;
+		}
+		QMutex_Unlock( jobs_waitersMutex );
+	}
+
+	QJobs_Submit( &jobs_workers[0], &job );
+}
+
+/*
+* QJobs_ParallelFor
+*
+* Calls func for all items in the [0, items) range in chunks. The chunk size
+* adapts to the number of threads but never goes below the grain, which should
+* be large enough for a chunk of work to outweigh the cost of scheduling it.
+*/
+void QJobs_ParallelFor( qjobcounter_t *counter, unsigned items, unsigned grain, qjobrangefunc_t func, void *arg ) {
+	unsigned adaptiveGrain;
+	qjob_t job;
+
+	if( !items ) {
+		return;
+	}
+
+	if( !jobs_numThreads ) {
+		func( 0, items, arg );
+		return;
+	}
+
+	// aim at a few chunks per thread so that the stragglers can be balanced
+	adaptiveGrain = items / ( ( jobs_numThreads + 1 ) * 4 );
+	if( adaptiveGrain < grain ) {
+		adaptiveGrain = grain;
+	}
+	if( adaptiveGrain < 1 ) {
+		adaptiveGrain = 1;
+	}
+
+	memset( &job, 0, sizeof( job ) );
+	job.rangeFunc = func;
+	job.arg = arg;
+	job.first = 0;
+	job.count = items;
+	job.grain = adaptiveGrain;
+	job.counter = counter;
+
+	if( counter ) {
+		Sys_Atomic_Add( &counter->pending, 1 );
+	}
+
+	QJobs_Submit( &jobs_workers[0], &job );
+}
+
+/*
+* QJobs_ClaimHelper
+*
+* Returns a free helper slot or NULL if all of them are in use.
+*/
+static qjobworker_t *QJobs_ClaimHelper( void ) {
+	int i;
+
+	for( i = jobs_numThreads + 1; i < jobs_numSlots; i++ ) {
+		if( Sys_Atomic_CAS( &jobs_workers[i].busy, 0, 1 ) ) {
+			return &jobs_workers[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+* QJobs_Wait
+*
+* Executes jobs until the counter reaches zero. The calling thread helps
+* through a helper slot of its own, or just yields if none is free.
+*/
+void QJobs_Wait( qjobcounter_t *counter ) {
+	qjob_t job;
+	qjobworker_t *helper = NULL;
+
+	while( !Sys_Atomic_CAS( &counter->pending, 0, 0 ) ) {
+		if( !helper ) {
+			helper = QJobs_ClaimHelper();
+		}
+		if( helper && QJobs_TakeJob( helper, &job ) ) {
+			QJobs_Execute( helper, &job );
+			continue;
+		}
+		QThread_Yield();
+	}
+
+	// jobs left in the deque of the helper are stolen by the workers
+	// or picked up by the next thread to claim the slot
+	if( helper ) {
+		Sys_Atomic_CAS( &helper->busy, 1, 0 );
+	}
+}
+
+/*
+* QJobs_Stats_f
+*/
+static void QJobs_Stats_f( void ) {
+	int i;
+	qjobstats_t total;
+
+	memset( &total, 0, sizeof( total ) );
+
+	Com_Printf( "%-8s %10s %10s %10s %10s %10s\n", "thread", "executed", "stolen", "splits", "sleeps", "busy ms" );
+	for( i = 1; i < jobs_numSlots; i++ ) {
+		qjobstats_t *stats = &jobs_workers[i].stats;
+
+		Com_Printf( "%-8s %10u %10u %10u %10u %10.1f\n",
+					i <= jobs_numThreads ? va( "%i", i ) : va( "wait%i", i - jobs_numThreads ),
+					stats->executed, stats->stolen, stats->splits, stats->sleeps, stats->busyTime / 1000.0 );
+
+		total.executed += stats->executed;
+		total.stolen += stats->stolen;
+		total.splits += stats->splits;
+		total.sleeps += stats->sleeps;
+		total.busyTime += stats->busyTime;
+
+		if( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+			memset( stats, 0, sizeof( *stats ) );
+		}
+	}
+
+	Com_Printf( "%-8s %10u %10u %10u %10u %10.1f\n", "total",
+				total.executed, total.stolen, total.splits, total.sleeps, total.busyTime / 1000.0 );
+}
+
+/*
+* QJobs_Init
+*/
+void QJobs_Init( void ) {
+	int i, numThreads;
+
+	// -1 is one worker less than the number of cores as the main thread helps too
+	com_jobthreads = Cvar_Get( "com_jobthreads", "-1", CVAR_ARCHIVE );
+
+	numThreads = com_jobthreads->integer;
+	if( numThreads < 0 ) {
+		numThreads = Sys_Thread_NumProcessors() - 1;
+	}
+	Q_clamp( numThreads, 0, MAX_JOB_THREADS );
+
+	jobs_quit = 0;
+	jobs_queued = jobs_sleeping = 0;
+	jobs_mutex = QMutex_Create();
+	jobs_condvar = QCondVar_Create();
+	jobs_waitersMutex = QMutex_Create();
+
+	jobs_numSlots = numThreads + 1 + JOB_HELPER_SLOTS;
+	jobs_workers = Q_malloc( sizeof( *jobs_workers ) * jobs_numSlots );
+	memset( jobs_workers, 0, sizeof( *jobs_workers ) * jobs_numSlots );
+
+	for( i = 0; i < jobs_numSlots; i++ ) {
+		jobs_workers[i].num = i;
+	}
+	for( i = 1; i <= numThreads; i++ ) {
+		jobs_workers[i].thread = QThread_Create( QJobs_WorkerProc, &jobs_workers[i] );
+	}
+
+	jobs_numThreads = numThreads;
+
+	Cmd_AddCommand( "jobstats", QJobs_Stats_f );
+
+	Com_Printf( "Job system: %i worker threads\n", numThreads );
+}
+
+/*
+* QJobs_Shutdown
+*/
+void QJobs_Shutdown( void ) {
+	int i, numThreads = jobs_numThreads;
+
+	if( !jobs_workers ) {
+		return;
+	}
+
+	Cmd_RemoveCommand( "jobstats" );
+
+	// run inline from now on
+	jobs_numThreads = 0;
+
+	jobs_quit = 1;
+	QMutex_Lock( jobs_mutex );
+	for( i = 1; i <= numThreads; i++ ) {
+		QCondVar_Wake( jobs_condvar );
+	}
+	QMutex_Unlock( jobs_mutex );
+
+	for( i = 1; i <= numThreads; i++ ) {
+		QThread_Join( jobs_workers[i].thread );
+	}
+
+	Q_free( jobs_workers );
+	jobs_workers = NULL;
+
+	QMutex_Destroy( &jobs_waitersMutex );
+	QCondVar_Destroy( &jobs_condvar );
+	QMutex_Destroy( &jobs_mutex );
+}
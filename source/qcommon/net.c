@@ -1702,6 +1702,15 @@ int NET_SetSocketNoDelay( socket_t *socket, int nodelay ) {
 * NET_Sleep
 */
 void NET_Sleep( int msec, socket_t *sockets[] ) {
+	NET_SleepMicroseconds( (uint64_t)msec * 1000, sockets );
+}
+
+/*
+* NET_SleepMicroseconds
+*
+* Waits until there's data on one of the sockets or the timeout expires
+*/
+void NET_SleepMicroseconds( uint64_t usec, socket_t *sockets[] ) {
 	struct timeval timeout;
 	fd_set fdset;
 	int i;
@@ -1730,8 +1739,8 @@ void NET_Sleep( int msec, socket_t *sockets[] ) {
 		}
 	}
 
-	timeout.tv_sec = msec / 1000;
-	timeout.tv_usec = ( msec % 1000 ) * 1000;
+	timeout.tv_sec = usec / 1000000;
+	timeout.tv_usec = usec % 1000000;
 	select( FD_SETSIZE, &fdset, NULL, NULL, &timeout );
 }
 
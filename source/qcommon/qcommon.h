@@ -152,7 +152,11 @@ void SNAP_BuildClientFrameSnap( struct cmodel_state_s *cms, struct ginfo_s *gi,
 
 void SNAP_FreeClientFrames( struct client_s *client );
 
-void SNAP_RecordDemoMessage( int demofile, msg_t *msg, int offset );
+bool SNAP_RecordDemoMessage( int demofile, msg_t *msg, int offset );
+bool SNAP_AttachDemoWriter( int demofile, size_t maxQueued );
+bool SNAP_CloseDemoWriter( int demofile, bool cancel, const char *tempname, const char *filename,
+						   const char *meta_data, size_t meta_data_realsize );
+void SNAP_ShutdownDemoWriters( void );
 int SNAP_ReadDemoMessage( int demofile, msg_t *msg );
 void SNAP_BeginDemoRecording( int demofile, unsigned int spawncount, unsigned int snapFrameTime,
 							  const char *sv_name, unsigned int sv_bitflags, purelist_t *purelist,
@@ -482,6 +486,7 @@ int         NET_Send( const socket_t *socket, const void *data, size_t length, c
 int64_t     NET_SendFile( const socket_t *socket, int file, size_t offset, size_t count, const netadr_t *address );
 
 void        NET_Sleep( int msec, socket_t *sockets[] );
+void        NET_SleepMicroseconds( uint64_t usec, socket_t *sockets[] );
 int         NET_Monitor( int msec, socket_t *sockets[],
 						 void ( *read_cb )( socket_t *socket, void* ),
 						 void ( *write_cb )( socket_t *socket, void* ),
@@ -702,14 +707,23 @@ void        Com_BeginRedirect( int target, char *buffer, int buffersize,
 void        Com_EndRedirect( void );
 void        Com_DeferConsoleLogReopen( void );
 
+typedef enum {
+	COM_LOG_DEBUG,
+	COM_LOG_INFO,
+	COM_LOG_WARNING,
+	COM_LOG_ERROR
+} com_log_severity_t;
+
 #ifndef _MSC_VER
 void Com_Printf( const char *format, ... ) __attribute__( ( format( printf, 1, 2 ) ) );
 void Com_DPrintf( const char *format, ... ) __attribute__( ( format( printf, 1, 2 ) ) );
+void Com_LogPrintf( const char *subsystem, com_log_severity_t severity, int client, const char *format, ... ) __attribute__( ( format( printf, 4, 5 ) ) );
 void Com_Error( com_error_code_t code, const char *format, ... ) __attribute__( ( format( printf, 2, 3 ) ) ) __attribute__( ( noreturn ) );
 void Com_Quit( void ) __attribute__( ( noreturn ) );
 #else
 void Com_Printf( _Printf_format_string_ const char *format, ... );
 void Com_DPrintf( _Printf_format_string_ const char *format, ... );
+void Com_LogPrintf( const char *subsystem, com_log_severity_t severity, int client, _Printf_format_string_ const char *format, ... );
 __declspec( noreturn ) void Com_Error( com_error_code_t code, _Printf_format_string_ const char *format, ... );
 __declspec( noreturn ) void Com_Quit( void );
 #endif
@@ -732,6 +746,7 @@ unsigned int Com_DaysSince1900( void );
 extern cvar_t *developer;
 extern cvar_t *dedicated;
 extern cvar_t *host_speeds;
+extern cvar_t *timescale;
 extern cvar_t *versioncvar;
 
 // host_speeds times
@@ -817,6 +832,8 @@ void Q_free( void *buf );
 
 void Qcommon_Init( int argc, char **argv );
 void Qcommon_Frame( unsigned int realMsec );
+unsigned int Qcommon_FrameMsec( void );
+uint64_t Qcommon_FrameDeadline( unsigned int msec );
 void Qcommon_Shutdown( void );
 
 /*
@@ -875,14 +892,6 @@ CPU FEATURES
 ==============================================================
 */
 
-#define QCPU_HAS_RDTSC      0x00000001
-#define QCPU_HAS_MMX        0x00000002
-#define QCPU_HAS_MMXEXT     0x00000004
-#define QCPU_HAS_3DNOW      0x00000010
-#define QCPU_HAS_3DNOWEXT   0x00000020
-#define QCPU_HAS_SSE        0x00000040
-#define QCPU_HAS_SSE2       0x00000080
-
 unsigned int COM_CPUFeatures( void );
 
 /*
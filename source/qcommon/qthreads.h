@@ -56,11 +56,22 @@ qbufPipe_t *QBufPipe_Create( size_t bufSize, int flags );
 void QBufPipe_Destroy( qbufPipe_t **pqueue );
 void QBufPipe_Finish( qbufPipe_t *queue );
 void QBufPipe_WriteCmd( qbufPipe_t *queue, const void *cmd, unsigned cmd_size );
+bool QBufPipe_TryWriteCmd( qbufPipe_t *queue, const void *cmd, unsigned cmd_size );
 int QBufPipe_ReadCmds( qbufPipe_t *queue, unsigned( **cmdHandlers )( const void * ) );
 void QBufPipe_Wait( qbufPipe_t *queue, int ( *read )( qbufPipe_t *, unsigned( ** )( const void * ), bool ),
 					unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec );
+#ifndef PUBLIC_BUILD
+void QBufPipe_Bench_f( void );
+#endif
 
 int QAtomic_Add( volatile int *value, int add );
 bool QAtomic_CAS( volatile int *value, int oldval, int newval );
 
+void QJobs_Init( void );
+void QJobs_Shutdown( void );
+int QJobs_NumThreads( void );
+void QJobs_Add( qjobcounter_t *counter, qjobcounter_t *dependency, qjobfunc_t func, void *arg );
+void QJobs_ParallelFor( qjobcounter_t *counter, unsigned items, unsigned grain, qjobrangefunc_t func, void *arg );
+void QJobs_Wait( qjobcounter_t *counter );
+
 #endif // Q_THREADS_H
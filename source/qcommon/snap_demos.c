@@ -20,35 +20,446 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "qcommon.h"
 
+// demo headers are never dropped by the writer, without them the demo is unplayable
 #define DEMO_SAFEWRITE( demofile,msg,force ) \
 	if( force || ( msg )->cursize > ( msg )->maxsize / 2 ) \
 	{ \
-		SNAP_RecordDemoMessage( demofile, msg, 0 ); \
+		SNAP_WriteDemoMessage( demofile, msg, 0, true ); \
 		MSG_Clear( msg ); \
 	}
 
 static char dummy_meta_data[SNAP_MAX_DEMO_META_DATA_SIZE];
 
 /*
-* SNAP_RecordDemoMessage
+* Asynchronous demo writer
 *
-* Writes given message to demofile
+* Demo data is queued to a background thread through a command pipe and
+* coalesced there into large sequential writes, so that a slow disk never
+* stalls the frame. The amount of queued data is bounded: when the writer
+* falls behind, messages are dropped with a warning instead of blocking.
+*/
+
+#define SNAP_MAX_DEMO_WRITERS       4
+#define SNAP_DEMO_WRITER_CHUNK      0x40000     // coalesce writes into 256KB chunks
+
+#define SNAP_DEMO_WRITER_ALIGN( x )   ( ( ( x ) + 7 ) & ~7 )
+
+enum {
+	DEMO_WRITER_CMD_WRITE,
+	DEMO_WRITER_CMD_FLUSH,
+	DEMO_WRITER_CMD_CLOSE,
+
+	NUM_DEMO_WRITER_CMDS
+};
+
+typedef struct snapDemoWriter_s {
+	int demofile;
+	qbufPipe_t *pipe;
+	qthread_t *thread;
+	volatile int queued;                // size of the commands pending in the pipe
+	int maxQueued;
+	volatile int finished;              // set by the writer thread once the file has been closed
+	bool closing;
+	bool overflow;
+	unsigned dropped;
+
+	// only touched by the writer thread
+	size_t chunkSize;
+	uint8_t *chunk;
+} snapDemoWriter_t;
+
+typedef struct {
+	int id;
+	int len;                            // followed by len bytes of data
+	snapDemoWriter_t *writer;
+} demoWriterWriteCmd_t;
+
+typedef struct {
+	int id;
+	snapDemoWriter_t *writer;
+} demoWriterFlushCmd_t;
+
+typedef struct {
+	int id;
+	bool cancel;
+	int meta_data_realsize;             // followed by meta data, temp and final file names
+	int tempname_size, filename_size;
+	snapDemoWriter_t *writer;
+} demoWriterCloseCmd_t;
+
+typedef unsigned (*demoWriterCmdHandler_t)( const void * );
+
+static snapDemoWriter_t *snap_demo_writers[SNAP_MAX_DEMO_WRITERS];
+
+// staging buffer for write commands, demos are only recorded from the main thread
+static uint8_t snap_demo_writer_cmdbuf[SNAP_DEMO_WRITER_ALIGN( sizeof( demoWriterWriteCmd_t ) + 4 + MAX_MSGLEN )];
+
+/*
+* SNAP_DemoWriterForFile
+*/
+static snapDemoWriter_t *SNAP_DemoWriterForFile( int demofile ) {
+	int i;
+
+	for( i = 0; i < SNAP_MAX_DEMO_WRITERS; i++ ) {
+		snapDemoWriter_t *writer = snap_demo_writers[i];
+		if( writer && !writer->closing && writer->demofile == demofile ) {
+			return writer;
+		}
+	}
+	return NULL;
+}
+
+/*
+* SNAP_DemoWriterFlushChunk
+*/
+static void SNAP_DemoWriterFlushChunk( snapDemoWriter_t *writer ) {
+	if( writer->chunkSize ) {
+		FS_Write( writer->chunk, writer->chunkSize, writer->demofile );
+		writer->chunkSize = 0;
+	}
+}
+
+/*
+* SNAP_DemoWriterHandleWriteCmd
 */
-void SNAP_RecordDemoMessage( int demofile, msg_t *msg, int offset ) {
+static unsigned SNAP_DemoWriterHandleWriteCmd( const void *pcmd ) {
+	const demoWriterWriteCmd_t *cmd = pcmd;
+	snapDemoWriter_t *writer = cmd->writer;
+	const uint8_t *data = (const uint8_t *)( cmd + 1 );
+	unsigned cmd_size = SNAP_DEMO_WRITER_ALIGN( sizeof( *cmd ) + cmd->len );
+
+	if( writer->chunkSize + cmd->len > SNAP_DEMO_WRITER_CHUNK ) {
+		SNAP_DemoWriterFlushChunk( writer );
+	}
+
+	if( cmd->len >= SNAP_DEMO_WRITER_CHUNK ) {
+		FS_Write( data, cmd->len, writer->demofile );
+	} else {
+		memcpy( writer->chunk + writer->chunkSize, data, cmd->len );
+		writer->chunkSize += cmd->len;
+	}
+
+	QAtomic_Add( &writer->queued, -(int)cmd_size );
+	return cmd_size;
+}
+
+/*
+* SNAP_DemoWriterHandleFlushCmd
+*/
+static unsigned SNAP_DemoWriterHandleFlushCmd( const void *pcmd ) {
+	const demoWriterFlushCmd_t *cmd = pcmd;
+	snapDemoWriter_t *writer = cmd->writer;
+
+	SNAP_DemoWriterFlushChunk( writer );
+	FS_Flush( writer->demofile );
+
+	QAtomic_Add( &writer->queued, -(int)sizeof( *cmd ) );
+	return sizeof( *cmd );
+}
+
+/*
+* SNAP_DemoWriterHandleCloseCmd
+*
+* Finalizes the demo file and terminates the writer thread.
+*/
+static unsigned SNAP_DemoWriterHandleCloseCmd( const void *pcmd ) {
+	const demoWriterCloseCmd_t *cmd = pcmd;
+	snapDemoWriter_t *writer = cmd->writer;
+	const char *meta_data = (const char *)( cmd + 1 );
+	const char *tempname = meta_data + cmd->meta_data_realsize;
+	const char *filename = tempname + cmd->tempname_size;
+
+	SNAP_DemoWriterFlushChunk( writer );
+	FS_FCloseFile( writer->demofile );
+
+	if( cmd->cancel ) {
+		if( !FS_RemoveFile( tempname ) ) {
+			Com_Printf( "Error: Failed to delete the temporary demo file: %s\n", tempname );
+		}
+	} else {
+		SNAP_WriteDemoMetaData( tempname, meta_data, cmd->meta_data_realsize );
+
+		if( !FS_MoveFile( tempname, filename ) ) {
+			Com_Printf( "Error: Failed to rename the demo file: %s\n", tempname );
+		}
+	}
+
+	// terminate the pipe
+	return 0;
+}
+
+/*
+* SNAP_DemoWriterCmdsWaiter
+*/
+static int SNAP_DemoWriterCmdsWaiter( qbufPipe_t *pipe, demoWriterCmdHandler_t *cmdHandlers, bool timeout ) {
+	return QBufPipe_ReadCmds( pipe, cmdHandlers );
+}
+
+/*
+* SNAP_DemoWriterThreadProc
+*/
+static void *SNAP_DemoWriterThreadProc( void *param ) {
+	snapDemoWriter_t *writer = param;
+	demoWriterCmdHandler_t cmdHandlers[NUM_DEMO_WRITER_CMDS] =
+	{
+		SNAP_DemoWriterHandleWriteCmd,
+		SNAP_DemoWriterHandleFlushCmd,
+		SNAP_DemoWriterHandleCloseCmd,
+	};
+
+	QBufPipe_Wait( writer->pipe, SNAP_DemoWriterCmdsWaiter, cmdHandlers, Q_THREADS_WAIT_INFINITE );
+
+	writer->finished = 1;
+	return NULL;
+}
+
+/*
+* SNAP_FreeDemoWriter
+*/
+static void SNAP_FreeDemoWriter( snapDemoWriter_t *writer ) {
+	QThread_Join( writer->thread );
+	QBufPipe_Destroy( &writer->pipe );
+	Mem_ZoneFree( writer );
+}
+
+/*
+* SNAP_ReapDemoWriters
+*
+* Releases writers which have finalized their files. If wait is true,
+* blocks until all pending writers are done.
+*/
+static void SNAP_ReapDemoWriters( bool wait ) {
+	int i;
+
+	for( i = 0; i < SNAP_MAX_DEMO_WRITERS; i++ ) {
+		snapDemoWriter_t *writer = snap_demo_writers[i];
+		if( !writer || !writer->closing ) {
+			continue;
+		}
+		if( !wait && !writer->finished ) {
+			continue;
+		}
+
+		SNAP_FreeDemoWriter( writer );
+		snap_demo_writers[i] = NULL;
+	}
+}
+
+/*
+* SNAP_AttachDemoWriter
+*
+* Starts a background writer thread for the demo file. All subsequent writes
+* to the file must go through SNAP_ functions, and the file must be closed
+* with SNAP_CloseDemoWriter. maxQueued is the maximum amount of data which
+* may be pending before messages are dropped.
+*/
+bool SNAP_AttachDemoWriter( int demofile, size_t maxQueued ) {
+	int i;
+	size_t pipeSize;
+	snapDemoWriter_t *writer;
+
+	if( !demofile || !maxQueued ) {
+		return false;
+	}
+
+	SNAP_ReapDemoWriters( false );
+
+	if( SNAP_DemoWriterForFile( demofile ) ) {
+		return true;
+	}
+
+	for( i = 0; i < SNAP_MAX_DEMO_WRITERS; i++ ) {
+		if( !snap_demo_writers[i] ) {
+			break;
+		}
+	}
+	if( i == SNAP_MAX_DEMO_WRITERS ) {
+		return false;
+	}
+
+	if( maxQueued < MAX_MSGLEN * 4 ) {
+		maxQueued = MAX_MSGLEN * 4;
+	}
+
+	// leave enough headroom in the pipe for the writer to never block on
+	// wraparound as long as the amount of queued data is within the limit
+	pipeSize = maxQueued + 4 * SNAP_DEMO_WRITER_ALIGN( sizeof( demoWriterCloseCmd_t ) + MAX_MSGLEN );
+
+	writer = Mem_ZoneMalloc( sizeof( *writer ) + SNAP_DEMO_WRITER_CHUNK );
+	writer->demofile = demofile;
+	writer->maxQueued = (int)maxQueued;
+	writer->chunk = (uint8_t *)( writer + 1 );
+	writer->pipe = QBufPipe_Create( pipeSize, 1 );
+	if( !writer->pipe ) {
+		Mem_ZoneFree( writer );
+		return false;
+	}
+	writer->thread = QThread_Create( SNAP_DemoWriterThreadProc, writer );
+
+	snap_demo_writers[i] = writer;
+	return true;
+}
+
+/*
+* SNAP_CloseDemoWriter
+*
+* Hands the demo file over to the writer thread which flushes all pending data,
+* closes the file, and then either removes it (cancel) or writes the meta data
+* and renames the temporary file to its final name. Returns false if the file
+* has no writer attached, in which case the caller must finalize it itself.
+*/
+bool SNAP_CloseDemoWriter( int demofile, bool cancel, const char *tempname, const char *filename,
+						   const char *meta_data, size_t meta_data_realsize ) {
+	uint8_t *buf;
+	size_t tempname_size, filename_size;
+	unsigned cmd_size;
+	demoWriterCloseCmd_t *cmd;
+	snapDemoWriter_t *writer = SNAP_DemoWriterForFile( demofile );
+
+	if( !writer ) {
+		return false;
+	}
+
+	if( meta_data_realsize > SNAP_MAX_DEMO_META_DATA_SIZE ) {
+		meta_data_realsize = SNAP_MAX_DEMO_META_DATA_SIZE;
+	}
+	tempname_size = strlen( tempname ) + 1;
+	filename_size = strlen( filename ) + 1;
+	cmd_size = SNAP_DEMO_WRITER_ALIGN( sizeof( *cmd ) + meta_data_realsize + tempname_size + filename_size );
+
+	buf = Mem_TempMalloc( cmd_size );
+	cmd = (demoWriterCloseCmd_t *)buf;
+	cmd->id = DEMO_WRITER_CMD_CLOSE;
+	cmd->cancel = cancel;
+	cmd->meta_data_realsize = (int)meta_data_realsize;
+	cmd->tempname_size = (int)tempname_size;
+	cmd->filename_size = (int)filename_size;
+	cmd->writer = writer;
+	buf += sizeof( *cmd );
+	memcpy( buf, meta_data, meta_data_realsize ); buf += meta_data_realsize;
+	memcpy( buf, tempname, tempname_size ); buf += tempname_size;
+	memcpy( buf, filename, filename_size );
+
+	QBufPipe_WriteCmd( writer->pipe, cmd, cmd_size );
+	Mem_TempFree( cmd );
+
+	if( writer->dropped ) {
+		Com_Printf( "Warning: %u messages were dropped from demo due to slow disk I/O\n", writer->dropped );
+	}
+
+	writer->closing = true;
+	return true;
+}
+
+/*
+* SNAP_ShutdownDemoWriters
+*
+* Waits for all pending demo files to be finalized.
+*/
+void SNAP_ShutdownDemoWriters( void ) {
+	SNAP_ReapDemoWriters( true );
+}
+
+/*
+* SNAP_WriteDemoData
+*
+* Writes raw data to the demofile, directly or through the writer thread.
+* Unless force is true, the data is dropped if the writer has too much
+* data pending.
+*/
+static bool SNAP_WriteDemoData( int demofile, const void *data1, int len1, const void *data2, int len2, bool force ) {
+	uint8_t *buf;
+	unsigned cmd_size;
+	demoWriterWriteCmd_t *cmd;
+	snapDemoWriter_t *writer = SNAP_DemoWriterForFile( demofile );
+
+	if( !writer ) {
+		FS_Write( data1, len1, demofile );
+		if( len2 ) {
+			FS_Write( data2, len2, demofile );
+		}
+		return true;
+	}
+
+	cmd_size = SNAP_DEMO_WRITER_ALIGN( sizeof( *cmd ) + len1 + len2 );
+	if( !force && writer->queued + (int)cmd_size > writer->maxQueued ) {
+		if( !writer->overflow ) {
+			Com_Printf( "Warning: demo writer is falling behind, dropping messages\n" );
+			writer->overflow = true;
+		}
+		writer->dropped++;
+		return false;
+	}
+	writer->overflow = false;
+
+	if( cmd_size > sizeof( snap_demo_writer_cmdbuf ) ) {
+		return false;
+	}
+
+	buf = snap_demo_writer_cmdbuf;
+	cmd = (demoWriterWriteCmd_t *)buf;
+	cmd->id = DEMO_WRITER_CMD_WRITE;
+	cmd->len = len1 + len2;
+	cmd->writer = writer;
+	memcpy( buf + sizeof( *cmd ), data1, len1 );
+	if( len2 ) {
+		memcpy( buf + sizeof( *cmd ) + len1, data2, len2 );
+	}
+
+	QAtomic_Add( &writer->queued, cmd_size );
+	QBufPipe_WriteCmd( writer->pipe, cmd, cmd_size );
+	return true;
+}
+
+/*
+* SNAP_FlushDemo
+*/
+static void SNAP_FlushDemo( int demofile ) {
+	demoWriterFlushCmd_t cmd;
+	snapDemoWriter_t *writer = SNAP_DemoWriterForFile( demofile );
+
+	if( !writer ) {
+		FS_Flush( demofile );
+		return;
+	}
+
+	cmd.id = DEMO_WRITER_CMD_FLUSH;
+	cmd.writer = writer;
+
+	QAtomic_Add( &writer->queued, sizeof( cmd ) );
+	QBufPipe_WriteCmd( writer->pipe, &cmd, sizeof( cmd ) );
+}
+
+/*
+* SNAP_WriteDemoMessage
+*
+* Writes given message to demofile, prefixed by length. Unless force is true,
+* the message is dropped if the demo writer is falling behind.
+*/
+static bool SNAP_WriteDemoMessage( int demofile, msg_t *msg, int offset, bool force ) {
 	int len;
 
 	if( !demofile ) {
-		return;
+		return false;
 	}
 
 	// now write the entire message to the file, prefixed by length
 	len = LittleLong( msg->cursize ) - offset;
 	if( len <= 0 ) {
-		return;
+		return true;
 	}
 
-	FS_Write( &len, 4, demofile );
-	FS_Write( msg->data + offset, len, demofile );
+	return SNAP_WriteDemoData( demofile, &len, 4, msg->data + offset, len, force );
+}
+
+/*
+* SNAP_RecordDemoMessage
+*
+* Writes given message to demofile. Returns false if the message
+* had to be dropped because the demo writer is falling behind.
+*/
+bool SNAP_RecordDemoMessage( int demofile, msg_t *msg, int offset ) {
+	return SNAP_WriteDemoMessage( demofile, msg, offset, false );
 }
 
 /*
@@ -128,11 +539,11 @@ static void SNAP_DemoMetaDataMessage( msg_t *msg, const char *meta_data, size_t
 * SNAP_RecordDemoMetaDataMessage
 */
 static void SNAP_RecordDemoMetaDataMessage( int demofile, msg_t *msg ) {
-	FS_Flush( demofile );
+	SNAP_FlushDemo( demofile );
 
 	DEMO_SAFEWRITE( demofile, msg, true );
 
-	FS_Flush( demofile );
+	SNAP_FlushDemo( demofile );
 }
 
 /*
@@ -303,7 +714,7 @@ void SNAP_StopDemoRecording( int demofile ) {
 
 	// finishup
 	i = LittleLong( -1 );
-	FS_Write( &i, 4, demofile );
+	SNAP_WriteDemoData( demofile, &i, 4, NULL, 0, true );
 }
 
 /*
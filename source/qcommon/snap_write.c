@@ -403,17 +403,6 @@ Build a client frame structure
 =============================================================================
 */
 
-/*
-* SNAP_FatPVS
-*
-* The client will interpolate the view position,
-* so we can't use a single PVS point
-*/
-static void SNAP_FatPVS( cmodel_state_t *cms, const vec3_t org, uint8_t *fatpvs ) {
-	memset( fatpvs, 0, CM_ClusterRowSize( cms ) );
-	CM_MergePVS( cms, org, fatpvs );
-}
-
 /*
 * SNAP_BitsCullEntity
 */
@@ -629,8 +618,9 @@ static void SNAP_AddEntitiesVisibleAtOrigin( cmodel_state_t *cms, ginfo_t *gi, e
 	edict_t *ent;
 	uint8_t *pvs;
 
+	// the client will interpolate the view position, so we can't use a single PVS point
 	pvs = alloca( CM_ClusterRowSize( cms ) );
-	SNAP_FatPVS( cms, vieworg, pvs );
+	CM_FatPVS( cms, vieworg, pvs );
 
 	// add the entities to the list
 	for( entNum = 1; entNum < gi->num_edicts; entNum++ ) {
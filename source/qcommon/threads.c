@@ -159,15 +159,29 @@ bool QAtomic_CAS( volatile int *value, int oldval, int newval ) {
 
 // ============================================================================
 
+// Pipes are single producer, single consumer. Both sides only touch the
+// mutex and condition variables when the other side is parked, otherwise
+// all synchronization goes through the atomic cmdbuf_len. The reader also
+// publishes the space freed by the commands it has handled in batches.
+
+#define QBUFPIPE_WAIT_MSEC  100     // safety net against multiple threads waiting for space
+#define QBUFPIPE_SPINS      16      // yields before a thread blocks on the pipe
+#define QBUFPIPE_READ_BATCH 0x4000  // max bytes of handled commands before the space is returned to the writer
+
 struct qbufPipe_s {
 	int blockWrite;
 	volatile int terminated;
 	unsigned write_pos;
 	unsigned read_pos;
 	volatile int cmdbuf_len;
+	volatile int reader_waiting;
+	volatile int writer_waiting;
 	size_t bufSize;
 	qcondvar_t *nonempty_condvar;
+	qcondvar_t *nonfull_condvar;
 	qmutex_t *nonempty_mutex;
+	unsigned reader_wakeups;
+	unsigned writer_waits;
 	char *buf;
 };
 
@@ -184,6 +198,7 @@ qbufPipe_t *QBufPipe_Create( size_t bufSize, int flags ) {
 	pipe->buf = (char *)( pipe + 1 );
 	pipe->bufSize = bufSize;
 	pipe->nonempty_condvar = QCondVar_Create();
+	pipe->nonfull_condvar = QCondVar_Create();
 	pipe->nonempty_mutex = QMutex_Create();
 	return pipe;
 }
@@ -207,17 +222,88 @@ void QBufPipe_Destroy( qbufPipe_t **ppipe ) {
 	}
 
 	QMutex_Destroy( &pipe->nonempty_mutex );
+	QCondVar_Destroy( &pipe->nonfull_condvar );
 	QCondVar_Destroy( &pipe->nonempty_condvar );
 	free( pipe );
 }
 
 /*
-* QBufPipe_Wake
+* QBufPipe_BufLen
+*/
+static int QBufPipe_BufLen( qbufPipe_t *pipe ) {
+	return Sys_Atomic_Add( &pipe->cmdbuf_len, 0 );
+}
+
+/*
+* QBufPipe_BufLenAdd
+*/
+static void QBufPipe_BufLenAdd( qbufPipe_t *pipe, int val ) {
+	Sys_Atomic_Add( &pipe->cmdbuf_len, val );
+}
+
+/*
+* QBufPipe_WakeReader
 *
-* Signals the waiting thread to wake up.
+* Signals the reader thread to wake up if it's waiting for commands.
+* Must be called after cmdbuf_len is updated.
 */
-static void QBufPipe_Wake( qbufPipe_t *pipe ) {
+static void QBufPipe_WakeReader( qbufPipe_t *pipe ) {
+	// clear the flag so that following commands don't signal again
+	if( !Sys_Atomic_CAS( &pipe->reader_waiting, 1, 0 ) ) {
+		return;
+	}
+
+	QMutex_Lock( pipe->nonempty_mutex );
 	QCondVar_Wake( pipe->nonempty_condvar );
+	pipe->reader_wakeups++;
+	QMutex_Unlock( pipe->nonempty_mutex );
+}
+
+/*
+* QBufPipe_WakeWriter
+*
+* Signals the writer thread to wake up if it's waiting for space
+* or for the pipe to be drained. Must be called after cmdbuf_len is updated.
+*/
+static void QBufPipe_WakeWriter( qbufPipe_t *pipe ) {
+	if( !Sys_Atomic_CAS( &pipe->writer_waiting, 1, 0 ) ) {
+		return;
+	}
+
+	QMutex_Lock( pipe->nonempty_mutex );
+	QCondVar_Wake( pipe->nonfull_condvar );
+	QMutex_Unlock( pipe->nonempty_mutex );
+}
+
+/*
+* QBufPipe_WaitForLen
+*
+* Blocks until no more than maxLen bytes are left in the buffer.
+* The waiting flag is raised before cmdbuf_len is checked, so that
+* either we see the reader's progress or the reader sees us waiting.
+*/
+static void QBufPipe_WaitForLen( qbufPipe_t *pipe, int maxLen ) {
+	int i;
+
+	// the reader is usually about to catch up, give it a chance first
+	for( i = 0; i < QBUFPIPE_SPINS; i++ ) {
+		if( QBufPipe_BufLen( pipe ) <= maxLen || pipe->terminated ) {
+			return;
+		}
+		QThread_Yield();
+	}
+
+	QMutex_Lock( pipe->nonempty_mutex );
+	while( true ) {
+		Sys_Atomic_CAS( &pipe->writer_waiting, 0, 1 );
+		if( QBufPipe_BufLen( pipe ) <= maxLen || pipe->terminated ) {
+			break;
+		}
+		QCondVar_Wait( pipe->nonfull_condvar, pipe->nonempty_mutex, QBUFPIPE_WAIT_MSEC );
+		pipe->writer_waits++;
+	}
+	Sys_Atomic_CAS( &pipe->writer_waiting, 1, 0 );
+	QMutex_Unlock( pipe->nonempty_mutex );
 }
 
 /*
@@ -227,12 +313,7 @@ static void QBufPipe_Wake( qbufPipe_t *pipe ) {
 * or terminates with an error.
 */
 void QBufPipe_Finish( qbufPipe_t *pipe ) {
-	while( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0 ) == false && !pipe->terminated ) {
-		QMutex_Lock( pipe->nonempty_mutex );
-		QBufPipe_Wake( pipe );
-		QMutex_Unlock( pipe->nonempty_mutex );
-		QThread_Yield();
-	}
+	QBufPipe_WaitForLen( pipe, 0 );
 }
 
 /*
@@ -245,30 +326,41 @@ static void *QBufPipe_AllocCmd( qbufPipe_t *pipe, unsigned cmd_size ) {
 }
 
 /*
-* QBufPipe_BufLenAdd
+* QBufPipe_HasSpace
+*
+* Returns false if there's no space for the command and the pipe
+* doesn't block writes, blocks until there's enough space otherwise.
 */
-static void QBufPipe_BufLenAdd( qbufPipe_t *pipe, int val ) {
-	Sys_Atomic_Add( &pipe->cmdbuf_len, val );
+static bool QBufPipe_HasSpace( qbufPipe_t *pipe, unsigned size ) {
+	if( QBufPipe_BufLen( pipe ) + size <= pipe->bufSize ) {
+		return true;
+	}
+	if( !pipe->blockWrite ) {
+		return false;
+	}
+
+	QBufPipe_WaitForLen( pipe, (int)( pipe->bufSize - size ) );
+	return !pipe->terminated;
 }
 
 /*
-* QBufPipe_WriteCmd
+* QBufPipe_TryWriteCmd
 *
 * Add new command to buffer. Never allow the distance between the reader
 * and the writer to grow beyond the size of the buffer.
 *
-* Note that there are race conditions here but in the worst case we're going
-* to erroneously drop cmd's instead of stepping on the reader's toes.
+* Returns false if the command was dropped because a pipe
+* which doesn't block writes is full.
 */
-void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *pcmd, unsigned cmd_size ) {
+bool QBufPipe_TryWriteCmd( qbufPipe_t *pipe, const void *pcmd, unsigned cmd_size ) {
 	void *buf;
 	unsigned write_remains;
 
 	if( !pipe ) {
-		return;
+		return false;
 	}
 	if( pipe->terminated ) {
-		return;
+		return false;
 	}
 
 	assert( pipe->bufSize >= pipe->write_pos );
@@ -279,12 +371,8 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *pcmd, unsigned cmd_size )
 	write_remains = pipe->bufSize - pipe->write_pos;
 
 	if( sizeof( int ) > write_remains ) {
-		while( pipe->cmdbuf_len + cmd_size + write_remains > pipe->bufSize ) {
-			if( pipe->blockWrite ) {
-				QThread_Yield();
-				continue;
-			}
-			return;
+		if( !QBufPipe_HasSpace( pipe, cmd_size + write_remains ) ) {
+			return false;
 		}
 
 		// not enough space to enpipe even the reset cmd, rewind
@@ -293,12 +381,8 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *pcmd, unsigned cmd_size )
 	} else if( cmd_size > write_remains ) {
 		int *cmd;
 
-		while( pipe->cmdbuf_len + sizeof( int ) + cmd_size + write_remains > pipe->bufSize ) {
-			if( pipe->blockWrite ) {
-				QThread_Yield();
-				continue;
-			}
-			return;
+		if( !QBufPipe_HasSpace( pipe, sizeof( int ) + cmd_size + write_remains ) ) {
+			return false;
 		}
 
 		// explicit pointer reset cmd
@@ -308,12 +392,8 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *pcmd, unsigned cmd_size )
 		QBufPipe_BufLenAdd( pipe, sizeof( *cmd ) + write_remains ); // atomic
 		pipe->write_pos = 0;
 	} else {
-		while( pipe->cmdbuf_len + cmd_size > pipe->bufSize ) {
-			if( pipe->blockWrite ) {
-				QThread_Yield();
-				continue;
-			}
-			return;
+		if( !QBufPipe_HasSpace( pipe, cmd_size ) ) {
+			return false;
 		}
 	}
 
@@ -321,64 +401,104 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *pcmd, unsigned cmd_size )
 	memcpy( buf, pcmd, cmd_size );
 	QBufPipe_BufLenAdd( pipe, cmd_size ); // atomic
 
-	// wake the other thread waiting for signal
-	QMutex_Lock( pipe->nonempty_mutex );
-	QBufPipe_Wake( pipe );
-	QMutex_Unlock( pipe->nonempty_mutex );
+	QBufPipe_WakeReader( pipe );
+	return true;
+}
+
+/*
+* QBufPipe_WriteCmd
+*/
+void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *pcmd, unsigned cmd_size ) {
+	QBufPipe_TryWriteCmd( pipe, pcmd, cmd_size );
+}
+
+/*
+* QBufPipe_Terminate
+*/
+static void QBufPipe_Terminate( qbufPipe_t *pipe ) {
+	pipe->terminated = 1;
+	QBufPipe_WakeWriter( pipe );
 }
 
 /*
 * QBufPipe_ReadCmds
+*
+* Handles all commands available in the buffer. The space taken by handled
+* commands is returned to the writer in small batches, which saves atomic
+* operations, or after every command while the writer is blocked on the pipe.
 */
 int QBufPipe_ReadCmds( qbufPipe_t *pipe, unsigned( **cmdHandlers )( const void * ) ) {
 	int read = 0;
+	int len, avail, consumed;
+	int batchSize;
 
 	if( !pipe ) {
 		return -1;
 	}
 
-	while( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0 ) == false && !pipe->terminated ) {
-		int cmd;
-		int cmd_size;
-		int read_remains;
+	batchSize = pipe->bufSize / 4;
+	if( batchSize > QBUFPIPE_READ_BATCH ) {
+		batchSize = QBUFPIPE_READ_BATCH;
+	}
 
-		assert( pipe->bufSize >= pipe->read_pos );
-		if( pipe->bufSize < pipe->read_pos ) {
-			pipe->read_pos = 0;
+	while( !pipe->terminated ) {
+		len = QBufPipe_BufLen( pipe );
+		if( len <= 0 ) {
+			break;
 		}
+		avail = len > batchSize ? batchSize : len;
 
-		read_remains = pipe->bufSize - pipe->read_pos;
+		for( consumed = 0; consumed < avail; ) {
+			int cmd;
+			int cmd_size;
+			int read_remains;
 
-		if( sizeof( int ) > read_remains ) {
-			// implicit reset
-			pipe->read_pos = 0;
-			QBufPipe_BufLenAdd( pipe, -read_remains );
-		}
+			assert( pipe->bufSize >= pipe->read_pos );
+			if( pipe->bufSize < pipe->read_pos ) {
+				pipe->read_pos = 0;
+			}
 
-		cmd = *( (int *)( pipe->buf + pipe->read_pos ) );
-		if( cmd == -1 ) {
-			// this cmd is special
-			pipe->read_pos = 0;
-			QBufPipe_BufLenAdd( pipe, -( (int)( sizeof( int ) + read_remains ) ) ); // atomic
-			continue;
-		}
+			read_remains = pipe->bufSize - pipe->read_pos;
 
-		cmd_size = cmdHandlers[cmd]( pipe->buf + pipe->read_pos );
-		read++;
+			if( sizeof( int ) > read_remains ) {
+				// implicit reset
+				pipe->read_pos = 0;
+				consumed += read_remains;
+				continue;
+			}
 
-		if( !cmd_size ) {
-			pipe->terminated = 1;
-			return -1;
-		}
+			cmd = *( (int *)( pipe->buf + pipe->read_pos ) );
+			if( cmd == -1 ) {
+				// this cmd is special
+				pipe->read_pos = 0;
+				consumed += sizeof( int ) + read_remains;
+				continue;
+			}
+
+			cmd_size = cmdHandlers[cmd]( pipe->buf + pipe->read_pos );
+			read++;
+
+			if( !cmd_size ) {
+				QBufPipe_Terminate( pipe );
+				return -1;
+			}
+
+			if( cmd_size > len - consumed ) {
+				assert( 0 );
+				QBufPipe_Terminate( pipe );
+				return -1;
+			}
+
+			pipe->read_pos += cmd_size;
+			consumed += cmd_size;
 
-		if( cmd_size > pipe->cmdbuf_len ) {
-			assert( 0 );
-			pipe->terminated = 1;
-			return -1;
+			if( Sys_Atomic_CAS( &pipe->writer_waiting, 1, 1 ) ) {
+				break;
+			}
 		}
 
-		pipe->read_pos += cmd_size;
-		QBufPipe_BufLenAdd( pipe, -cmd_size ); // atomic
+		QBufPipe_BufLenAdd( pipe, -consumed ); // atomic
+		QBufPipe_WakeWriter( pipe );
 	}
 
 	return read;
@@ -390,17 +510,23 @@ int QBufPipe_ReadCmds( qbufPipe_t *pipe, unsigned( **cmdHandlers )( const void *
 void QBufPipe_Wait( qbufPipe_t *pipe, int ( *read )( qbufPipe_t *, unsigned( ** )( const void * ), bool ),
 					unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec ) {
 	while( !pipe->terminated ) {
-		int res;
+		int i, res;
 		bool timeout = false;
 
-		while( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0 ) == true ) {
-			QMutex_Lock( pipe->nonempty_mutex );
-
-			timeout = QCondVar_Wait( pipe->nonempty_condvar, pipe->nonempty_mutex, timeout_msec ) == false;
+		for( i = 0; i < QBUFPIPE_SPINS && !QBufPipe_BufLen( pipe ); i++ ) {
+			QThread_Yield();
+		}
 
-			// don't hold the mutex, changes to cmdbuf_len are atomic anyway
+		if( !QBufPipe_BufLen( pipe ) ) {
+			// raise the flag before checking the buffer again, so that either
+			// we see the new command or the writer sees us waiting
+			QMutex_Lock( pipe->nonempty_mutex );
+			Sys_Atomic_CAS( &pipe->reader_waiting, 0, 1 );
+			if( !QBufPipe_BufLen( pipe ) && !pipe->terminated ) {
+				timeout = QCondVar_Wait( pipe->nonempty_condvar, pipe->nonempty_mutex, timeout_msec ) == false;
+			}
+			Sys_Atomic_CAS( &pipe->reader_waiting, 1, 0 );
 			QMutex_Unlock( pipe->nonempty_mutex );
-			break;
 		}
 
 		// we're guaranteed at this point that either cmdbuf_len is > 0
@@ -412,3 +538,103 @@ void QBufPipe_Wait( qbufPipe_t *pipe, int ( *read )( qbufPipe_t *, unsigned( **
 		}
 	}
 }
+
+// ============================================================================
+
+#ifndef PUBLIC_BUILD
+
+typedef struct {
+	int id;
+	int size;
+} qbufPipeBenchCmd_t;
+
+static volatile int bench_read;
+
+/*
+* QBufPipe_BenchCmd
+*/
+static unsigned QBufPipe_BenchCmd( const void *pcmd ) {
+	const qbufPipeBenchCmd_t *cmd = pcmd;
+	bench_read++;
+	return cmd->size;
+}
+
+/*
+* QBufPipe_BenchQuitCmd
+*/
+static unsigned QBufPipe_BenchQuitCmd( const void *pcmd ) {
+	return 0;
+}
+
+/*
+* QBufPipe_BenchWaiter
+*/
+static int QBufPipe_BenchWaiter( qbufPipe_t *pipe, unsigned( **cmdHandlers )( const void * ), bool timeout ) {
+	return QBufPipe_ReadCmds( pipe, cmdHandlers );
+}
+
+/*
+* QBufPipe_BenchThread
+*/
+static void *QBufPipe_BenchThread( void *param ) {
+	unsigned( *cmdHandlers[2] )( const void * ) = { QBufPipe_BenchCmd, QBufPipe_BenchQuitCmd };
+
+	QBufPipe_Wait( param, QBufPipe_BenchWaiter, cmdHandlers, Q_THREADS_WAIT_INFINITE );
+	return NULL;
+}
+
+/*
+* QBufPipe_Bench_f
+*
+* pipebench [numcmds] [cmdsize] [bufsize]
+*
+* Pushes commands through a blocking pipe to another thread and measures
+* the throughput. Small buffers stress the full pipe path, small commands
+* stress the signalling.
+*/
+void QBufPipe_Bench_f( void ) {
+	int i, numCmds, cmdSize, bufSize;
+	uint8_t buf[1024];
+	qbufPipeBenchCmd_t *cmd = (qbufPipeBenchCmd_t *)buf;
+	qbufPipeBenchCmd_t quit;
+	qbufPipe_t *pipe;
+	qthread_t *thread;
+	uint64_t time;
+
+	numCmds = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 1000000;
+	cmdSize = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 16;
+	bufSize = Cmd_Argc() > 3 ? atoi( Cmd_Argv( 3 ) ) : 0x4000;
+
+	Q_clamp( cmdSize, (int)sizeof( *cmd ), (int)sizeof( buf ) );
+	cmdSize = ( cmdSize + 3 ) & ~3;
+	clamp_low( bufSize, cmdSize * 4 );
+	clamp_low( numCmds, 1 );
+
+	memset( buf, 0, sizeof( buf ) );
+	cmd->id = 0;
+	cmd->size = cmdSize;
+	quit.id = 1;
+	quit.size = sizeof( quit );
+
+	bench_read = 0;
+	pipe = QBufPipe_Create( bufSize, 1 );
+	thread = QThread_Create( QBufPipe_BenchThread, pipe );
+
+	time = Sys_Microseconds();
+	for( i = 0; i < numCmds; i++ ) {
+		QBufPipe_WriteCmd( pipe, cmd, cmdSize );
+	}
+	QBufPipe_Finish( pipe );
+	time = Sys_Microseconds() - time;
+
+	QBufPipe_WriteCmd( pipe, &quit, sizeof( quit ) );
+	QThread_Join( thread );
+
+	Com_Printf( "%i commands of %i bytes in %.2f ms, %.1f ns per command\n", bench_read, cmdSize,
+				time / 1000.0, time * 1000.0 / numCmds );
+	Com_Printf( "%u reader wakeups, %u writer waits\n", pipe->reader_wakeups, pipe->writer_waits );
+
+	QBufPipe_Destroy( &pipe );
+}
+
+#endif // PUBLIC_BUILD
@@ -24,6 +24,20 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define MAX_GLIMAGES 8192
 #define IMAGES_HASH_SIZE 64
 
+#define TEXTURECACHE_DIR "cache/textures"
+#define TEXTURECACHE_VERSION 1
+#define TEXTURECACHE_KEY "qfusion.cachekey"
+#define TEXTURECACHE_IMAGE_KEY "qfusion.image"
+
+// flags set by the loader which must be restored when the source picture isn't read,
+// IT_SRGB is requested by the caller and is a part of the cache key instead
+#define TEXTURECACHE_LOADFLAGS ( IT_ALPHAMASK | IT_WAL )
+
+// images which are never cached
+#define TEXTURECACHE_NOFLAGS                                                                                      \
+	( IT_CUBEMAP | IT_FLIPX | IT_FLIPY | IT_FLIPDIAGONAL | IT_DEPTH | IT_FRAMEBUFFER | IT_ARRAY | IT_3D | IT_FLOAT | \
+		IT_MIPTEX | IT_LEFTHALF | IT_RIGHTHALF )
+
 typedef struct {
 	int ctx;
 	int side;
@@ -330,6 +344,7 @@ enum {
 	TEXTURE_FLIPPING_BUF3,
 	TEXTURE_FLIPPING_BUF4,
 	TEXTURE_FLIPPING_BUF5,
+	TEXTURE_MIPMAP_BUF,
 
 	NUM_IMAGE_BUFFERS
 };
@@ -378,25 +393,127 @@ void R_FreeImageBuffers( void )
 }
 
 /*
- * R_SwapBlueRed
+=================================================================
+
+PIXEL KERNELS
+
+=================================================================
+*/
+
+// Rows of large images are spread over the job system, for smaller
+// ones the cost of scheduling outweighs the gain.
+#define IMAGE_JOB_MIN_PIXELS    ( 256 * 256 )
+#define IMAGE_JOB_GRAIN_PIXELS  ( 64 * 256 )
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define R_IMAGE_SSE2
+#include <emmintrin.h>
+#endif
+
+typedef struct {
+	const uint8_t *in;
+	uint8_t *out;
+	int inwidth, inheight;
+	int outwidth, outheight;
+	int samples, alignment;
+	const unsigned *p1, *p2;    // column offsets for resampling
+	bool simd;
+} imageKernelArgs_t;
+
+/*
+ * R_RunImageKernel
+ *
+ * Runs the kernel for all rows, in parallel if the image is large enough.
  */
-static void R_SwapBlueRed( uint8_t *data, int width, int height, int samples, int alignment )
+static void R_RunImageKernel( qjobrangefunc_t kernel, imageKernelArgs_t *args, int rows, int width, bool parallel )
+{
+	qjobcounter_t counter;
+
+	if( !parallel || rows < 2 || rows * width < IMAGE_JOB_MIN_PIXELS || !ri.Jobs_NumThreads() ) {
+		kernel( 0, rows, args );
+		return;
+	}
+
+	memset( &counter, 0, sizeof( counter ) );
+	ri.Jobs_ParallelFor( &counter, rows, max( IMAGE_JOB_GRAIN_PIXELS / width, 1 ), kernel, args );
+	ri.Jobs_Wait( &counter );
+}
+
+#ifdef R_IMAGE_SSE2
+/*
+ * R_LoadPixel32
+ */
+static inline __m128i R_LoadPixel32( const uint8_t *p )
+{
+	int v;
+	memcpy( &v, p, sizeof( v ) );
+	return _mm_cvtsi32_si128( v );
+}
+#endif
+
+/*
+ * R_SwapBlueRedRows
+ */
+static void R_SwapBlueRedRows( unsigned first, unsigned count, void *arg )
 {
-	int i, j, k, padding;
+	const imageKernelArgs_t *args = arg;
+	int i, j, k;
+	int width = args->inwidth, samples = args->samples;
+	int stride = Q_ALIGN( width * samples, args->alignment );
+	uint8_t *data;
 
-	padding = Q_ALIGN( width * samples, alignment ) - width * samples;
-	for( i = 0; i < height; i++, data += padding ) {
-		for( j = 0; j < width; j++, data += samples ) {
+	for( i = first; i < (int)( first + count ); i++ ) {
+		data = args->out + i * stride;
+		j = 0;
+
+#ifdef R_IMAGE_SSE2
+		if( args->simd && samples == 4 ) {
+			const __m128i gaMask = _mm_set1_epi32( 0xFF00FF00 );
+			const __m128i byteMask = _mm_set1_epi32( 0x000000FF );
+
+			for( ; j + 4 <= width; j += 4, data += 16 ) {
+				__m128i x = _mm_loadu_si128( (const __m128i *)data );
+				__m128i r = _mm_slli_epi32( _mm_and_si128( x, byteMask ), 16 );
+				__m128i b = _mm_and_si128( _mm_srli_epi32( x, 16 ), byteMask );
+				_mm_storeu_si128( (__m128i *)data, _mm_or_si128( _mm_and_si128( x, gaMask ), _mm_or_si128( r, b ) ) );
+			}
+		}
+#endif
+
+		for( ; j < width; j++, data += samples ) {
 			k = data[0];
 			data[0] = data[2];
 			data[2] = k;
-			// data[0] ^= data[2];
-			// data[2] = data[0] ^ data[2];
-			// data[0] ^= data[2];
 		}
 	}
 }
 
+/*
+ * R_SwapBlueRedExt
+ */
+static void R_SwapBlueRedExt( uint8_t *data, int width, int height, int samples, int alignment, bool simd, bool parallel )
+{
+	imageKernelArgs_t args;
+
+	memset( &args, 0, sizeof( args ) );
+	args.out = data;
+	args.inwidth = width;
+	args.inheight = height;
+	args.samples = samples;
+	args.alignment = alignment;
+	args.simd = simd;
+
+	R_RunImageKernel( R_SwapBlueRedRows, &args, height, width, parallel );
+}
+
+/*
+ * R_SwapBlueRed
+ */
+static void R_SwapBlueRed( uint8_t *data, int width, int height, int samples, int alignment )
+{
+	R_SwapBlueRedExt( data, width, height, samples, alignment, true, true );
+}
+
 /*
  * R_EndianSwap16BitImage
  */
@@ -582,11 +699,38 @@ static void R_FlipTexture(
 	}
 
 	if( flipdiagonal ) {
+		if( samples == 4 ) {
+			for( x = 0, line = in + col_ofs; x < width; x++, line += col_inc )
+				for( y = 0, p = line + row_ofs; y < height; y++, p += row_inc, out += 4 )
+					memcpy( out, p, 4 );
+			return;
+		}
+
 		for( x = 0, line = in + col_ofs; x < width; x++, line += col_inc )
 			for( y = 0, p = line + row_ofs; y < height; y++, p += row_inc, out += samples )
 				for( i = 0; i < samples; i++ )
 					out[i] = p[i];
+	} else if( !flipx ) {
+		// whole rows can be copied
+		for( y = 0, line = in + row_ofs; y < height; y++, line += row_inc, out += width * samples )
+			memcpy( out, line, width * samples );
 	} else {
+		if( samples == 4 ) {
+			for( y = 0, line = in + row_ofs; y < height; y++, line += row_inc ) {
+				x = 0;
+				p = line + col_ofs;
+#ifdef R_IMAGE_SSE2
+				for( ; x + 4 <= width; x += 4, p -= 16, out += 16 ) {
+					__m128i v = _mm_loadu_si128( (const __m128i *)( p - 12 ) );
+					_mm_storeu_si128( (__m128i *)out, _mm_shuffle_epi32( v, _MM_SHUFFLE( 0, 1, 2, 3 ) ) );
+				}
+#endif
+				for( ; x < width; x++, p -= 4, out += 4 )
+					memcpy( out, p, 4 );
+			}
+			return;
+		}
+
 		for( y = 0, line = in + row_ofs; y < height; y++, line += row_inc )
 			for( x = 0, p = line + col_ofs; x < width; x++, p += col_inc, out += samples )
 				for( i = 0; i < samples; i++ )
@@ -621,24 +765,77 @@ static void R_CutImage(
 }
 
 /*
- * R_ResampleTexture
+ * R_ResampleTextureRows
  */
-static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, int outwidth,
-	int outheight, int samples, int alignment )
+static void R_ResampleTextureRows( unsigned first, unsigned count, void *arg )
 {
+	const imageKernelArgs_t *args = arg;
 	int i, j, k;
 	int inwidthS, outwidthS;
-	unsigned int frac, fracstep;
+	int samples = args->samples, inheight = args->inheight, outwidth = args->outwidth, outheight = args->outheight;
+	const unsigned *p1 = args->p1, *p2 = args->p2;
 	const uint8_t *inrow, *inrow2, *pix1, *pix2, *pix3, *pix4;
+	uint8_t *out, *opix;
+
+	inwidthS = Q_ALIGN( args->inwidth * samples, args->alignment );
+	outwidthS = Q_ALIGN( outwidth * samples, args->alignment );
+	out = args->out + first * outwidthS;
+
+	for( i = first; i < (int)( first + count ); i++, out += outwidthS ) {
+		inrow = args->in + inwidthS * (int)( ( i + 0.25 ) * inheight / outheight );
+		inrow2 = args->in + inwidthS * (int)( ( i + 0.75 ) * inheight / outheight );
+		j = 0;
+
+#ifdef R_IMAGE_SSE2
+		if( args->simd && samples == 4 ) {
+			const __m128i zero = _mm_setzero_si128();
+
+			// 2 pixels at a time, widened to 16 bits per component
+			for( ; j + 2 <= outwidth; j += 2 ) {
+				__m128i a = _mm_unpacklo_epi32( R_LoadPixel32( inrow + p1[j] ), R_LoadPixel32( inrow + p1[j + 1] ) );
+				__m128i b = _mm_unpacklo_epi32( R_LoadPixel32( inrow + p2[j] ), R_LoadPixel32( inrow + p2[j + 1] ) );
+				__m128i c = _mm_unpacklo_epi32( R_LoadPixel32( inrow2 + p1[j] ), R_LoadPixel32( inrow2 + p1[j + 1] ) );
+				__m128i d = _mm_unpacklo_epi32( R_LoadPixel32( inrow2 + p2[j] ), R_LoadPixel32( inrow2 + p2[j + 1] ) );
+				__m128i sum = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) ),
+					_mm_add_epi16( _mm_unpacklo_epi8( c, zero ), _mm_unpacklo_epi8( d, zero ) ) );
+				sum = _mm_srli_epi16( sum, 2 );
+				_mm_storel_epi64( (__m128i *)( out + j * 4 ), _mm_packus_epi16( sum, sum ) );
+			}
+		}
+#endif
+
+		for( ; j < outwidth; j++ ) {
+			pix1 = inrow + p1[j];
+			pix2 = inrow + p2[j];
+			pix3 = inrow2 + p1[j];
+			pix4 = inrow2 + p2[j];
+			opix = out + j * samples;
+
+			for( k = 0; k < samples; k++ )
+				opix[k] = ( pix1[k] + pix2[k] + pix3[k] + pix4[k] ) >> 2;
+		}
+	}
+}
+
+/*
+ * R_ResampleTextureExt
+ *
+ * The line buffer must have room for outwidth * 2 column offsets.
+ */
+static void R_ResampleTextureExt( unsigned *lineBuf, const uint8_t *in, int inwidth, int inheight, uint8_t *out,
+	int outwidth, int outheight, int samples, int alignment, bool simd, bool parallel )
+{
+	int i;
+	unsigned int frac, fracstep;
 	unsigned *p1, *p2;
-	uint8_t *opix;
+	imageKernelArgs_t args;
 
 	if( inwidth == outwidth && inheight == outheight ) {
 		memcpy( out, in, inheight * Q_ALIGN( inwidth * samples, alignment ) );
 		return;
 	}
 
-	p1 = (unsigned *)R_PrepareImageBuffer( ctx, TEXTURE_LINE_BUF, outwidth * sizeof( *p1 ) * 2 );
+	p1 = lineBuf;
 	p2 = p1 + outwidth;
 
 	fracstep = inwidth * 0x10000 / outwidth;
@@ -655,22 +852,34 @@ static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inhe
 		frac += fracstep;
 	}
 
-	inwidthS = Q_ALIGN( inwidth * samples, alignment );
-	outwidthS = Q_ALIGN( outwidth * samples, alignment );
-	for( i = 0; i < outheight; i++, out += outwidthS ) {
-		inrow = in + inwidthS * (int)( ( i + 0.25 ) * inheight / outheight );
-		inrow2 = in + inwidthS * (int)( ( i + 0.75 ) * inheight / outheight );
-		for( j = 0; j < outwidth; j++ ) {
-			pix1 = inrow + p1[j];
-			pix2 = inrow + p2[j];
-			pix3 = inrow2 + p1[j];
-			pix4 = inrow2 + p2[j];
-			opix = out + j * samples;
+	args.in = in;
+	args.out = out;
+	args.inwidth = inwidth;
+	args.inheight = inheight;
+	args.outwidth = outwidth;
+	args.outheight = outheight;
+	args.samples = samples;
+	args.alignment = alignment;
+	args.p1 = p1;
+	args.p2 = p2;
+	args.simd = simd;
 
-			for( k = 0; k < samples; k++ )
-				opix[k] = ( pix1[k] + pix2[k] + pix3[k] + pix4[k] ) >> 2;
-		}
+	R_RunImageKernel( R_ResampleTextureRows, &args, outheight, outwidth, parallel );
+}
+
+/*
+ * R_ResampleTexture
+ */
+static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, int outwidth,
+	int outheight, int samples, int alignment )
+{
+	unsigned *lineBuf = NULL;
+
+	if( inwidth != outwidth || inheight != outheight ) {
+		lineBuf = (unsigned *)R_PrepareImageBuffer( ctx, TEXTURE_LINE_BUF, outwidth * sizeof( *lineBuf ) * 2 );
 	}
+
+	R_ResampleTextureExt( lineBuf, in, inwidth, inheight, out, outwidth, outheight, samples, alignment, true, true );
 }
 
 /*
@@ -732,32 +941,47 @@ static void R_ResampleTexture16( int ctx, const unsigned short *in, int inwidth,
 }
 
 /*
- * R_MipMap
+ * R_MipMapRows
  *
- * Operates in place, quartering the size of the texture
+ * Output rows never get ahead of the input ones, so this works in place
+ * as long as the rows are processed in order.
  */
-static void R_MipMap( uint8_t *in, int width, int height, int samples, int alignment )
+static void R_MipMapRows( unsigned first, unsigned count, void *arg )
 {
+	const imageKernelArgs_t *args = arg;
 	int i, j, k;
-	int instride = Q_ALIGN( width * samples, alignment );
-	int outwidth, outheight, outpadding;
-	uint8_t *out = in;
-	uint8_t *next;
+	int width = args->inwidth, height = args->inheight, samples = args->samples;
+	int instride = Q_ALIGN( width * samples, args->alignment );
+	int outwidth = args->outwidth, outstride = Q_ALIGN( outwidth * samples, args->alignment );
+	const uint8_t *in, *next;
+	uint8_t *out;
 	int inofs;
 
-	outwidth = width >> 1;
-	outheight = height >> 1;
-	if( !outwidth ) {
-		outwidth = 1;
-	}
-	if( !outheight ) {
-		outheight = 1;
-	}
-	outpadding = Q_ALIGN( outwidth * samples, alignment ) - outwidth * samples;
-
-	for( i = 0; i < outheight; i++, in += instride * 2, out += outpadding ) {
+	for( i = first; i < (int)( first + count ); i++ ) {
+		in = args->in + ( i << 1 ) * instride;
 		next = ( ( ( i << 1 ) + 1 ) < height ) ? ( in + instride ) : in;
-		for( j = 0, inofs = 0; j < outwidth; j++, inofs += samples ) {
+		out = args->out + i * outstride;
+		j = 0;
+
+#ifdef R_IMAGE_SSE2
+		if( args->simd && samples == 4 ) {
+			const __m128i zero = _mm_setzero_si128();
+
+			// 4 input pixels from each row at a time, producing 2 output pixels
+			for( ; j + 2 <= ( width >> 1 ); j += 2 ) {
+				__m128i r0 = _mm_loadu_si128( (const __m128i *)( in + j * 8 ) );
+				__m128i r1 = _mm_loadu_si128( (const __m128i *)( next + j * 8 ) );
+				__m128i lo = _mm_add_epi16( _mm_unpacklo_epi8( r0, zero ), _mm_unpacklo_epi8( r1, zero ) );
+				__m128i hi = _mm_add_epi16( _mm_unpackhi_epi8( r0, zero ), _mm_unpackhi_epi8( r1, zero ) );
+				__m128i sum = _mm_add_epi16( _mm_unpacklo_epi64( lo, hi ), _mm_unpackhi_epi64( lo, hi ) );
+				sum = _mm_srli_epi16( sum, 2 );
+				_mm_storel_epi64( (__m128i *)( out + j * 4 ), _mm_packus_epi16( sum, sum ) );
+			}
+		}
+#endif
+
+		out += j * samples;
+		for( inofs = j * 2 * samples; j < outwidth; j++, inofs += samples ) {
 			if( ( ( j << 1 ) + 1 ) < width ) {
 				for( k = 0; k < samples; ++k, ++inofs )
 					*( out++ ) = ( in[inofs] + in[inofs + samples] + next[inofs] + next[inofs + samples] ) >> 2;
@@ -769,6 +993,66 @@ static void R_MipMap( uint8_t *in, int width, int height, int samples, int align
 	}
 }
 
+/*
+ * R_MipMapExt
+ *
+ * Quarters the size of the texture. Writes to out, which may be the same
+ * as in, but then the rows can't be processed in parallel.
+ */
+static void R_MipMapExt( const uint8_t *in, uint8_t *out, int width, int height, int samples, int alignment, bool simd )
+{
+	imageKernelArgs_t args;
+
+	memset( &args, 0, sizeof( args ) );
+	args.in = in;
+	args.out = out;
+	args.inwidth = width;
+	args.inheight = height;
+	args.outwidth = max( width >> 1, 1 );
+	args.outheight = max( height >> 1, 1 );
+	args.samples = samples;
+	args.alignment = alignment;
+	args.simd = simd;
+
+	R_RunImageKernel( R_MipMapRows, &args, args.outheight, args.outwidth, in != out );
+}
+
+/*
+ * R_MipMap
+ *
+ * Operates in place, quartering the size of the texture
+ */
+static void R_MipMap( uint8_t *in, int width, int height, int samples, int alignment )
+{
+	R_MipMapExt( in, in, width, height, samples, alignment, true );
+}
+
+/*
+ * R_MipMapToBuffer
+ *
+ * Same as R_MipMap, but for large images writes to the other buffer in parallel
+ * and swaps the two. Returns the buffer holding the mipmap.
+ */
+static uint8_t *R_MipMapToBuffer( int ctx, uint8_t *in, uint8_t **other, int width, int height, int samples, int alignment )
+{
+	uint8_t *out;
+
+	if( width * height < IMAGE_JOB_MIN_PIXELS * 4 || !ri.Jobs_NumThreads() ) {
+		R_MipMap( in, width, height, samples, alignment );
+		return in;
+	}
+
+	if( !*other ) {
+		*other = R_PrepareImageBuffer( ctx, TEXTURE_MIPMAP_BUF,
+			Q_ALIGN( max( width >> 1, 1 ) * samples, alignment ) * max( height >> 1, 1 ) );
+	}
+
+	out = *other;
+	R_MipMapExt( in, out, width, height, samples, alignment, true );
+	*other = in;
+	return out;
+}
+
 /*
  * R_MipMap16
  *
@@ -1132,11 +1416,12 @@ static void R_Upload32( int ctx, uint8_t **data, int layer, int x, int y, int wi
 			if( !( flags & IT_NOMIPMAP ) && mip ) {
 				int w, h;
 				int miplevel = 0;
+				uint8_t *mipTemp = NULL;
 
 				w = scaledWidth;
 				h = scaledHeight;
 				while( w > minmipsize || h > minmipsize ) {
-					R_MipMap( mip, w, h, samples, 1 );
+					mip = R_MipMapToBuffer( ctx, mip, &mipTemp, w, h, samples, 1 );
 
 					w >>= 1;
 					h >>= 1;
@@ -1507,26 +1792,66 @@ typedef struct ktx_header_s {
 	int bytesOfKeyValueData;
 } ktx_header_t;
 
+/*
+ * R_FindKTXKeyValue
+ *
+ * Returns the null-terminated value for the key, or NULL if there's no such key.
+ */
+static const char *R_FindKTXKeyValue( const uint8_t *keyValueData, int size, const char *key )
+{
+	const uint8_t *end = keyValueData + size;
+	size_t keyLen = strlen( key ) + 1;
+
+	while( end - keyValueData >= 4 ) {
+		unsigned pairSize = *( (const unsigned *)keyValueData );
+		const char *pair = (const char *)keyValueData + 4;
+
+		if( pairSize > (size_t)( end - (const uint8_t *)pair ) ) {
+			break;
+		}
+		if( pairSize > keyLen && !memcmp( pair, key, keyLen ) ) {
+			return memchr( pair + keyLen, 0, pairSize - keyLen ) ? pair + keyLen : NULL;
+		}
+		keyValueData = (const uint8_t *)pair + Q_ALIGN( pairSize, 4 );
+	}
+
+	return NULL;
+}
+
 /*
  * R_LoadKTX
+ *
+ * If cacheKey is not NULL, the file is a preprocessed picture from the texture
+ * cache, which is only used if it was made from the same source with the same settings.
  */
-static bool R_LoadKTX( int ctx, image_t *image, const char *pathname )
+static bool R_LoadKTX( int ctx, image_t *image, const char *pathname, const char *cacheKey )
 {
 	int i, j;
+	int len;
 	uint8_t *buffer;
 	ktx_header_t *header;
 	bool swapEndian;
 	uint8_t *data;
 	int numFaces = ( ( image->flags & IT_CUBEMAP ) ? 6 : 1 ), numMips;
+	int uploadFlags = image->flags;
+	int sourceWidth = 0, sourceHeight = 0;
 
 	if( image->flags & ( IT_FLIPX | IT_FLIPY | IT_FLIPDIAGONAL ) ) {
 		return false;
 	}
 
-	R_LoadFile( pathname, (void **)&buffer );
+	if( cacheKey ) {
+		len = R_LoadCacheFile( pathname, (void **)&buffer );
+	} else {
+		len = R_LoadFile( pathname, (void **)&buffer );
+	}
 	if( !buffer ) {
 		return false;
 	}
+	if( len < (int)sizeof( ktx_header_t ) ) {
+		ri.Com_DPrintf( S_COLOR_YELLOW "R_LoadKTX: Truncated file: %s\n", pathname );
+		goto error;
+	}
 
 	header = (ktx_header_t *)buffer;
 	if( memcmp( header->identifier, "\xABKTX 11\xBB\r\n\x1A\n", 12 ) ) {
@@ -1579,6 +1904,40 @@ static bool R_LoadKTX( int ctx, image_t *image, const char *pathname )
 
 	numMips = R_MipCount( header->pixelWidth, header->pixelHeight, image->minmipsize );
 
+	if( ( header->bytesOfKeyValueData < 0 ) ||
+		( header->bytesOfKeyValueData > len - (int)sizeof( ktx_header_t ) ) ) {
+		ri.Com_DPrintf( S_COLOR_YELLOW "R_LoadKTX: Bad key/value data size: %s\n", pathname );
+		goto error;
+	}
+
+	if( cacheKey ) {
+		const uint8_t *keyValueData = buffer + sizeof( ktx_header_t );
+		const char *value;
+		int loadFlags;
+
+		// cache files are always written in native byte order, with no block compression
+		if( swapEndian || ( header->type != GL_UNSIGNED_BYTE ) ) {
+			goto error;
+		}
+
+		value = R_FindKTXKeyValue( keyValueData, header->bytesOfKeyValueData, TEXTURECACHE_KEY );
+		if( !value || strcmp( value, cacheKey ) ) {
+			goto error;
+		}
+
+		value = R_FindKTXKeyValue( keyValueData, header->bytesOfKeyValueData, TEXTURECACHE_IMAGE_KEY );
+		if( !value || ( sscanf( value, "%i %i %i", &sourceWidth, &sourceHeight, &loadFlags ) != 3 ) ) {
+			goto error;
+		}
+
+		// restore what the loader learned from the source picture, the pixels are already downscaled
+		image->flags = ( image->flags & ~TEXTURECACHE_LOADFLAGS ) | ( loadFlags & TEXTURECACHE_LOADFLAGS );
+		if( image->flags & IT_WAL ) {
+			image->flags &= ~IT_SRGB;
+		}
+		uploadFlags = image->flags | IT_NOPICMIP;
+	}
+
 	data = buffer + sizeof( ktx_header_t ) + header->bytesOfKeyValueData;
 
 	R_BindImage( image );
@@ -1710,6 +2069,11 @@ static bool R_LoadKTX( int ctx, image_t *image, const char *pathname )
 			data += faceSize * numFaces;
 		}
 
+		if( cacheKey && ( data > buffer + len ) ) {
+			ri.Com_DPrintf( S_COLOR_YELLOW "R_LoadKTX: Truncated file: %s\n", pathname );
+			goto error;
+		}
+
 		if( !glConfig.ext.bgra &&
 			( ( header->baseInternalFormat == GL_BGR_EXT ) || ( header->baseInternalFormat == GL_BGRA_EXT ) ) ) {
 			for( i = 0; i < mips; i++ ) {
@@ -1744,13 +2108,18 @@ static bool R_LoadKTX( int ctx, image_t *image, const char *pathname )
 			}
 		}
 
-		R_UploadMipmapped( ctx, images, header->pixelWidth, header->pixelHeight, mips, image->flags, image->minmipsize,
+		R_UploadMipmapped( ctx, images, header->pixelWidth, header->pixelHeight, mips, uploadFlags, image->minmipsize,
 			&image->upload_width, &image->upload_height, header->baseInternalFormat, header->type );
 	}
 
 	Q_strncpyz( image->extension, ".ktx", sizeof( image->extension ) );
-	image->width = header->pixelWidth;
-	image->height = header->pixelHeight;
+	if( cacheKey ) {
+		image->width = sourceWidth;
+		image->height = sourceHeight;
+	} else {
+		image->width = header->pixelWidth;
+		image->height = header->pixelHeight;
+	}
 
 	R_FreeFile( buffer );
 	R_DeferDataSync();
@@ -1764,6 +2133,392 @@ error: // must not be reached after actually starting uploading the texture
 /*
 =========================================================
 
+TEXTURE CACHE
+
+=========================================================
+*/
+
+/*
+ * R_TextureCacheFile
+ *
+ * Finds the source picture for the image and replaces the extension in the
+ * pathname with its own. Returns false if the image can't be cached, otherwise
+ * fills in the name of the cache file and the key stored in it. The name depends
+ * on the image name and the settings used for preprocessing, the key also on
+ * the checksum of the pk3 the source comes from, or its modification time for
+ * loose files, so stale cache files are replaced.
+ */
+static bool R_TextureCacheFile( const char *name, char *pathname, size_t pathnameSize, int flags, int minmipsize,
+	char *path, size_t pathSize, char *key, size_t keySize )
+{
+	int picmip = 0;
+	unsigned stamp, mtime;
+	const char *extension, *pakname;
+	char settings[128];
+
+	if( !r_texturecache->integer || ( flags & TEXTURECACHE_NOFLAGS ) ) {
+		return false;
+	}
+
+	extension = ri.FS_FirstExtension( pathname, IMAGE_EXTENSIONS, NUM_IMAGE_EXTENSIONS - 1 ); // last is KTX
+	if( !extension || !Q_stricmp( extension, ".svg" ) ) {
+		return false;
+	}
+	COM_ReplaceExtension( pathname, extension, pathnameSize );
+
+	if( !( flags & IT_NOPICMIP ) ) {
+		picmip = ( flags & IT_SKY ) ? r_skymip->integer : r_picmip->integer;
+	}
+
+	Q_snprintfz( settings, sizeof( settings ), "%i %x %i %i %i %i %i", TEXTURECACHE_VERSION,
+		( flags & ~IT_LOADFLAGS ) | ( flags & IT_SRGB ),
+		minmipsize, picmip, glConfig.maxTextureSize, glConfig.ext.texture_non_power_of_two ? 1 : 0,
+		glConfig.ext.bgra ? 1 : 0 );
+
+	// FS_PakNameForFile only searches paks while the loader searches everything,
+	// so the time stamp of the file it opens tells apart a loose override
+	pakname = ri.FS_PakNameForFile( pathname );
+	stamp = pakname ? ri.FS_ChecksumBaseFile( pakname, false ) : 0;
+	mtime = (unsigned)ri.FS_FileMTime( pathname );
+
+	Q_snprintfz( path, pathSize, "%s/%s.%08x.ktx", TEXTURECACHE_DIR, name,
+		COM_SuperFastHash( (const uint8_t *)settings, strlen( settings ) ) );
+	Q_snprintfz( key, keySize, "%s %s %08x %08x", settings, pathname, stamp, mtime );
+	return true;
+}
+
+/*
+ * R_WriteKTXKeyValue
+ *
+ * Returns the size of the key/value pair. Only computes the size if data is NULL.
+ */
+static size_t R_WriteKTXKeyValue( uint8_t *data, const char *key, const char *value )
+{
+	size_t keyLen = strlen( key ) + 1, valueLen = strlen( value ) + 1;
+
+	if( data ) {
+		*( (unsigned *)data ) = keyLen + valueLen;
+		memcpy( data + 4, key, keyLen );
+		memcpy( data + 4 + keyLen, value, valueLen );
+	}
+
+	return 4 + Q_ALIGN( keyLen + valueLen, 4 );
+}
+
+/*
+ * R_BuildTextureCacheFile
+ *
+ * Does to a picture what R_Upload32 does before uploading it, keeping all
+ * mipmap levels, and lays the results out as an uncompressed KTX file.
+ * Returns the file contents, which must be freed with R_Free, and stores
+ * pointers to the mipmap levels within in mips.
+ */
+static uint8_t *R_BuildTextureCacheFile( const uint8_t *pic, int width, int height, int samples, int flags,
+	int minmipsize, const char *key, size_t *size, uint8_t **mips )
+{
+	int i, w, h;
+	int comp, format, type;
+	int scaledWidth, scaledHeight, numMips;
+	size_t stride, keyValueSize;
+	char imageValue[64];
+	unsigned *lineBuf;
+	uint8_t *buffer, *data;
+	ktx_header_t *header;
+
+	R_ScaledImageSize( width, height, &scaledWidth, &scaledHeight, flags, 1, minmipsize, false );
+	numMips = ( flags & IT_NOMIPMAP ) ? 1 : R_MipCount( scaledWidth, scaledHeight, minmipsize );
+	R_TextureFormat( flags, samples, &comp, &format, &type );
+
+	Q_snprintfz( imageValue, sizeof( imageValue ), "%i %i %i", width, height, flags );
+	keyValueSize = R_WriteKTXKeyValue( NULL, TEXTURECACHE_KEY, key ) +
+				   R_WriteKTXKeyValue( NULL, TEXTURECACHE_IMAGE_KEY, imageValue );
+
+	*size = sizeof( *header ) + keyValueSize;
+	for( i = 0, w = scaledWidth, h = scaledHeight; i < numMips; i++ ) {
+		*size += sizeof( int ) + Q_ALIGN( w * samples, 4 ) * h;
+		w = max( w >> 1, 1 );
+		h = max( h >> 1, 1 );
+	}
+
+	buffer = R_MallocExt( r_imagesPool, *size, 16, 1 );
+
+	header = (ktx_header_t *)buffer;
+	memcpy( header->identifier, "\xABKTX 11\xBB\r\n\x1A\n", 12 );
+	header->endianness = 0x04030201;
+	header->type = GL_UNSIGNED_BYTE;
+	header->typeSize = 1;
+	header->format = header->internalFormat = header->baseInternalFormat = format;
+	header->pixelWidth = scaledWidth;
+	header->pixelHeight = scaledHeight;
+	header->numberOfFaces = 1;
+	header->numberOfMipmapLevels = numMips;
+	header->bytesOfKeyValueData = keyValueSize;
+
+	data = buffer + sizeof( *header );
+	data += R_WriteKTXKeyValue( data, TEXTURECACHE_KEY, key );
+	data += R_WriteKTXKeyValue( data, TEXTURECACHE_IMAGE_KEY, imageValue );
+
+	// KTX rows are 4-byte aligned while the source and the resampler use tight rows
+	stride = Q_ALIGN( scaledWidth * samples, 4 );
+	*( (int *)data ) = stride * scaledHeight;
+	mips[0] = data + sizeof( int );
+
+	lineBuf = R_MallocExt( r_imagesPool, scaledWidth * sizeof( *lineBuf ) * 2, 16, 0 );
+	if( stride == (size_t)( scaledWidth * samples ) ) {
+		R_ResampleTextureExt(
+			lineBuf, pic, width, height, mips[0], scaledWidth, scaledHeight, samples, 1, true, true );
+	} else {
+		uint8_t *temp = R_MallocExt( r_imagesPool, scaledWidth * scaledHeight * samples, 16, 0 );
+
+		R_ResampleTextureExt( lineBuf, pic, width, height, temp, scaledWidth, scaledHeight, samples, 1, true, true );
+		for( i = 0; i < scaledHeight; i++ ) {
+			memcpy( mips[0] + i * stride, temp + i * scaledWidth * samples, scaledWidth * samples );
+		}
+
+		R_Free( temp );
+	}
+	R_Free( lineBuf );
+
+	w = scaledWidth;
+	h = scaledHeight;
+	for( i = 1; i < numMips; i++ ) {
+		int mipSize = Q_ALIGN( w * samples, 4 ) * h;
+
+		data = mips[i - 1] + mipSize;
+		*( (int *)data ) = Q_ALIGN( max( w >> 1, 1 ) * samples, 4 ) * max( h >> 1, 1 );
+		mips[i] = data + sizeof( int );
+
+		R_MipMapExt( mips[i - 1], mips[i], w, h, samples, 4, true );
+
+		w = max( w >> 1, 1 );
+		h = max( h >> 1, 1 );
+	}
+
+	return buffer;
+}
+
+/*
+ * R_WriteTextureCacheFile
+ */
+static void R_WriteTextureCacheFile( const char *path, const uint8_t *data, size_t size )
+{
+	int handle;
+
+	if( ri.FS_FOpenFile( path, &handle, FS_WRITE | FS_CACHE ) == -1 ) {
+		ri.Com_DPrintf( S_COLOR_YELLOW "Could not open %s for writing.\n", path );
+		return;
+	}
+
+	ri.FS_Write( data, size, handle );
+	ri.FS_FCloseFile( handle );
+}
+
+/*
+ * R_UploadAndCacheImage
+ *
+ * Preprocesses the picture, uploads the results and stores them in the texture cache.
+ */
+static void R_UploadAndCacheImage( int ctx, image_t *image, uint8_t *pic, int width, int height, int samples,
+	int flags, const char *path, const char *key )
+{
+	size_t size;
+	uint8_t *mips[32];
+	uint8_t *data = R_BuildTextureCacheFile( pic, width, height, samples, flags, image->minmipsize, key, &size, mips );
+	const ktx_header_t *header = (const ktx_header_t *)data;
+
+	// the picture has already been downscaled, don't apply picmip again
+	R_UploadMipmapped( ctx, mips, header->pixelWidth, header->pixelHeight, header->numberOfMipmapLevels,
+		flags | IT_NOPICMIP, image->minmipsize, &image->upload_width, &image->upload_height, header->format,
+		GL_UNSIGNED_BYTE );
+
+	R_WriteTextureCacheFile( path, data, size );
+
+	R_Free( data );
+}
+
+/*
+ * R_AllocDecodedImageCb
+ */
+static uint8_t *R_AllocDecodedImageCb( void *ptr, size_t size, const char *filename, int linenum )
+{
+	uint8_t **pbuf = ptr;
+
+	*pbuf = ri.Mem_AllocExt( r_imagesPool, size, 16, 0, filename, linenum );
+	return *pbuf;
+}
+
+/*
+ * R_DecodeImageFile
+ *
+ * Decodes a TGA, JPEG or PNG picture into memory from r_imagesPool, which the
+ * caller must free. Unlike R_ReadImageFromDisk, can be called from any thread.
+ */
+static r_imginfo_t R_DecodeImageFile( const char *pathname )
+{
+	uint8_t *buf = NULL;
+	const char *extension = COM_FileExtension( pathname );
+	r_imginfo_t imginfo;
+
+	memset( &imginfo, 0, sizeof( imginfo ) );
+
+	if( !Q_stricmp( extension, ".jpg" ) ) {
+		imginfo = LoadJPG( pathname, R_AllocDecodedImageCb, &buf );
+	} else if( !Q_stricmp( extension, ".tga" ) ) {
+		imginfo = LoadTGA( pathname, R_AllocDecodedImageCb, &buf );
+	} else if( !Q_stricmp( extension, ".png" ) ) {
+		imginfo = LoadPNG( pathname, R_AllocDecodedImageCb, &buf );
+	}
+
+	if( !imginfo.pixels && buf ) {
+		R_Free( buf );
+	}
+	return imginfo;
+}
+
+typedef struct {
+	const char *source;
+	int flags;
+	bool built;
+} textureCacheItem_t;
+
+/*
+ * R_BuildTextureCacheJob
+ */
+static void R_BuildTextureCacheJob( void *arg )
+{
+	textureCacheItem_t *item = arg;
+	int flags = item->flags;
+	char name[1024], pathname[1024], path[1024], key[1024];
+	uint8_t *mips[32], *data;
+	size_t size;
+	r_imginfo_t info;
+
+	Q_strncpyz( name, item->source, sizeof( name ) );
+	COM_StripExtension( name );
+	Q_strlwr( name );
+
+	// skip the picture if another one with the same name takes priority
+	Q_strncpyz( pathname, item->source, sizeof( pathname ) );
+	if( !R_TextureCacheFile( name, pathname, sizeof( pathname ), flags, 1, path, sizeof( path ), key, sizeof( key ) ) ||
+		strcmp( pathname, item->source ) ) {
+		return;
+	}
+
+	info = R_DecodeImageFile( pathname );
+	if( !info.pixels ) {
+		return;
+	}
+
+	if( info.samples >= 3 && ( info.comp & ~1 ) == IMGCOMP_BGR ) {
+		if( glConfig.ext.bgra ) {
+			flags |= IT_BGRA;
+		} else {
+			R_SwapBlueRed( info.pixels, info.width, info.height, info.samples, 1 );
+		}
+	}
+
+	data = R_BuildTextureCacheFile( info.pixels, info.width, info.height, info.samples, flags, 1, key, &size, mips );
+	R_WriteTextureCacheFile( path, data, size );
+	item->built = true;
+
+	R_Free( data );
+	R_Free( info.pixels );
+}
+
+/*
+ * R_BuildTextureCache_f
+ *
+ * buildtexturecache <directory> [2d]
+ *
+ * Converts all TGA, JPEG and PNG pictures in the directory to preprocessed KTX
+ * files in the texture cache, on the job system. The pictures are converted
+ * for use in world shaders, or in 2D pics if "2d" is specified.
+ */
+void R_BuildTextureCache_f( void )
+{
+	int i, j, k, n, numItems, numBuilt;
+	int flags;
+	char dir[MAX_QPATH], listBuf[1024];
+	char *names = NULL;
+	size_t namesSize = 0, len;
+	const char *ptr;
+	textureCacheItem_t *items;
+	qjobcounter_t counter;
+	uint64_t t0;
+	static const char *extensions[] = { ".tga", ".jpg", ".png" };
+
+	if( ri.Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <directory> [2d]\n", ri.Cmd_Argv( 0 ) );
+		return;
+	}
+
+	if( !r_texturecache->integer ) {
+		Com_Printf( "Texture cache is disabled, set r_texturecache to 1\n" );
+		return;
+	}
+
+	Q_strncpyz( dir, ri.Cmd_Argv( 1 ), sizeof( dir ) );
+	len = strlen( dir );
+	while( len > 0 && dir[len - 1] == '/' ) {
+		dir[--len] = '\0';
+	}
+	flags = ( ri.Cmd_Argc() > 2 && !Q_stricmp( ri.Cmd_Argv( 2 ), "2d" ) ) ? IT_SPECIAL : 0;
+
+	numItems = 0;
+	for( i = 0; i < (int)( sizeof( extensions ) / sizeof( extensions[0] ) ); i++ ) {
+		n = ri.FS_GetFileList( dir, extensions[i], NULL, 0, 0, 0 );
+		for( j = 0; j < n; j += k ) {
+			k = ri.FS_GetFileList( dir, extensions[i], listBuf, sizeof( listBuf ), j, n );
+			if( !k ) {
+				k = 1; // advance by one file
+				continue;
+			}
+
+			for( ptr = listBuf; *ptr; ptr += strlen( ptr ) + 1 ) {
+				len = strlen( dir ) + 1 + strlen( ptr ) + 1;
+				names = names ? R_Realloc( names, namesSize + len ) : R_Malloc( len );
+				Q_snprintfz( names + namesSize, len, "%s/%s", dir, ptr );
+				namesSize += len;
+				numItems++;
+			}
+		}
+	}
+
+	if( !numItems ) {
+		Com_Printf( "No pictures found in %s\n", dir );
+		return;
+	}
+
+	items = R_Malloc( sizeof( *items ) * numItems );
+	for( i = 0, ptr = names; i < numItems; i++, ptr += strlen( ptr ) + 1 ) {
+		items[i].source = ptr;
+		items[i].flags = flags;
+	}
+
+	memset( &counter, 0, sizeof( counter ) );
+	t0 = ri.Sys_Microseconds();
+	for( i = 0; i < numItems; i++ ) {
+		ri.Jobs_Add( &counter, NULL, R_BuildTextureCacheJob, &items[i] );
+	}
+	ri.Jobs_Wait( &counter );
+
+	numBuilt = 0;
+	for( i = 0; i < numItems; i++ ) {
+		if( items[i].built ) {
+			numBuilt++;
+		}
+	}
+
+	Com_Printf( "%i of %i pictures converted in %.1f ms\n", numBuilt, numItems,
+		( ri.Sys_Microseconds() - t0 ) / 1000.0 );
+
+	R_Free( items );
+	R_Free( names );
+}
+
+/*
+=========================================================
+
 MIPTEX LOADING
 
 =========================================================
@@ -1859,7 +2614,7 @@ static bool R_LoadImageFromDisk( int ctx, image_t *image )
 	memcpy( pathname, image->name, len + 1 );
 
 	Q_strncatz( pathname, ".ktx", pathsize );
-	if( R_LoadKTX( ctx, image, pathname ) ) {
+	if( R_LoadKTX( ctx, image, pathname, NULL ) ) {
 		return true;
 	}
 	pathname[len] = 0;
@@ -1952,8 +2707,20 @@ static bool R_LoadImageFromDisk( int ctx, image_t *image )
 		}
 	} else {
 		uint8_t *pic = NULL;
+		char cachePath[1024], cacheKey[1024];
+		bool cached = false;
 
 		Q_strncatz( pathname, ".tga", pathsize );
+
+		// SVG pictures are rasterized at the requested size, which makes no sense to cache
+		if( width <= 1 || height <= 1 ) {
+			cached = R_TextureCacheFile( image->name, pathname, pathsize, flags, image->minmipsize, cachePath,
+				sizeof( cachePath ), cacheKey, sizeof( cacheKey ) );
+			if( cached && R_LoadKTX( ctx, image, cachePath, cacheKey ) ) {
+				return true;
+			}
+		}
+
 		samples = R_ReadImageFromDisk( ctx, pathname, pathsize, &pic, &width, &height, &flags, 0 );
 
 		if( samples != 0 ) {
@@ -1963,8 +2730,12 @@ static bool R_LoadImageFromDisk( int ctx, image_t *image )
 
 			R_BindImage( image );
 
-			R_Upload32( ctx, &pic, 0, 0, 0, width, height, flags, image->minmipsize, &image->upload_width,
-				&image->upload_height, samples, false, false );
+			if( cached ) {
+				R_UploadAndCacheImage( ctx, image, pic, width, height, samples, flags, cachePath, cacheKey );
+			} else {
+				R_Upload32( ctx, &pic, 0, 0, 0, width, height, flags, image->minmipsize, &image->upload_width,
+					&image->upload_height, samples, false, false );
+			}
 
 			image->error = qglGetError();
 			Q_strncpyz( image->extension, &pathname[len], sizeof( image->extension ) );
@@ -3533,3 +4304,241 @@ static void *R_ImageLoaderThreadProc( void *param )
 
 	return NULL;
 }
+
+#ifndef PUBLIC_BUILD
+
+/*
+=================================================================
+
+IMAGE PREPROCESSING BENCHMARK
+
+=================================================================
+*/
+
+typedef struct {
+	const char *name;
+	uint64_t decodeTime;
+	uint64_t prepTime[2];
+	unsigned checksum[2];
+	bool missing;
+} imageBenchItem_t;
+
+/*
+ * R_ImageBench_Prepare
+ *
+ * Does what R_Upload32 does to a picture before uploading it, with r_picmip 1:
+ * swizzles, halves the size and builds the mipmap chain. Returns the checksum
+ * of all mipmap levels. Destroys the source pixels.
+ */
+static unsigned R_ImageBench_Prepare( r_imginfo_t *info, bool fast )
+{
+	int w, h, samples = info->samples;
+	unsigned checksum = 0;
+	unsigned *lineBuf;
+	uint8_t *mip, *temp;
+
+	if( samples >= 3 && ( info->comp & ~1 ) == IMGCOMP_BGR ) {
+		R_SwapBlueRedExt( info->pixels, info->width, info->height, samples, 1, fast, fast );
+	}
+
+	w = max( info->width >> 1, 1 );
+	h = max( info->height >> 1, 1 );
+	mip = R_MallocExt( r_imagesPool, w * h * samples, 16, 0 );
+	lineBuf = R_MallocExt( r_imagesPool, w * sizeof( *lineBuf ) * 2, 16, 0 );
+
+	R_ResampleTextureExt( lineBuf, info->pixels, info->width, info->height, mip, w, h, samples, 1, fast, fast );
+
+	// the source is no longer needed, use it for ping-ponging
+	temp = info->pixels;
+	for( ;; ) {
+		checksum = checksum * 31 + COM_SuperFastHash( mip, w * h * samples );
+		if( w == 1 && h == 1 ) {
+			break;
+		}
+
+		if( fast ) {
+			uint8_t *out = temp;
+			R_MipMapExt( mip, out, w, h, samples, 1, true );
+			temp = mip;
+			mip = out;
+		} else {
+			R_MipMapExt( mip, mip, w, h, samples, 1, false );
+		}
+
+		w = max( w >> 1, 1 );
+		h = max( h >> 1, 1 );
+	}
+
+	if( mip != info->pixels ) {
+		R_Free( mip );
+	} else {
+		R_Free( temp );
+	}
+	R_Free( lineBuf );
+	return checksum;
+}
+
+/*
+ * R_ImageBench_Job
+ *
+ * Decodes and prepares one picture, the way a loader would do it.
+ */
+static void R_ImageBench_Job( void *arg )
+{
+	imageBenchItem_t *item = arg;
+	r_imginfo_t info = R_DecodeImageFile( item->name );
+
+	if( !info.pixels ) {
+		return;
+	}
+
+	item->checksum[1] = R_ImageBench_Prepare( &info, true );
+	R_Free( info.pixels );
+}
+
+/*
+ * R_ImageBench_f
+ *
+ * imagebench <directory> [maximages]
+ *
+ * Decodes all TGA, JPEG and PNG pictures in the directory and runs them
+ * through the preprocessing done before uploads with scalar code on a single
+ * thread, and with SIMD code on the job system. Then decodes and prepares
+ * them all concurrently on the job system. No GL calls are made.
+ */
+void R_ImageBench_f( void )
+{
+	int i, j, k, n, numItems, maxItems;
+	char dir[MAX_QPATH], listBuf[1024];
+	char *names = NULL;
+	size_t namesSize = 0, len;
+	const char *ptr;
+	imageBenchItem_t *items;
+	uint64_t t0, t1, t2, decodeTime = 0, prepTime[2] = { 0, 0 }, pipelineTime;
+	qjobcounter_t counter;
+	int numMismatches = 0, numLoaded = 0;
+	double megapixels = 0;
+	static const char *extensions[] = { ".tga", ".jpg", ".png" };
+
+	if( ri.Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <directory> [maximages]\n", ri.Cmd_Argv( 0 ) );
+		return;
+	}
+
+	Q_strncpyz( dir, ri.Cmd_Argv( 1 ), sizeof( dir ) );
+	len = strlen( dir );
+	while( len > 0 && dir[len - 1] == '/' ) {
+		dir[--len] = '\0';
+	}
+	maxItems = ri.Cmd_Argc() > 2 ? atoi( ri.Cmd_Argv( 2 ) ) : 0;
+	if( maxItems <= 0 ) {
+		maxItems = INT_MAX;
+	}
+
+	// gather full paths to all pictures in the directory
+	numItems = 0;
+	for( i = 0; i < (int)( sizeof( extensions ) / sizeof( extensions[0] ) ); i++ ) {
+		n = ri.FS_GetFileList( dir, extensions[i], NULL, 0, 0, 0 );
+		for( j = 0; j < n && numItems < maxItems; j += k ) {
+			k = ri.FS_GetFileList( dir, extensions[i], listBuf, sizeof( listBuf ), j, n );
+			if( !k ) {
+				k = 1; // advance by one file
+				continue;
+			}
+
+			for( ptr = listBuf; *ptr && numItems < maxItems; ptr += strlen( ptr ) + 1 ) {
+				len = strlen( dir ) + 1 + strlen( ptr ) + 1;
+				names = names ? R_Realloc( names, namesSize + len ) : R_Malloc( len );
+				Q_snprintfz( names + namesSize, len, "%s/%s", dir, ptr );
+				namesSize += len;
+				numItems++;
+			}
+		}
+	}
+
+	if( !numItems ) {
+		Com_Printf( "No pictures found in %s\n", dir );
+		return;
+	}
+
+	items = R_Malloc( sizeof( *items ) * numItems );
+	for( i = 0, ptr = names; i < numItems; i++, ptr += strlen( ptr ) + 1 ) {
+		items[i].name = ptr;
+	}
+
+	// single threaded scalar code vs SIMD kernels over the job system, on the same pixels
+	for( i = 0; i < numItems; i++ ) {
+		imageBenchItem_t *item = &items[i];
+		r_imginfo_t info[2];
+
+		t0 = ri.Sys_Microseconds();
+		info[0] = R_DecodeImageFile( item->name );
+		t1 = ri.Sys_Microseconds();
+		if( !info[0].pixels ) {
+			item->missing = true;
+			continue;
+		}
+
+		info[1] = info[0];
+		info[1].pixels = R_MallocExt( r_imagesPool, info[0].width * info[0].height * info[0].samples, 16, 0 );
+		memcpy( info[1].pixels, info[0].pixels, info[0].width * info[0].height * info[0].samples );
+
+		item->decodeTime = t1 - t0;
+
+		t0 = ri.Sys_Microseconds();
+		item->checksum[0] = R_ImageBench_Prepare( &info[0], false );
+		t1 = ri.Sys_Microseconds();
+		item->checksum[1] = R_ImageBench_Prepare( &info[1], true );
+		t2 = ri.Sys_Microseconds();
+
+		item->prepTime[0] = t1 - t0;
+		item->prepTime[1] = t2 - t1;
+		if( item->checksum[0] != item->checksum[1] ) {
+			Com_Printf( S_COLOR_RED "%s: SIMD preprocessing results differ\n", item->name );
+			numMismatches++;
+		}
+
+		decodeTime += item->decodeTime;
+		prepTime[0] += item->prepTime[0];
+		prepTime[1] += item->prepTime[1];
+		megapixels += info[0].width * info[0].height / 1000000.0;
+		numLoaded++;
+
+		R_Free( info[0].pixels );
+		R_Free( info[1].pixels );
+	}
+
+	// the whole thing as a pipeline, all pictures are decoded and prepared concurrently
+	memset( &counter, 0, sizeof( counter ) );
+	t0 = ri.Sys_Microseconds();
+	for( i = 0; i < numItems; i++ ) {
+		if( !items[i].missing ) {
+			ri.Jobs_Add( &counter, NULL, R_ImageBench_Job, &items[i] );
+		}
+	}
+	ri.Jobs_Wait( &counter );
+	pipelineTime = ri.Sys_Microseconds() - t0;
+
+	for( i = 0; i < numItems; i++ ) {
+		if( !items[i].missing && items[i].checksum[0] != items[i].checksum[1] ) {
+			Com_Printf( S_COLOR_RED "%s: pipelined preprocessing results differ\n", items[i].name );
+			numMismatches++;
+		}
+	}
+
+	Com_Printf( "imagebench: %i pictures, %.1f megapixels, %i job threads\n", numLoaded, megapixels,
+		ri.Jobs_NumThreads() );
+	Com_Printf( "decode:          %8.1f ms\n", decodeTime / 1000.0 );
+	Com_Printf( "prepare, scalar: %8.1f ms\n", prepTime[0] / 1000.0 );
+	Com_Printf( "prepare, SIMD:   %8.1f ms\n", prepTime[1] / 1000.0 );
+	Com_Printf( "serial total:    %8.1f ms\n", ( decodeTime + prepTime[0] ) / 1000.0 );
+	Com_Printf( "pipelined total: %8.1f ms\n", pipelineTime / 1000.0 );
+	if( numMismatches ) {
+		Com_Printf( S_COLOR_RED "%i mismatches\n", numMismatches );
+	}
+
+	R_Free( items );
+	R_Free( names );
+}
+
+#endif // PUBLIC_BUILD
@@ -128,5 +128,10 @@ void R_ReplaceImage( image_t *image, uint8_t **pic, int width, int height, int f
 void R_ReplaceSubImage( image_t *image, int layer, int x, int y, uint8_t **pic, int width, int height );
 void R_ReplaceImageLayer( image_t *image, int layer, uint8_t **pic );
 unsigned *R_LoadPalette( int flags );
+void R_BuildTextureCache_f( void );
+
+#ifndef PUBLIC_BUILD
+void R_ImageBench_f( void );
+#endif
 
 #endif // R_IMAGE_H
@@ -20,158 +20,116 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "r_local.h"
 
-typedef unsigned (*queueCmdHandler_t)( const void * );
+// jobs are run by the engine job system, this only keeps copies of the
+// arguments around until the jobs are finished
+#define MAX_PENDING_JOBS 1024
 
-enum {
-	CMD_JOB_TAKE,
-	CMD_JOB_QUIT,
-
-	NUM_JOB_CMDS
-};
+// dependent jobs open a new stage, which only starts when all jobs of
+// the previous stage are finished
+#define MAX_JOB_STAGES 8
 
 typedef struct {
-	int id;
-	unsigned first;
-	unsigned items;
 	jobfunc_t job;
 	jobarg_t job_arg;
-} jobTakeCmd_t;
+	unsigned items;
+	unsigned stage;
+} pendingJob_t;
 
-static qbufPipe_t *job_queue[NUM_JOB_THREADS] = { NULL };
-static qthread_t *job_thread[NUM_JOB_THREADS] = { NULL };
+static pendingJob_t job_pending[MAX_PENDING_JOBS];
 static unsigned job_count;
-
-static void RJ_IssueJobTakeCmd( unsigned thread, jobfunc_t job, jobarg_t *arg, unsigned first, unsigned stride );
-static void RJ_IssueJobQuitCmd( unsigned thread );
-static void *R_JobThreadProc( void *param );
+static qjobcounter_t job_counters[MAX_JOB_STAGES];
+static unsigned job_stage;
 
 /*
 * RJ_Init
 */
 void RJ_Init( void ) {
-	int i;
-
 	job_count = 0;
-
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		job_queue[i] = ri.BufPipe_Create( 0x4000, 1 );
-		job_thread[i] = ri.Thread_Create( R_JobThreadProc, job_queue[i] );
-	}
+	job_stage = 0;
+	memset( job_counters, 0, sizeof( job_counters ) );
 }
 
 /*
-* RJ_ScheduleJob
+* R_RunJob
 */
-void RJ_ScheduleJob( jobfunc_t job, jobarg_t *arg, unsigned items ) {
-	unsigned first;
-	const unsigned block = ( items + NUM_JOB_THREADS - 1 ) / NUM_JOB_THREADS;
-
-	for( first = 0; first < items; ) {
-		unsigned last = first + block;
-		if( last > items ) {
-			last = items;
-		}
-
-		RJ_IssueJobTakeCmd( job_count % NUM_JOB_THREADS, job, arg, first, last - first );
-		job_count++;
+static void R_RunJob( unsigned first, unsigned items, void *arg ) {
+	pendingJob_t *pending = arg;
 
-		first += last - first;
-	}
+	pending->job( first, items, &pending->job_arg );
 }
 
 /*
-* RJ_FinishJobs
+* R_StartDependentJob
 */
-void RJ_FinishJobs( void ) {
-	int i;
+static void R_StartDependentJob( void *arg ) {
+	pendingJob_t *pending = arg;
 
-	for( i = 0; i < NUM_JOB_THREADS; i++ )
-		ri.BufPipe_Finish( job_queue[i] );
+	ri.Jobs_ParallelFor( &job_counters[pending->stage], pending->items, 1, R_RunJob, pending );
 }
 
 /*
-* RJ_Shutdown
+* RJ_ScheduleJob
 */
-void RJ_Shutdown( void ) {
-	int i;
-
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		RJ_IssueJobQuitCmd( i );
-	}
-
-	RJ_FinishJobs();
+void RJ_ScheduleJob( jobfunc_t job, jobarg_t *arg, unsigned items ) {
+	pendingJob_t *pending;
 
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		ri.Thread_Join( job_thread[i] );
-		job_thread[i] = NULL;
+	if( job_count == MAX_PENDING_JOBS ) {
+		job( 0, items, arg );
+		return;
 	}
 
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		ri.BufPipe_Destroy( &job_queue[i] );
-	}
+	pending = &job_pending[job_count++];
+	pending->job = job;
+	pending->job_arg = *arg;
+	pending->items = items;
+	pending->stage = job_stage;
 
-	job_count = 0;
+	ri.Jobs_ParallelFor( &job_counters[job_stage], items, 1, R_RunJob, pending );
 }
 
 /*
-* RJ_IssueJobTakeCmd
+* RJ_ScheduleDependentJob
+*
+* Schedules a job that won't start before all previously scheduled jobs
+* are finished. Jobs scheduled afterwards run alongside it.
 */
-static void RJ_IssueJobTakeCmd( unsigned thread, jobfunc_t job, jobarg_t *arg, unsigned first, unsigned items ) {
-	jobTakeCmd_t cmd;
-	cmd.id = CMD_JOB_TAKE;
-	cmd.job = job;
-	cmd.job_arg = *arg;
-	cmd.first = first;
-	cmd.items = items;
-	ri.BufPipe_WriteCmd( job_queue[thread], &cmd, sizeof( cmd ) );
-}
+void RJ_ScheduleDependentJob( jobfunc_t job, jobarg_t *arg, unsigned items ) {
+	pendingJob_t *pending;
 
-/*
- * RJ_IssueJobQuitCmd
- */
-static void RJ_IssueJobQuitCmd( unsigned thread ) {
-	int cmd = CMD_JOB_QUIT;
-	ri.BufPipe_WriteCmd( job_queue[thread], &cmd, sizeof( cmd ) );
-}
+	if( job_count == MAX_PENDING_JOBS || job_stage + 1 == MAX_JOB_STAGES ) {
+		RJ_FinishJobs();
+		RJ_ScheduleJob( job, arg, items );
+		return;
+	}
 
-/*
-* R_HandleJobTakeCmd
-*/
-static unsigned R_HandleJobTakeCmd( void *pcmd ) {
-	jobTakeCmd_t *cmd = pcmd;
+	job_stage++;
 
-	cmd->job( cmd->first, cmd->items, &cmd->job_arg );
+	pending = &job_pending[job_count++];
+	pending->job = job;
+	pending->job_arg = *arg;
+	pending->items = items;
+	pending->stage = job_stage;
 
-	return sizeof( *cmd );
+	ri.Jobs_Add( &job_counters[job_stage], &job_counters[job_stage - 1], R_StartDependentJob, pending );
 }
 
 /*
-* R_HandleJobQuitCmd
+* RJ_FinishJobs
 */
-static unsigned R_HandleJobQuitCmd( void *pcmd ) {
-	return 0;
-}
+void RJ_FinishJobs( void ) {
+	unsigned i;
 
-/*
-* R_JobCmdsWaiter
-*/
-static int R_JobCmdsWaiter( qbufPipe_t *queue, queueCmdHandler_t *cmdHandlers, bool timeout ) {
-	return ri.BufPipe_ReadCmds( queue, (void *)cmdHandlers );
+	for( i = 0; i <= job_stage; i++ ) {
+		ri.Jobs_Wait( &job_counters[i] );
+	}
+
+	job_count = 0;
+	job_stage = 0;
 }
 
 /*
-* R_JobThreadProc
+* RJ_Shutdown
 */
-static void *R_JobThreadProc( void *param ) {
-	qbufPipe_t *cmdQueue = param;
-	queueCmdHandler_t cmdHandlers[NUM_JOB_CMDS] =
-	{
-		(queueCmdHandler_t)R_HandleJobTakeCmd,
-		(queueCmdHandler_t)R_HandleJobQuitCmd,
-
-	};
-
-	ri.BufPipe_Wait( cmdQueue, R_JobCmdsWaiter, (void*)cmdHandlers, Q_THREADS_WAIT_INFINITE );
-
-	return NULL;
+void RJ_Shutdown( void ) {
+	RJ_FinishJobs();
 }
@@ -481,6 +481,8 @@ extern cvar_t *r_mode;
 extern cvar_t *r_nobind;
 extern cvar_t *r_picmip;
 extern cvar_t *r_skymip;
+extern cvar_t *r_texturecache;
+extern cvar_t *r_skm_simd;
 extern cvar_t *r_polyblend;
 extern cvar_t *r_lockpvs;
 extern cvar_t *r_screenshot_fnfmt;
@@ -752,6 +754,9 @@ void R_ReserveDrawListWorldSurfaces( drawList_t *list );
 void R_InitDrawLists( void );
 
 void R_SortDrawList( drawList_t *list );
+#ifndef PUBLIC_BUILD
+void R_DrawSortBench_f( void );
+#endif
 void R_DrawSurfaces( drawList_t *list );
 void R_DrawPortalSurfaces( drawList_t *list );
 void R_DrawSkySurfaces( drawList_t *list );
@@ -818,6 +823,11 @@ void    R_BatchBSPSurf( const entity_t *e, const shader_t *shader, const mfog_t
 void	R_FlushBSPSurfBatch( void );
 void	R_WalkBSPSurf( const entity_t *e, const shader_t *shader, int lightStyleNum, 
 	drawSurfaceBSP_t *drawSurf, walkDrawSurf_cb_cb cb, void *ptr );
+#ifndef PUBLIC_BUILD
+void	R_RecordWorldCullView( void );
+void	R_RunWorldCullBench( void );
+void	R_WorldCullBench_f( void );
+#endif
 
 //
 // r_skin.c
@@ -842,6 +852,10 @@ void        R_SkeletalGetBonePose( const model_t *mod, int bonenum, int frame, b
 int         R_SkeletalGetNumBones( const model_t *mod, int *numFrames );
 bool        R_SkeletalModelLerpTag( orientation_t *orient, const mskmodel_t *skmodel, int oldframenum, int framenum, float lerpfrac, const char *name );
 void		R_ClearSkeletalCache( void );
+void		R_ScheduleSkeletalCacheJobs( void );
+#ifndef PUBLIC_BUILD
+void		R_SkeletalKernelsTest_f( void );
+#endif
 
 //
 // r_vbo.c
@@ -1360,6 +1360,8 @@ void R_RenderView( const refdef_t *fd ) {
 		rf.stats.t_add_entities += ( ri.Sys_Milliseconds() - msec );
 	}
 
+	R_ScheduleSkeletalCacheJobs();
+
 	RJ_FinishJobs();
 
 	R_SortDrawList( rn.meshlist );
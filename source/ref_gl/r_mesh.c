@@ -96,8 +96,12 @@ static void R_ReserveDrawSurfaces( drawList_t *list, int minMeshes ) {
 		memcpy( newDs, ds, oldSize * sizeof( sortedDrawSurf_t ) );
 		R_Free( ds );
 	}
+	if( list->drawSurfsScratch ) {
+		R_Free( list->drawSurfsScratch );
+	}
 
 	list->drawSurfs = newDs;
+	list->drawSurfsScratch = R_Malloc( newSize * sizeof( sortedDrawSurf_t ) );
 	list->maxDrawSurfs = newSize;
 }
 
@@ -314,21 +318,192 @@ static int R_DrawSurfCompare( const sortedDrawSurf_t *sbs1, const sortedDrawSurf
 	return 0;
 }
 
+#define DRAWSURF_SORT_DIGITS        ( sizeof( unsigned int ) + 6 + sizeof( uintptr_t ) )
+#define DRAWSURF_SORT_MIN_RADIX     64
+
 /*
-* R_SortDrawList
+* R_DrawSurfSortDigit
+*
+* Returns 8-bit digit of the combined distKey:sortKey:drawSurf key, starting
+* with the least significant one. Only the lower 48 bits of sortKey are used.
+*/
+static inline unsigned R_DrawSurfSortDigit( const sortedDrawSurf_t *sds, unsigned digit ) {
+	if( digit < sizeof( uintptr_t ) ) {
+		return ( (uintptr_t)sds->drawSurf >> ( digit * 8 ) ) & 0xFF;
+	}
+	digit -= sizeof( uintptr_t );
+	if( digit < 6 ) {
+		return ( sds->sortKey >> ( digit * 8 ) ) & 0xFF;
+	}
+	digit -= 6;
+	return ( sds->distKey >> ( digit * 8 ) ) & 0xFF;
+}
+
+/*
+* R_InsertionSortDrawSurfs
+*/
+static void R_InsertionSortDrawSurfs( sortedDrawSurf_t *surfs, unsigned numSurfs ) {
+	unsigned i, j;
+	sortedDrawSurf_t tmp;
+
+	for( i = 1; i < numSurfs; i++ ) {
+		tmp = surfs[i];
+		for( j = i; j > 0 && R_DrawSurfCompare( &surfs[j - 1], &tmp ) > 0; j-- ) {
+			surfs[j] = surfs[j - 1];
+		}
+		surfs[j] = tmp;
+	}
+}
+
+/*
+* R_RadixSortDrawSurfs
 *
-* Regular quicksort. Note that for all kinds of transparent meshes
-* you probably want to set distance or draw order to prevent flickering
-* due to quicksort's unstable nature.
+* Stable LSD radix sort, giving the same order as R_DrawSurfCompare. Histograms
+* for all digits are gathered in a single pass and digits that are the same
+* for all surfaces are skipped, which is usually the case for the upper bits
+* of all keys. Returns either surfs or scratch, whichever holds the result.
+*/
+static sortedDrawSurf_t *R_RadixSortDrawSurfs( sortedDrawSurf_t *surfs, sortedDrawSurf_t *scratch, unsigned numSurfs ) {
+	unsigned i, d;
+	unsigned counts[DRAWSURF_SORT_DIGITS][256];
+	sortedDrawSurf_t *src = surfs, *dst = scratch, *tmp;
+
+	if( numSurfs < DRAWSURF_SORT_MIN_RADIX ) {
+		R_InsertionSortDrawSurfs( surfs, numSurfs );
+		return surfs;
+	}
+
+	memset( counts, 0, sizeof( counts ) );
+	for( i = 0; i < numSurfs; i++ ) {
+		for( d = 0; d < DRAWSURF_SORT_DIGITS; d++ ) {
+			counts[d][R_DrawSurfSortDigit( &surfs[i], d )]++;
+		}
+	}
+
+	for( d = 0; d < DRAWSURF_SORT_DIGITS; d++ ) {
+		unsigned *c = counts[d];
+		unsigned offset, n;
+
+		if( c[R_DrawSurfSortDigit( &src[0], d )] == numSurfs ) {
+			continue;
+		}
+
+		// turn counts into starting offsets
+		for( i = 0, offset = 0; i < 256; i++ ) {
+			n = c[i];
+			c[i] = offset;
+			offset += n;
+		}
+
+		for( i = 0; i < numSurfs; i++ ) {
+			dst[c[R_DrawSurfSortDigit( &src[i], d )]++] = src[i];
+		}
+
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	return src;
+}
+
+/*
+* R_SortDrawList
 */
 void R_SortDrawList( drawList_t *list ) {
+	sortedDrawSurf_t *sorted;
+
 	if( r_draworder->integer ) {
 		return;
 	}
-	qsort( list->drawSurfs, list->numDrawSurfs, sizeof( sortedDrawSurf_t ),
-		   ( int ( * )( const void *, const void * ) )R_DrawSurfCompare );
+	if( list->numDrawSurfs < 2 ) {
+		return;
+	}
+
+	sorted = R_RadixSortDrawSurfs( list->drawSurfs, list->drawSurfsScratch, list->numDrawSurfs );
+	if( sorted != list->drawSurfs ) {
+		// both buffers are the same size, so just swap them
+		list->drawSurfsScratch = list->drawSurfs;
+		list->drawSurfs = sorted;
+	}
 }
 
+#ifndef PUBLIC_BUILD
+
+/*
+* R_DrawSortBench_f
+*
+* drawsortbench [numsurfs] [iterations]
+*
+* Sorts random draw surfaces with qsort and with the radix sort,
+* checks that the order is the same and reports timings for both.
+*/
+void R_DrawSortBench_f( void ) {
+	int i, it, numSurfs, iterations;
+	sortedDrawSurf_t *surfs, *buf[3], *sorted = NULL;
+	uint64_t t0, t[2] = { 0, 0 };
+
+	numSurfs = ri.Cmd_Argc() > 1 ? atoi( ri.Cmd_Argv( 1 ) ) : 4096;
+	iterations = ri.Cmd_Argc() > 2 ? atoi( ri.Cmd_Argv( 2 ) ) : 100;
+	numSurfs = max( numSurfs, 1 );
+	iterations = max( iterations, 1 );
+
+	surfs = R_Malloc( sizeof( sortedDrawSurf_t ) * numSurfs );
+	buf[0] = R_Malloc( sizeof( sortedDrawSurf_t ) * numSurfs );
+	buf[1] = R_Malloc( sizeof( sortedDrawSurf_t ) * numSurfs );
+	buf[2] = R_Malloc( sizeof( sortedDrawSurf_t ) * numSurfs );
+
+	// mimic a typical view: few shader sorts, lots of surfaces sharing shaders
+	// and entities, and some surfaces added more than once (portals, fogs)
+	for( i = 0; i < numSurfs; i++ ) {
+		int shaderSort = rand() % 4 ? SHADER_SORT_OPAQUE : ( rand() % SHADER_SORT_NEAREST ) + 1;
+		float dist = shaderSort > SHADER_SORT_OPAQUE ? rand() % 0x800 : 0;
+		unsigned order = rand() % 16;
+
+		surfs[i].distKey = ( shaderSort << 26 ) | ( max( 0x400 - (int)dist, 0 ) << 15 ) | ( order & 0x7FFF );
+		surfs[i].sortKey = R_PackSortKey( rand() % 256, rand() % 8 ? -1 : rand() % 4,
+			rand() % 4 - 1, rand() % 16 ? -1 : rand() % 4, rand() % 8 ? 0 : rand() % MAX_REF_ENTITIES );
+		surfs[i].drawSurf = ( drawSurfaceType_t * )( (uintptr_t)( rand() % numSurfs ) * sizeof( drawSurfaceBSP_t ) + 0x10000 );
+	}
+
+	for( it = 0; it < iterations; it++ ) {
+		memcpy( buf[0], surfs, sizeof( sortedDrawSurf_t ) * numSurfs );
+		t0 = ri.Sys_Microseconds();
+		qsort( buf[0], numSurfs, sizeof( sortedDrawSurf_t ),
+			   ( int ( * )( const void *, const void * ) )R_DrawSurfCompare );
+		t[0] += ri.Sys_Microseconds() - t0;
+	}
+
+	for( it = 0; it < iterations; it++ ) {
+		memcpy( buf[1], surfs, sizeof( sortedDrawSurf_t ) * numSurfs );
+		t0 = ri.Sys_Microseconds();
+		sorted = R_RadixSortDrawSurfs( buf[1], buf[2], numSurfs );
+		t[1] += ri.Sys_Microseconds() - t0;
+	}
+
+	for( i = 0; i < numSurfs; i++ ) {
+		if( R_DrawSurfCompare( &buf[0][i], &sorted[i] ) ) {
+			break;
+		}
+	}
+
+	ri.Com_Printf( "drawsortbench: %i surfaces, %i iterations\n", numSurfs, iterations );
+	ri.Com_Printf( "qsort: %8.2f us\n", (double)t[0] / iterations );
+	ri.Com_Printf( "radix: %8.2f us\n", (double)t[1] / iterations );
+	if( i < numSurfs ) {
+		ri.Com_Printf( S_COLOR_RED "radix sort order differs at surface %i\n", i );
+	} else {
+		ri.Com_Printf( "radix sort order matches\n" );
+	}
+
+	R_Free( surfs );
+	R_Free( buf[0] );
+	R_Free( buf[1] );
+	R_Free( buf[2] );
+}
+
+#endif // PUBLIC_BUILD
+
 static const drawSurf_cb r_drawSurfCb[ST_MAX_TYPES] =
 {
 	/* ST_NONE */
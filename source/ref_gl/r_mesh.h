@@ -68,6 +68,7 @@ typedef struct {
 typedef struct {
 	unsigned int numDrawSurfs, maxDrawSurfs;
 	sortedDrawSurf_t *drawSurfs;
+	sortedDrawSurf_t *drawSurfsScratch;     // temp buffer for sorting, same size as drawSurfs
 
 	drawListBatch_t bspBatch;
 
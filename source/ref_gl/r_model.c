@@ -204,6 +204,17 @@ static void Mod_CreateVisLeafs( model_t *mod ) {
 		leaf->numVisSurfaces = numVisSurfaces;
 		leaf->numFragmentSurfaces = numFragmentSurfaces;
 	}
+
+	// leaf bounds in SoA layout: mins x, y, z, then maxs x, y, z
+	loadbmodel->leafBoundsStride = ( count + 3 ) & ~3;
+	loadbmodel->leafBounds = Mod_Malloc( mod, sizeof( float ) * 6 * loadbmodel->leafBoundsStride );
+	for( i = 0; i < count; i++ ) {
+		leaf = loadbmodel->leafs + i;
+		for( j = 0; j < 3; j++ ) {
+			loadbmodel->leafBounds[j * loadbmodel->leafBoundsStride + i] = leaf->mins[j];
+			loadbmodel->leafBounds[( j + 3 ) * loadbmodel->leafBoundsStride + i] = leaf->maxs[j];
+		}
+	}
 }
 
 /*
@@ -155,6 +155,8 @@ typedef struct mbrushmodel_s {
 
 	unsigned int numleafs;              // number of visible leafs, not counting 0
 	mleaf_t         *leafs;
+	float           *leafBounds;        // mins and maxs of leafs split by axis, for SIMD culling
+	unsigned int leafBoundsStride;      // numleafs rounded up to a multiple of 4
 
 	unsigned int numnodes;
 	mnode_t         *nodes;
@@ -22,7 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "../cgame/ref.h"
 
-#define REF_API_VERSION 24
+#define REF_API_VERSION 27
 
 //
 // these are the functions exported by the refresh module
@@ -61,6 +61,8 @@ typedef struct {
 	uint64_t ( *Sys_Microseconds )( void );
 	void ( *Sys_Sleep )( unsigned int milliseconds );
 
+	unsigned int ( *Com_CPUFeatures )( void );
+
 	void *( *Com_LoadSysLibrary )( const char *name, dllfunc_t * funcs );
 	void ( *Com_UnloadLibrary )( void **lib );
 	void *( *Com_LibraryProcAddress )( void *lib, const char *name );
@@ -82,6 +84,8 @@ typedef struct {
 	bool ( *FS_MoveFile )( const char *src, const char *dst );
 	bool ( *FS_IsUrl )( const char *url );
 	time_t ( *FS_FileMTime )( const char *filename );
+	const char *( *FS_PakNameForFile )( const char *filename );
+	unsigned ( *FS_ChecksumBaseFile )( const char *filename, bool ignorePakChecksum );
 	bool ( *FS_RemoveDirectory )( const char *dirname );
 	const char * ( *FS_GameDirectory )( void );
 	const char * ( *FS_WriteDirectory )( void );
@@ -121,6 +125,12 @@ typedef struct {
 	int ( *BufPipe_ReadCmds )( struct qbufPipe_s *queue, unsigned( **cmdHandlers )( const void * ) );
 	void ( *BufPipe_Wait )( struct qbufPipe_s *queue, int ( *read )( struct qbufPipe_s *, unsigned( ** )( const void * ), bool ),
 							unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec );
+
+	// job system
+	int ( *Jobs_NumThreads )( void );
+	void ( *Jobs_Add )( qjobcounter_t *counter, qjobcounter_t *dependency, qjobfunc_t func, void *arg );
+	void ( *Jobs_ParallelFor )( qjobcounter_t *counter, unsigned items, unsigned grain, qjobrangefunc_t func, void *arg );
+	void ( *Jobs_Wait )( qjobcounter_t *counter );
 } ref_import_t;
 
 typedef struct {
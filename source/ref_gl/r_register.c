@@ -127,6 +127,8 @@ cvar_t *r_texturefilter;
 cvar_t *r_texturecompression;
 cvar_t *r_picmip;
 cvar_t *r_skymip;
+cvar_t *r_texturecache;
+cvar_t *r_skm_simd;
 cvar_t *r_nobind;
 cvar_t *r_polyblend;
 cvar_t *r_lockpvs;
@@ -1084,6 +1086,7 @@ static void R_Register( const char *screenshotsPrefix ) {
 	r_novis = ri.Cvar_Get( "r_novis", "0", 0 );
 	r_nocull = ri.Cvar_Get( "r_nocull", "0", 0 );
 	r_lerpmodels = ri.Cvar_Get( "r_lerpmodels", "1", 0 );
+	r_skm_simd = ri.Cvar_Get( "r_skm_simd", "1", CVAR_ARCHIVE );
 	r_speeds = ri.Cvar_Get( "r_speeds", "0", 0 );
 	r_drawelements = ri.Cvar_Get( "r_drawelements", "1", 0 );
 	r_showtris = ri.Cvar_Get( "r_showtris", "0", CVAR_CHEAT );
@@ -1093,6 +1096,7 @@ static void R_Register( const char *screenshotsPrefix ) {
 	r_nobind = ri.Cvar_Get( "r_nobind", "0", 0 );
 	r_picmip = ri.Cvar_Get( "r_picmip", "0", CVAR_ARCHIVE | CVAR_LATCH_VIDEO );
 	r_skymip = ri.Cvar_Get( "r_skymip", "0", CVAR_ARCHIVE | CVAR_LATCH_VIDEO );
+	r_texturecache = ri.Cvar_Get( "r_texturecache", "1", CVAR_ARCHIVE );
 	r_polyblend = ri.Cvar_Get( "r_polyblend", "1", 0 );
 
 	r_sRGB = ri.Cvar_Get( "r_sRGB", "1", CVAR_ARCHIVE | CVAR_LATCH_VIDEO );
@@ -1232,6 +1236,13 @@ static void R_Register( const char *screenshotsPrefix ) {
 	ri.Cmd_AddCommand( "gfxinfo", R_GfxInfo_f );
 	ri.Cmd_AddCommand( "glslprogramlist", RP_ProgramList_f );
 	ri.Cmd_AddCommand( "cinlist", R_CinList_f );
+	ri.Cmd_AddCommand( "buildtexturecache", R_BuildTextureCache_f );
+#ifndef PUBLIC_BUILD
+	ri.Cmd_AddCommand( "skmkerneltest", R_SkeletalKernelsTest_f );
+	ri.Cmd_AddCommand( "worldcullbench", R_WorldCullBench_f );
+	ri.Cmd_AddCommand( "drawsortbench", R_DrawSortBench_f );
+	ri.Cmd_AddCommand( "imagebench", R_ImageBench_f );
+#endif
 
 	ri.Cmd_SetCompletionFunc( "shaderdump", R_ShaderDumpCompletion_f );
 }
@@ -1620,6 +1631,13 @@ void R_Shutdown( bool verbose ) {
 	ri.Cmd_RemoveCommand( "shaderlist" );
 	ri.Cmd_RemoveCommand( "glslprogramlist" );
 	ri.Cmd_RemoveCommand( "cinlist" );
+	ri.Cmd_RemoveCommand( "buildtexturecache" );
+#ifndef PUBLIC_BUILD
+	ri.Cmd_RemoveCommand( "skmkerneltest" );
+	ri.Cmd_RemoveCommand( "worldcullbench" );
+	ri.Cmd_RemoveCommand( "drawsortbench" );
+	ri.Cmd_RemoveCommand( "imagebench" );
+#endif
 
 	// free shaders, models, etc.
 
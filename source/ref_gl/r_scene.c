@@ -483,6 +483,12 @@ void R_RenderScene( const refdef_t *fd ) {
 
 	R_SetupPVS( fd );
 
+#ifndef PUBLIC_BUILD
+	if( !( fd->rdflags & RDF_NOWORLDMODEL ) ) {
+		R_RecordWorldCullView();
+	}
+#endif
+
 	R_RenderView( fd );
 
 	if( !(fd->rdflags & RDF_NOWORLDMODEL) ) {
@@ -491,6 +497,10 @@ void R_RenderScene( const refdef_t *fd ) {
 		R_RenderDebugLightVolumes();
 
 		R_RenderDebugBounds();
+
+#ifndef PUBLIC_BUILD
+		R_RunWorldCullBench();
+#endif
 	}
 
 	R_Begin2D( false );
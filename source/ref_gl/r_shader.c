@@ -27,6 +27,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define SHADERS_HASH_SIZE 128
 #define SHADERCACHE_HASH_SIZE 128
 
+#define SHADERCACHE_FILE_NAME "cache/shaders.cache.bin"
+#define SHADERCACHE_FILE_MAGIC "QFSC"
+#define SHADERCACHE_FILE_VERSION 1
+
 typedef struct {
 	const char *keyword;
 	void ( *func )( shader_t *shader, shaderpass_t *pass, const char **ptr );
@@ -40,10 +44,36 @@ typedef struct shadercache_s {
 	struct shadercache_s *hash_next;
 } shadercache_t;
 
+// binary shader cache file layout, all offsets are relative to the start of
+// the respective block:
+// header
+// shadercachefileentry_t entries[numShaders]
+// file names, \0-terminated, in the order they were loaded
+// shader names, \0-terminated
+// compressed text of all files, \0-terminated
+typedef struct {
+	char magic[4];
+	unsigned version;
+	unsigned key;
+	unsigned numFiles;
+	unsigned fileNamesSize;
+	unsigned numShaders;
+	unsigned shaderNamesSize;
+	unsigned textSize;
+} shadercachefileheader_t;
+
+typedef struct {
+	unsigned name;
+	unsigned file;
+	unsigned offset;
+} shadercachefileentry_t;
+
 static shader_t r_shaders[MAX_SHADERS];
 
 static shader_t		  r_shaders_hash_headnode[SHADERS_HASH_SIZE], *r_free_shaders;
 static shadercache_t *shadercache_hash[SHADERCACHE_HASH_SIZE];
+static void *r_shaderCacheFile;             // shaders.cache.bin contents, when loaded from disk
+static shadercache_t *r_shaderCacheFileEntries;
 
 static deformv_t	r_currentDeforms[MAX_SHADER_DEFORMVS];
 static shaderpass_t r_currentPasses[MAX_SHADER_PASSES];
@@ -71,7 +101,7 @@ static char * r_shortShaderQMark;
 
 static bool Shader_Parsetok(
 	shader_t *shader, shaderpass_t *pass, const shaderkey_t *keys, const char *token, const char **ptr );
-static void			Shader_MakeCache( const char *filename );
+static char *		Shader_MakeCache( const char *filename, size_t *bufSize );
 static unsigned int Shader_GetCache( const char *name, shadercache_t **cache );
 #define R_FreePassCinematics( pass )      \
 	if( ( pass )->cin ) {                 \
@@ -1783,7 +1813,12 @@ void R_PrintShaderCache( const char *name )
 	cache->buffer[ptr - cache->buffer] = backup;
 }
 
-static void Shader_MakeCache( const char *filename )
+/*
+ * Shader_MakeCache
+ *
+ * Returns the compressed script text, which the cache entries point into.
+ */
+static char *Shader_MakeCache( const char *filename, size_t *bufSize )
 {
 	int			   size;
 	unsigned int   key;
@@ -1795,6 +1830,9 @@ static void Shader_MakeCache( const char *filename )
 	uint8_t *	   cacheMemBuf;
 	size_t		   cacheMemSize;
 
+	buf = NULL;
+	*bufSize = 0;
+
 	pathNameSize = strlen( "scripts/" ) + strlen( filename ) + 1;
 	pathName = R_Malloc( pathNameSize );
 	assert( pathName );
@@ -1831,9 +1869,12 @@ static void Shader_MakeCache( const char *filename )
 
 	if( !cacheMemSize ) {
 		R_Free( buf );
+		buf = NULL;
 		goto done;
 	}
 
+	*bufSize = size + 1;
+
 	cacheMemBuf = R_Malloc( cacheMemSize );
 	memset( cacheMemBuf, 0, cacheMemSize );
 	for( ptr = buf; ptr; ) {
@@ -1872,6 +1913,8 @@ done:
 		R_FreeFile( temp );
 	}
 	R_Free( pathName );
+
+	return buf;
 }
 
 /*
@@ -1898,9 +1941,12 @@ static unsigned int Shader_GetCache( const char *name, shadercache_t **cache )
 }
 
 /*
- * R_InitShaderCache
+ * R_ListShaderFiles
+ *
+ * Returns the number of shader scripts, names are stored in a single buffer,
+ * separated by \0's.
  */
-static void R_InitShaderCache( void )
+static int R_ListShaderFiles( char **pFileNames, size_t *pFileNamesSize )
 {
 	int			d;
 	int			i, j, k, numfiles;
@@ -1908,20 +1954,14 @@ static void R_InitShaderCache( void )
 	const char *fileptr;
 	char		shaderPaths[1024];
 	const char *dirs[3] = { "<scripts", ">scripts" };
-
-	r_shaderTemplateBuf = NULL;
-
-	memset( shadercache_hash, 0, sizeof( shadercache_t * ) * SHADERCACHE_HASH_SIZE );
-
-	Com_Printf( "Initializing Shaders:\n" );
+	char *		fileNames = NULL;
+	size_t		fileNamesSize = 0, len;
 
 	numfiles_total = 0;
 	for( d = 0; d < 2; d++ ) {
 		// enumerate shaders
 		numfiles = ri.FS_GetFileList( dirs[d], ".shader", NULL, 0, 0, 0 );
-		numfiles_total += numfiles;
 
-		// now load them all
 		for( i = 0; i < numfiles; i += k ) {
 			if( ( k = ri.FS_GetFileList( dirs[d], ".shader", shaderPaths, sizeof( shaderPaths ), i, numfiles ) ) ==
 				0 ) {
@@ -1931,9 +1971,13 @@ static void R_InitShaderCache( void )
 
 			fileptr = shaderPaths;
 			for( j = 0; j < k; j++ ) {
-				Shader_MakeCache( fileptr );
+				len = strlen( fileptr ) + 1;
+				fileNames = fileNames ? R_Realloc( fileNames, fileNamesSize + len ) : R_Malloc( fileNamesSize + len );
+				memcpy( fileNames + fileNamesSize, fileptr, len );
+				fileNamesSize += len;
+				numfiles_total++;
 
-				fileptr += strlen( fileptr ) + 1;
+				fileptr += len;
 				if( !*fileptr ) {
 					break;
 				}
@@ -1941,10 +1985,277 @@ static void R_InitShaderCache( void )
 		}
 	}
 
+	*pFileNames = fileNames;
+	*pFileNamesSize = fileNamesSize;
+	return numfiles_total;
+}
+
+/*
+ * R_ShaderCacheKey
+ *
+ * Hashes checksums of the pk3's shader scripts come from, or modification
+ * times of loose files, so the binary cache is rebuilt when any of them changes.
+ */
+static unsigned R_ShaderCacheKey( const char *fileNames, int numFiles )
+{
+	int			i;
+	const char *name;
+	char		path[1024];
+	uint64_t *	keys;
+	unsigned	key;
+
+	keys = R_Malloc( sizeof( *keys ) * ( numFiles + 1 ) );
+
+	keys[0] = SHADERCACHE_FILE_VERSION;
+	for( i = 0, name = fileNames; i < numFiles; i++, name += strlen( name ) + 1 ) {
+		const char *pakname;
+
+		Q_snprintfz( path, sizeof( path ), "scripts/%s", name );
+
+		// FS_PakNameForFile only searches paks, a loose file overriding the
+		// pak copy is only told apart by the time stamp of the file the
+		// parser actually reads
+		pakname = ri.FS_PakNameForFile( path );
+		keys[i + 1] = ( (uint64_t)ri.FS_FileMTime( path ) << 32 ) | ( pakname ? ri.FS_ChecksumBaseFile( pakname, false ) : 1 );
+	}
+
+	key = COM_SuperFastHash( (const uint8_t *)keys, sizeof( *keys ) * ( numFiles + 1 ) );
+
+	R_Free( keys );
+
+	return key;
+}
+
+/*
+ * R_LoadShaderCacheFile
+ *
+ * Fills the shader cache from the binary cache file. Returns false if the file
+ * is missing or doesn't match the current set of shader scripts.
+ */
+static bool R_LoadShaderCacheFile( unsigned key, const char *fileNames, size_t fileNamesSize, int numFiles )
+{
+	int								i;
+	int								size;
+	uint8_t *						data;
+	const char **					fileNamePtrs;
+	shadercachefileheader_t			header;
+	const shadercachefileentry_t *	entries;
+	char *							shaderNames, *text;
+	size_t							expectedSize;
+	const char *					fileNamesData, *name;
+
+	size = R_LoadCacheFile( SHADERCACHE_FILE_NAME, (void **)&data );
+	if( !data ) {
+		return false;
+	}
+
+	if( size < (int)sizeof( header ) ) {
+		goto fail;
+	}
+
+	memcpy( &header, data, sizeof( header ) );
+	if( memcmp( header.magic, SHADERCACHE_FILE_MAGIC, sizeof( header.magic ) ) ||
+		header.version != SHADERCACHE_FILE_VERSION || header.key != key ) {
+		goto fail;
+	}
+	if( header.numFiles != (unsigned)numFiles || header.fileNamesSize != fileNamesSize ) {
+		goto fail;
+	}
+
+	expectedSize = sizeof( header ) + header.fileNamesSize + sizeof( shadercachefileentry_t ) * header.numShaders +
+				   header.shaderNamesSize + header.textSize;
+	if( (size_t)size != expectedSize || !header.textSize || !header.shaderNamesSize ) {
+		goto fail;
+	}
+
+	entries = (const shadercachefileentry_t *)( data + sizeof( header ) );
+	fileNamesData = (const char *)( entries + header.numShaders );
+	if( memcmp( fileNamesData, fileNames, fileNamesSize ) ) {
+		goto fail;
+	}
+
+	shaderNames = (char *)fileNamesData + header.fileNamesSize;
+	text = shaderNames + header.shaderNamesSize;
+	if( shaderNames[header.shaderNamesSize - 1] || text[header.textSize - 1] ) {
+		goto fail;
+	}
+
+	fileNamePtrs = R_Malloc( sizeof( *fileNamePtrs ) * numFiles );
+	for( i = 0, name = fileNamesData; i < numFiles; i++, name += strlen( name ) + 1 ) {
+		fileNamePtrs[i] = name;
+	}
+
+	r_shaderCacheFileEntries = R_Malloc( sizeof( shadercache_t ) * header.numShaders );
+	for( i = 0; i < (int)header.numShaders; i++ ) {
+		const shadercachefileentry_t *e = &entries[i];
+		shadercache_t *cache = &r_shaderCacheFileEntries[i];
+		unsigned int hashKey;
+
+		if( e->name >= header.shaderNamesSize || e->file >= header.numFiles || e->offset >= header.textSize ) {
+			R_Free( fileNamePtrs );
+			R_Free( r_shaderCacheFileEntries );
+			r_shaderCacheFileEntries = NULL;
+			memset( shadercache_hash, 0, sizeof( shadercache_hash ) );
+			goto fail;
+		}
+
+		cache->name = shaderNames + e->name;
+		cache->filename = (char *)fileNamePtrs[e->file];
+		cache->buffer = text;
+		cache->offset = e->offset;
+
+		hashKey = COM_SuperFastHash( (const uint8_t *)cache->name, strlen( cache->name ) ) % SHADERCACHE_HASH_SIZE;
+		cache->hash_next = shadercache_hash[hashKey];
+		shadercache_hash[hashKey] = cache;
+	}
+
+	R_Free( fileNamePtrs );
+
+	r_shaderCacheFile = data;
+	return true;
+
+fail:
+	R_FreeFile( data );
+	return false;
+}
+
+/*
+ * R_WriteShaderCacheFile
+ */
+static void R_WriteShaderCacheFile( unsigned key, const char *fileNames, size_t fileNamesSize, int numFiles,
+	char **fileBufs, const size_t *fileBufSizes )
+{
+	int						i, j, file;
+	int						handle;
+	size_t					*textOffsets;
+	shadercachefileheader_t header;
+	shadercachefileentry_t	entry;
+	shadercache_t *			cache;
+
+	if( ri.FS_FOpenFile( SHADERCACHE_FILE_NAME, &handle, FS_WRITE | FS_CACHE ) == -1 ) {
+		Com_Printf( S_COLOR_YELLOW "Could not open %s for writing.\n", SHADERCACHE_FILE_NAME );
+		return;
+	}
+
+	textOffsets = R_Malloc( sizeof( *textOffsets ) * ( numFiles + 1 ) );
+
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, SHADERCACHE_FILE_MAGIC, sizeof( header.magic ) );
+	header.version = SHADERCACHE_FILE_VERSION;
+	header.key = key;
+	header.numFiles = numFiles;
+	header.fileNamesSize = fileNamesSize;
+	for( i = 0; i < numFiles; i++ ) {
+		textOffsets[i] = header.textSize;
+		header.textSize += fileBufSizes[i];
+	}
+	for( i = 0; i < SHADERCACHE_HASH_SIZE; i++ ) {
+		for( cache = shadercache_hash[i]; cache; cache = cache->hash_next ) {
+			header.numShaders++;
+			header.shaderNamesSize += strlen( cache->name ) + 1;
+		}
+	}
+
+	ri.FS_Write( &header, sizeof( header ), handle );
+
+	// entries, then names in the same order
+	entry.name = 0;
+	for( i = 0; i < SHADERCACHE_HASH_SIZE; i++ ) {
+		for( cache = shadercache_hash[i]; cache; cache = cache->hash_next ) {
+			for( file = 0; file < numFiles; file++ ) {
+				if( fileBufs[file] == cache->buffer ) {
+					break;
+				}
+			}
+			assert( file < numFiles );
+
+			entry.file = file;
+			entry.offset = textOffsets[file] + cache->offset;
+			ri.FS_Write( &entry, sizeof( entry ), handle );
+
+			entry.name += strlen( cache->name ) + 1;
+		}
+	}
+
+	ri.FS_Write( fileNames, fileNamesSize, handle );
+
+	for( i = 0; i < SHADERCACHE_HASH_SIZE; i++ ) {
+		for( cache = shadercache_hash[i]; cache; cache = cache->hash_next ) {
+			ri.FS_Write( cache->name, strlen( cache->name ) + 1, handle );
+		}
+	}
+
+	for( j = 0; j < numFiles; j++ ) {
+		if( fileBufs[j] ) {
+			ri.FS_Write( fileBufs[j], fileBufSizes[j], handle );
+		}
+	}
+
+	ri.FS_FCloseFile( handle );
+
+	R_Free( textOffsets );
+}
+
+/*
+ * R_InitShaderCache
+ */
+static void R_InitShaderCache( void )
+{
+	int		 i, numfiles_total;
+	char *	 fileNames;
+	size_t	 fileNamesSize;
+	char **	 fileBufs;
+	size_t * fileBufSizes;
+	unsigned key;
+	bool	 cached;
+	int		 numShaders;
+	uint64_t startTime;
+	const char *fileptr;
+	shadercache_t *cache;
+
+	r_shaderTemplateBuf = NULL;
+
+	memset( shadercache_hash, 0, sizeof( shadercache_t * ) * SHADERCACHE_HASH_SIZE );
+
+	Com_Printf( "Initializing Shaders:\n" );
+
+	startTime = ri.Sys_Microseconds();
+
+	numfiles_total = R_ListShaderFiles( &fileNames, &fileNamesSize );
 	if( !numfiles_total ) {
 		ri.Com_Error( ERR_DROP, "Could not find any shaders!" );
 	}
 
+	key = R_ShaderCacheKey( fileNames, numfiles_total );
+
+	cached = R_LoadShaderCacheFile( key, fileNames, fileNamesSize, numfiles_total );
+	if( !cached ) {
+		// parse the scripts, then store the results for the next time
+		fileBufs = R_Malloc( sizeof( *fileBufs ) * numfiles_total );
+		fileBufSizes = R_Malloc( sizeof( *fileBufSizes ) * numfiles_total );
+
+		for( i = 0, fileptr = fileNames; i < numfiles_total; i++, fileptr += strlen( fileptr ) + 1 ) {
+			fileBufs[i] = Shader_MakeCache( fileptr, &fileBufSizes[i] );
+		}
+
+		R_WriteShaderCacheFile( key, fileNames, fileNamesSize, numfiles_total, fileBufs, fileBufSizes );
+
+		R_Free( fileBufs );
+		R_Free( fileBufSizes );
+	}
+
+	R_Free( fileNames );
+
+	numShaders = 0;
+	for( i = 0; i < SHADERCACHE_HASH_SIZE; i++ ) {
+		for( cache = shadercache_hash[i]; cache; cache = cache->hash_next ) {
+			numShaders++;
+		}
+	}
+
+	Com_Printf( "%i shaders from %i files indexed in %.1f ms%s\n", numShaders, numfiles_total,
+		( ri.Sys_Microseconds() - startTime ) / 1000.0, cached ? " (cached)" : "" );
+
 	Com_Printf( "--------------------------------------\n" );
 }
 
@@ -1958,6 +2269,14 @@ static void R_ShutdownShaderCache( void )
 	r_shaderTemplateBuf = NULL;
 
 	memset( shadercache_hash, 0, sizeof( shadercache_hash ) );
+
+	if( r_shaderCacheFile ) {
+		R_Free( r_shaderCacheFileEntries );
+		r_shaderCacheFileEntries = NULL;
+
+		R_FreeFile( r_shaderCacheFile );
+		r_shaderCacheFile = NULL;
+	}
 }
 
 /*
@@ -908,6 +908,13 @@ static float R_SkeletalModelLerpBBox( const entity_t *e, const model_t *mod, vec
 
 //=======================================================================
 
+// mesh transformed on the CPU by the caching jobs
+typedef struct {
+	vec4_t *xyzArray;
+	vec4_t *normalsArray;
+	vec4_t *sVectorsArray;      // NULL if the shader of the mesh doesn't need them
+} skmmeshcache_t;
+
 typedef struct skmcacheentry_s {
 	bool hwTransform;
 	int entNum;
@@ -916,15 +923,37 @@ typedef struct skmcacheentry_s {
 	const bonepose_t *boneposes, *oldboneposes;
 	const mskmodel_t *skmodel;
 	uint8_t *data;
+	skmmeshcache_t *meshes;     // NULL unless transformed on the CPU
 } skmcacheentry_t;
 
+// (entity, mesh) pair to be transformed on the CPU
+typedef struct {
+	skmcacheentry_t *cache;
+	unsigned meshNum;
+} skmmeshjob_t;
+
 static skmcacheentry_t r_skmcachekeys[MAX_REF_ENTITIES];      // entities linked to cache entries
 
+// entities queued for caching since the last R_ScheduleSkeletalCacheJobs call
+static skmcacheentry_t *r_skmbatch[MAX_REF_ENTITIES];
+static unsigned r_skmbatchsize;
+static unsigned r_skmbatchmeshes;
+
+static const struct skmkernels_s *r_skmKernels;
+
+static void R_SkeletalSelectKernels( void );
+
 /*
 * R_ClearSkeletalCache
 */
 void R_ClearSkeletalCache( void ) {
 	memset( r_skmcachekeys, 0, sizeof( r_skmcachekeys ) );
+	r_skmbatchsize = 0;
+	r_skmbatchmeshes = 0;
+
+	if( !r_skmKernels || r_skm_simd->modified ) {
+		R_SkeletalSelectKernels();
+	}
 }
 
 /*
@@ -969,6 +998,7 @@ static skmcacheentry_t *R_AllocSkeletalDataCache( int entNum, const mskmodel_t *
 	cache->boneposes = cache->oldboneposes = NULL;
 	cache->framenum = cache->oldframenum = 0;
 	cache->hwTransform = hwTransform;
+	cache->meshes = NULL;
 
 	return cache;
 }
@@ -982,6 +1012,17 @@ static skmcacheentry_t *R_AllocSkeletalDataCache( int entNum, const mskmodel_t *
 # pragma fp_contract(on)        // this line is needed on Itanium processors
 #endif
 
+/*
+* R_SkeletalLerpBonePoses
+*/
+static void R_SkeletalLerpBonePoses( unsigned int numbones, const bonepose_t *oldbp, const bonepose_t *bp, float frontlerp, bonepose_t *out ) {
+	unsigned int i;
+
+	for( i = 0; i < numbones; i++ ) {
+		DualQuat_Lerp( oldbp[i].dualquat, bp[i].dualquat, frontlerp, out[i].dualquat );
+	}
+}
+
 /*
 * R_SkeletalBlendPoses
 */
@@ -1075,27 +1116,551 @@ static void R_SkeletalTransformNormalsAndSVecs( int numverts, const unsigned int
 # pragma fp_contract(off)   // this line is needed on Itanium processors
 #endif
 
+//=======================================================================
+
+// SIMD versions of the kernels above. Bone matrices and blends are not
+// guaranteed to be 16-byte aligned, so all loads and stores are unaligned.
+// The w component of blended matrices is left undefined, just like in the
+// scalar code, and is never used for transforms.
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define R_SKM_SSE2
+#include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#define R_SKM_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef R_SKM_SSE2
+
+static inline __m128 R_SkeletalDot4_SSE2( __m128 a, __m128 b ) {
+	__m128 m = _mm_mul_ps( a, b );
+	m = _mm_add_ps( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	return _mm_add_ps( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+}
+
+static inline __m128 R_SkeletalTransformVec3_SSE2( const float *pose, const float *v ) {
+	__m128 in = _mm_loadu_ps( v );
+	__m128 r;
+
+	r = _mm_mul_ps( _mm_shuffle_ps( in, in, 0x00 ), _mm_loadu_ps( pose ) );
+	r = _mm_add_ps( r, _mm_mul_ps( _mm_shuffle_ps( in, in, 0x55 ), _mm_loadu_ps( pose + 4 ) ) );
+	r = _mm_add_ps( r, _mm_mul_ps( _mm_shuffle_ps( in, in, 0xaa ), _mm_loadu_ps( pose + 8 ) ) );
+	return r;
+}
+
 /*
-* R_CacheBoneTransformsJob
+* R_SkeletalLerpBonePoses_SSE2
 */
-static void R_CacheBoneTransformsJob( unsigned first, unsigned items, jobarg_t *ja ) {
+static void R_SkeletalLerpBonePoses_SSE2( unsigned int numbones, const bonepose_t *oldbp, const bonepose_t *bp, float frontlerp, bonepose_t *out ) {
+	unsigned int i;
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signmask = _mm_set1_ps( -0.0f );
+	const __m128 t = _mm_set1_ps( frontlerp );
+	const __m128 it = _mm_set1_ps( 1.0f - frontlerp );
+
+	for( i = 0; i < numbones; i++ ) {
+		const float *dq1 = oldbp[i].dualquat, *dq2 = bp[i].dualquat;
+		__m128 r1 = _mm_loadu_ps( dq1 ), d1 = _mm_loadu_ps( dq1 + 4 );
+		__m128 r2 = _mm_loadu_ps( dq2 ), d2 = _mm_loadu_ps( dq2 + 4 );
+		__m128 k, r, d, len;
+
+		// go the short way around if the rotations are in opposite hemispheres
+		k = _mm_cmplt_ps( R_SkeletalDot4_SSE2( r1, r2 ), zero );
+		k = _mm_xor_ps( t, _mm_and_ps( k, signmask ) );
+
+		r = _mm_add_ps( _mm_mul_ps( r1, it ), _mm_mul_ps( r2, k ) );
+		d = _mm_add_ps( _mm_mul_ps( d1, it ), _mm_mul_ps( d2, k ) );
+
+		len = R_SkeletalDot4_SSE2( r, r );
+		if( _mm_cvtss_f32( len ) != 0 ) {
+			r = _mm_div_ps( r, _mm_sqrt_ps( len ) );
+		}
+
+		_mm_storeu_ps( out[i].dualquat, r );
+		_mm_storeu_ps( out[i].dualquat + 4, d );
+	}
+}
+
+/*
+* R_SkeletalBlendPoses_SSE2
+*/
+static void R_SkeletalBlendPoses_SSE2( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose ) {
+	unsigned int i, k;
+	const mskblend_t *blend;
+
+	for( i = 0, blend = blends; i < numblends; i++, blend++ ) {
+		float *pose = relbonepose[numbones + i];
+		const float *b = relbonepose[blend->indices[0]];
+		__m128 f = _mm_set1_ps( blend->weights[0] * ( 1.0 / 255.0 ) );
+		__m128 c0, c1, c2, c3;
+
+		c0 = _mm_mul_ps( f, _mm_loadu_ps( b ) );
+		c1 = _mm_mul_ps( f, _mm_loadu_ps( b + 4 ) );
+		c2 = _mm_mul_ps( f, _mm_loadu_ps( b + 8 ) );
+		c3 = _mm_mul_ps( f, _mm_loadu_ps( b + 12 ) );
+
+		for( k = 1; k < SKM_MAX_WEIGHTS && blend->weights[k]; k++ ) {
+			b = relbonepose[blend->indices[k]];
+			f = _mm_set1_ps( blend->weights[k] * ( 1.0 / 255.0 ) );
+
+			c0 = _mm_add_ps( c0, _mm_mul_ps( f, _mm_loadu_ps( b ) ) );
+			c1 = _mm_add_ps( c1, _mm_mul_ps( f, _mm_loadu_ps( b + 4 ) ) );
+			c2 = _mm_add_ps( c2, _mm_mul_ps( f, _mm_loadu_ps( b + 8 ) ) );
+			c3 = _mm_add_ps( c3, _mm_mul_ps( f, _mm_loadu_ps( b + 12 ) ) );
+		}
+
+		_mm_storeu_ps( pose, c0 );
+		_mm_storeu_ps( pose + 4, c1 );
+		_mm_storeu_ps( pose + 8, c2 );
+		_mm_storeu_ps( pose + 12, c3 );
+	}
+}
+
+/*
+* R_SkeletalTransformVerts_SSE2
+*/
+static void R_SkeletalTransformVerts_SSE2( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const __m128 xyzmask = _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ) );
+	const __m128 wone = _mm_set_ps( 1, 0, 0, 0 );
+	const float *pose;
+	__m128 r;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
+
+		r = _mm_add_ps( R_SkeletalTransformVec3_SSE2( pose, v ), _mm_loadu_ps( pose + 12 ) );
+		_mm_storeu_ps( ov, _mm_or_ps( _mm_and_ps( r, xyzmask ), wone ) );
+	}
+}
+
+/*
+* R_SkeletalTransformNormals_SSE2
+*/
+static void R_SkeletalTransformNormals_SSE2( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const __m128 xyzmask = _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ) );
+	const float *pose;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
+
+		_mm_storeu_ps( ov, _mm_and_ps( R_SkeletalTransformVec3_SSE2( pose, v ), xyzmask ) );
+	}
+}
+
+/*
+* R_SkeletalTransformNormalsAndSVecs_SSE2
+*/
+static void R_SkeletalTransformNormalsAndSVecs_SSE2( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv ) {
+	const __m128 xyzmask = _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ) );
+	const float *pose;
+	__m128 r;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, sv += 4, osv += 4, blends++ ) {
+		pose = relbonepose[*blends];
+
+		_mm_storeu_ps( ov, _mm_and_ps( R_SkeletalTransformVec3_SSE2( pose, v ), xyzmask ) );
+
+		// keep the handedness of the tangent space in w
+		r = _mm_and_ps( R_SkeletalTransformVec3_SSE2( pose, sv ), xyzmask );
+		_mm_storeu_ps( osv, _mm_or_ps( r, _mm_andnot_ps( xyzmask, _mm_loadu_ps( sv ) ) ) );
+	}
+}
+
+#endif // R_SKM_SSE2
+
+#ifdef R_SKM_NEON
+
+static inline float R_SkeletalDot4_NEON( float32x4_t a, float32x4_t b ) {
+	float32x4_t m = vmulq_f32( a, b );
+	float32x2_t s = vadd_f32( vget_low_f32( m ), vget_high_f32( m ) );
+	return vget_lane_f32( vpadd_f32( s, s ), 0 );
+}
+
+static inline float32x4_t R_SkeletalTransformVec3_NEON( const float *pose, const float *v ) {
+	float32x4_t r;
+
+	r = vmulq_n_f32( vld1q_f32( pose ), v[0] );
+	r = vmlaq_n_f32( r, vld1q_f32( pose + 4 ), v[1] );
+	r = vmlaq_n_f32( r, vld1q_f32( pose + 8 ), v[2] );
+	return r;
+}
+
+/*
+* R_SkeletalLerpBonePoses_NEON
+*/
+static void R_SkeletalLerpBonePoses_NEON( unsigned int numbones, const bonepose_t *oldbp, const bonepose_t *bp, float frontlerp, bonepose_t *out ) {
+	unsigned int i;
+	const float it = 1.0f - frontlerp;
+
+	for( i = 0; i < numbones; i++ ) {
+		const float *dq1 = oldbp[i].dualquat, *dq2 = bp[i].dualquat;
+		float32x4_t r1 = vld1q_f32( dq1 ), d1 = vld1q_f32( dq1 + 4 );
+		float32x4_t r2 = vld1q_f32( dq2 ), d2 = vld1q_f32( dq2 + 4 );
+		float32x4_t r, d;
+		float k, len;
+
+		// go the short way around if the rotations are in opposite hemispheres
+		k = R_SkeletalDot4_NEON( r1, r2 ) < 0 ? -frontlerp : frontlerp;
+
+		r = vmlaq_n_f32( vmulq_n_f32( r1, it ), r2, k );
+		d = vmlaq_n_f32( vmulq_n_f32( d1, it ), d2, k );
+
+		len = R_SkeletalDot4_NEON( r, r );
+		if( len != 0 ) {
+			r = vmulq_n_f32( r, 1.0f / sqrtf( len ) );
+		}
+
+		vst1q_f32( out[i].dualquat, r );
+		vst1q_f32( out[i].dualquat + 4, d );
+	}
+}
+
+/*
+* R_SkeletalBlendPoses_NEON
+*/
+static void R_SkeletalBlendPoses_NEON( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose ) {
+	unsigned int i, k;
+	const mskblend_t *blend;
+
+	for( i = 0, blend = blends; i < numblends; i++, blend++ ) {
+		float *pose = relbonepose[numbones + i];
+		const float *b = relbonepose[blend->indices[0]];
+		float f = blend->weights[0] * ( 1.0 / 255.0 );
+		float32x4_t c0, c1, c2, c3;
+
+		c0 = vmulq_n_f32( vld1q_f32( b ), f );
+		c1 = vmulq_n_f32( vld1q_f32( b + 4 ), f );
+		c2 = vmulq_n_f32( vld1q_f32( b + 8 ), f );
+		c3 = vmulq_n_f32( vld1q_f32( b + 12 ), f );
+
+		for( k = 1; k < SKM_MAX_WEIGHTS && blend->weights[k]; k++ ) {
+			b = relbonepose[blend->indices[k]];
+			f = blend->weights[k] * ( 1.0 / 255.0 );
+
+			c0 = vmlaq_n_f32( c0, vld1q_f32( b ), f );
+			c1 = vmlaq_n_f32( c1, vld1q_f32( b + 4 ), f );
+			c2 = vmlaq_n_f32( c2, vld1q_f32( b + 8 ), f );
+			c3 = vmlaq_n_f32( c3, vld1q_f32( b + 12 ), f );
+		}
+
+		vst1q_f32( pose, c0 );
+		vst1q_f32( pose + 4, c1 );
+		vst1q_f32( pose + 8, c2 );
+		vst1q_f32( pose + 12, c3 );
+	}
+}
+
+/*
+* R_SkeletalTransformVerts_NEON
+*/
+static void R_SkeletalTransformVerts_NEON( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const float *pose;
+	float32x4_t r;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
+
+		r = vaddq_f32( R_SkeletalTransformVec3_NEON( pose, v ), vld1q_f32( pose + 12 ) );
+		vst1q_f32( ov, vsetq_lane_f32( 1.0f, r, 3 ) );
+	}
+}
+
+/*
+* R_SkeletalTransformNormals_NEON
+*/
+static void R_SkeletalTransformNormals_NEON( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const float *pose;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
+
+		vst1q_f32( ov, vsetq_lane_f32( 0.0f, R_SkeletalTransformVec3_NEON( pose, v ), 3 ) );
+	}
+}
+
+/*
+* R_SkeletalTransformNormalsAndSVecs_NEON
+*/
+static void R_SkeletalTransformNormalsAndSVecs_NEON( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv ) {
+	const float *pose;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, sv += 4, osv += 4, blends++ ) {
+		pose = relbonepose[*blends];
+
+		vst1q_f32( ov, vsetq_lane_f32( 0.0f, R_SkeletalTransformVec3_NEON( pose, v ), 3 ) );
+		vst1q_f32( osv, vsetq_lane_f32( sv[3], R_SkeletalTransformVec3_NEON( pose, sv ), 3 ) );
+	}
+}
+
+#endif // R_SKM_NEON
+
+typedef struct skmkernels_s {
+	const char *name;
+	void ( *lerpBonePoses )( unsigned int numbones, const bonepose_t *oldbp, const bonepose_t *bp, float frontlerp, bonepose_t *out );
+	void ( *blendPoses )( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose );
+	void ( *transformVerts )( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov );
+	void ( *transformNormals )( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov );
+	void ( *transformNormalsAndSVecs )( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv );
+} skmkernels_t;
+
+static const skmkernels_t r_skmKernelsScalar = {
+	"scalar",
+	R_SkeletalLerpBonePoses,
+	R_SkeletalBlendPoses,
+	R_SkeletalTransformVerts,
+	R_SkeletalTransformNormals,
+	R_SkeletalTransformNormalsAndSVecs
+};
+
+#if defined( R_SKM_SSE2 )
+static const skmkernels_t r_skmKernelsSIMD = {
+	"SSE2",
+	R_SkeletalLerpBonePoses_SSE2,
+	R_SkeletalBlendPoses_SSE2,
+	R_SkeletalTransformVerts_SSE2,
+	R_SkeletalTransformNormals_SSE2,
+	R_SkeletalTransformNormalsAndSVecs_SSE2
+};
+#elif defined( R_SKM_NEON )
+static const skmkernels_t r_skmKernelsSIMD = {
+	"NEON",
+	R_SkeletalLerpBonePoses_NEON,
+	R_SkeletalBlendPoses_NEON,
+	R_SkeletalTransformVerts_NEON,
+	R_SkeletalTransformNormals_NEON,
+	R_SkeletalTransformNormalsAndSVecs_NEON
+};
+#endif
+
+/*
+* R_SkeletalSIMDKernels
+*
+* Returns NULL if there are no SIMD kernels for this CPU.
+*/
+static const skmkernels_t *R_SkeletalSIMDKernels( void ) {
+#if defined( R_SKM_SSE2 )
+	if( ri.Com_CPUFeatures() & QCPU_HAS_SSE2 ) {
+		return &r_skmKernelsSIMD;
+	}
+	return NULL;
+#elif defined( R_SKM_NEON )
+	return &r_skmKernelsSIMD;
+#else
+	return NULL;
+#endif
+}
+
+/*
+* R_SkeletalSelectKernels
+*/
+static void R_SkeletalSelectKernels( void ) {
+	const skmkernels_t *simd = R_SkeletalSIMDKernels();
+
+	r_skmKernels = &r_skmKernelsScalar;
+	if( r_skm_simd->integer && simd ) {
+		r_skmKernels = simd;
+	}
+	r_skm_simd->modified = false;
+}
+
+#ifndef PUBLIC_BUILD
+
+/*
+* R_SkeletalRandomDualQuat
+*/
+static void R_SkeletalRandomDualQuat( dualquat_t dq ) {
+	int i;
+
+	for( i = 0; i < 8; i++ ) {
+		dq[i] = crandom();
+	}
+	dq[4] *= 32; dq[5] *= 32; dq[6] *= 32;
+	Quat_Normalize( &dq[0] );
+}
+
+/*
+* R_SkeletalCompareFloats
+*/
+static float R_SkeletalCompareFloats( const float *a, const float *b, int num, int stride, int numcomps ) {
+	int i, j;
+	float d, maxerr = 0;
+
+	for( i = 0; i < num; i++, a += stride, b += stride ) {
+		for( j = 0; j < numcomps; j++ ) {
+			d = fabs( a[j] - b[j] ) / max( 1.0f, fabs( a[j] ) );
+			maxerr = max( maxerr, d );
+		}
+	}
+	return maxerr;
+}
+
+/*
+* R_SkeletalKernelsTest_f
+*
+* skmkerneltest [numverts] [iterations]
+*
+* Runs the SIMD skinning kernels and the scalar ones on the same random
+* data, reports the largest relative difference and timings for each.
+*/
+void R_SkeletalKernelsTest_f( void ) {
+#define SKMTEST_BONES	128
+#define SKMTEST_BLENDS	128
+#define SKMTEST_TOLERANCE	1e-4f
+	int i, j, it, numverts, iterations;
+	const skmkernels_t *kernels[2];
+	bonepose_t *oldbp, *bp, *lerped[2];
+	mskblend_t *blends;
+	mat4_t *poses[2];
+	unsigned int *vblends;
+	vec_t *verts, *normals, *svecs, *overts[2], *onormals[2], *osvecs[2];
+	uint64_t t[2][5];
+	float err[5];
+	size_t vsize;
+	bool pass;
+	static const char *stages[5] = { "lerp", "blend", "verts", "normals", "svecs" };
+
+	kernels[0] = &r_skmKernelsScalar;
+	kernels[1] = R_SkeletalSIMDKernels();
+	if( !kernels[1] ) {
+		ri.Com_Printf( "No SIMD skinning kernels for this CPU\n" );
+		return;
+	}
+
+	numverts = ri.Cmd_Argc() > 1 ? atoi( ri.Cmd_Argv( 1 ) ) : 10000;
+	iterations = ri.Cmd_Argc() > 2 ? atoi( ri.Cmd_Argv( 2 ) ) : 100;
+	numverts = max( numverts, 1 );
+	iterations = max( iterations, 1 );
+
+	vsize = sizeof( vec4_t ) * numverts;
+	oldbp = R_Malloc( sizeof( bonepose_t ) * SKMTEST_BONES * 4 );
+	bp = oldbp + SKMTEST_BONES;
+	lerped[0] = bp + SKMTEST_BONES;
+	lerped[1] = lerped[0] + SKMTEST_BONES;
+	blends = R_Malloc( sizeof( mskblend_t ) * SKMTEST_BLENDS );
+	poses[0] = R_Malloc( sizeof( mat4_t ) * ( SKMTEST_BONES + SKMTEST_BLENDS ) * 2 );
+	poses[1] = poses[0] + SKMTEST_BONES + SKMTEST_BLENDS;
+	vblends = R_Malloc( sizeof( *vblends ) * numverts );
+	verts = R_Malloc( vsize * 9 );
+	normals = verts + numverts * 4;
+	svecs = normals + numverts * 4;
+	overts[0] = svecs + numverts * 4;
+	overts[1] = overts[0] + numverts * 4;
+	onormals[0] = overts[1] + numverts * 4;
+	onormals[1] = onormals[0] + numverts * 4;
+	osvecs[0] = onormals[1] + numverts * 4;
+	osvecs[1] = osvecs[0] + numverts * 4;
+
+	for( i = 0; i < SKMTEST_BONES; i++ ) {
+		R_SkeletalRandomDualQuat( oldbp[i].dualquat );
+		R_SkeletalRandomDualQuat( bp[i].dualquat );
+	}
+
+	for( i = 0; i < SKMTEST_BLENDS; i++ ) {
+		int left = 255;
+
+		for( j = 0; j < SKM_MAX_WEIGHTS; j++ ) {
+			blends[i].indices[j] = rand() % SKMTEST_BONES;
+			blends[i].weights[j] = j == SKM_MAX_WEIGHTS - 1 ? left : rand() % ( left + 1 );
+			left -= blends[i].weights[j];
+		}
+		if( !blends[i].weights[0] ) {
+			blends[i].weights[0] = 255;
+			blends[i].weights[1] = 0;
+		}
+	}
+
+	for( i = 0; i < numverts; i++ ) {
+		vblends[i] = rand() % ( SKMTEST_BONES + SKMTEST_BLENDS );
+		for( j = 0; j < 3; j++ ) {
+			verts[i * 4 + j] = crandom() * 64;
+			normals[i * 4 + j] = crandom();
+			svecs[i * 4 + j] = crandom();
+		}
+		verts[i * 4 + 3] = 1;
+		normals[i * 4 + 3] = 0;
+		svecs[i * 4 + 3] = rand() & 1 ? 1 : -1;
+	}
+
+	for( i = 0; i < 2; i++ ) {
+		uint64_t t0;
+
+		memset( t[i], 0, sizeof( t[i] ) );
+
+		for( it = 0; it < iterations; it++ ) {
+			t0 = ri.Sys_Microseconds();
+			kernels[i]->lerpBonePoses( SKMTEST_BONES, oldbp, bp, 0.3f, lerped[i] );
+			t[i][0] += ri.Sys_Microseconds() - t0;
+
+			for( j = 0; j < SKMTEST_BONES; j++ ) {
+				Matrix4_FromDualQuaternion( lerped[0][j].dualquat, poses[i][j] );
+			}
+
+			t0 = ri.Sys_Microseconds();
+			kernels[i]->blendPoses( SKMTEST_BLENDS, blends, SKMTEST_BONES, poses[i] );
+			t[i][1] += ri.Sys_Microseconds() - t0;
+
+			t0 = ri.Sys_Microseconds();
+			kernels[i]->transformVerts( numverts, vblends, poses[i], verts, overts[i] );
+			t[i][2] += ri.Sys_Microseconds() - t0;
+
+			t0 = ri.Sys_Microseconds();
+			kernels[i]->transformNormals( numverts, vblends, poses[i], normals, onormals[i] );
+			t[i][3] += ri.Sys_Microseconds() - t0;
+
+			t0 = ri.Sys_Microseconds();
+			kernels[i]->transformNormalsAndSVecs( numverts, vblends, poses[i], normals, onormals[i], svecs, osvecs[i] );
+			t[i][4] += ri.Sys_Microseconds() - t0;
+		}
+	}
+
+	// both blend passes start from the same bone matrices, so any difference
+	// in blended matrices comes from the blend kernels alone
+	err[0] = R_SkeletalCompareFloats( lerped[0][0].dualquat, lerped[1][0].dualquat, SKMTEST_BONES, 8, 8 );
+	err[1] = R_SkeletalCompareFloats( poses[0][SKMTEST_BONES], poses[1][SKMTEST_BONES], SKMTEST_BLENDS * 4, 4, 3 );
+	err[2] = R_SkeletalCompareFloats( overts[0], overts[1], numverts, 4, 4 );
+	err[3] = R_SkeletalCompareFloats( onormals[0], onormals[1], numverts, 4, 4 );
+	err[4] = R_SkeletalCompareFloats( osvecs[0], osvecs[1], numverts, 4, 4 );
+
+	ri.Com_Printf( "%i verts, %i iterations, scalar vs %s:\n", numverts, iterations, kernels[1]->name );
+
+	pass = true;
+	for( i = 0; i < 5; i++ ) {
+		ri.Com_Printf( "%-8s %8.2f %8.2f us %10g %s\n", stages[i],
+			(double)t[0][i] / iterations, (double)t[1][i] / iterations, err[i],
+			err[i] <= SKMTEST_TOLERANCE ? "ok" : S_COLOR_RED "FAILED" );
+		pass = pass && err[i] <= SKMTEST_TOLERANCE;
+	}
+
+	ri.Com_Printf( "%s\n", pass ? "All kernels match the scalar code" : S_COLOR_RED "SIMD kernels don't match the scalar code" );
+
+	R_Free( verts );
+	R_Free( vblends );
+	R_Free( poses[0] );
+	R_Free( blends );
+	R_Free( oldbp );
+#undef SKMTEST_TOLERANCE
+#undef SKMTEST_BLENDS
+#undef SKMTEST_BONES
+}
+
+#endif // PUBLIC_BUILD
+
+/*
+* R_CacheBoneTransforms
+*/
+static void R_CacheBoneTransforms( skmcacheentry_t *cache ) {
 	unsigned i, j;
 	const entity_t *e;
 	float frontlerp;
 	bonepose_t tempbonepose[256];
-	const bonepose_t *bp, *oldbp, *bonepose, *oldbonepose, *lerpedbonepose;
+	const bonepose_t *bp, *oldbp, *bonepose, *lerpedbonepose;
 	bonepose_t *out, tp;
 	mskbone_t *bone;
 	const mskmodel_t *skmodel;
-	skmcacheentry_t *cache;
 	mat4_t *bonePoseRelativeMat;
 	dualquat_t *bonePoseRelativeDQ;
 
-	cache = ja->parg;
-	if( !cache ) {
-		return;
-	}
-
 	e = R_NUM2ENT( cache->entNum );
 	skmodel = cache->skmodel;
 	bp = cache->boneposes;
@@ -1126,20 +1691,12 @@ static void R_CacheBoneTransformsJob( unsigned first, unsigned items, jobarg_t *
 	} else {
 		if( e->boneposes ) {
 			// lerp, assume that parent transforms have already been applied
-			for( i = 0, out = tempbonepose, bonepose = bp, oldbonepose = oldbp, bone = skmodel->bones; i < skmodel->numbones; i++, out++, bonepose++, oldbonepose++, bone++ ) {
-				DualQuat_Lerp( oldbonepose->dualquat, bonepose->dualquat, frontlerp, out->dualquat );
-			}
+			r_skmKernels->lerpBonePoses( skmodel->numbones, oldbp, bp, frontlerp, tempbonepose );
 		} else {
-			// lerp and transform
-			for( i = 0; i < skmodel->numbones; i++ ) {
-				j = i;
-				out = tempbonepose + j;
-				bonepose = bp + j;
-				oldbonepose = oldbp + j;
-				bone = skmodel->bones + j;
-
-				DualQuat_Lerp( oldbonepose->dualquat, bonepose->dualquat, frontlerp, out->dualquat );
+			// lerp and transform, parents always precede their children
+			r_skmKernels->lerpBonePoses( skmodel->numbones, oldbp, bp, frontlerp, tempbonepose );
 
+			for( i = 0, out = tempbonepose, bone = skmodel->bones; i < skmodel->numbones; i++, out++, bone++ ) {
 				if( bone->parent >= 0 ) {
 					DualQuat_Copy( out->dualquat, tp.dualquat );
 					DualQuat_Multiply( tempbonepose[bone->parent].dualquat, tp.dualquat, out->dualquat );
@@ -1166,8 +1723,97 @@ static void R_CacheBoneTransformsJob( unsigned first, unsigned items, jobarg_t *
 		}
 
 		// generate matrices for all blend combinations
-		R_SkeletalBlendPoses( skmodel->numblends, skmodel->blends, skmodel->numbones, bonePoseRelativeMat );
+		r_skmKernels->blendPoses( skmodel->numblends, skmodel->blends, skmodel->numbones, bonePoseRelativeMat );
+	}
+}
+
+/*
+* R_CacheBoneTransformsJob
+*/
+static void R_CacheBoneTransformsJob( unsigned first, unsigned items, jobarg_t *ja ) {
+	unsigned i;
+	skmcacheentry_t **caches = ja->parg;
+
+	for( i = first; i < first + items; i++ ) {
+		R_CacheBoneTransforms( caches[i] );
+	}
+}
+
+/*
+* R_TransformSkeletalMeshesJob
+*
+* Skins meshes of entities which can't be skinned on the GPU, once bone
+* transforms of all entities in the batch are known.
+*/
+static void R_TransformSkeletalMeshesJob( unsigned first, unsigned items, jobarg_t *ja ) {
+	unsigned i;
+	const skmmeshjob_t *jobs = ja->parg;
+
+	for( i = first; i < first + items; i++ ) {
+		const skmcacheentry_t *cache = jobs[i].cache;
+		const mskmodel_t *skmodel = cache->skmodel;
+		const mskmesh_t *skmesh = skmodel->meshes + jobs[i].meshNum;
+		const skmmeshcache_t *meshcache = cache->meshes + jobs[i].meshNum;
+		mat4_t *bonePoseRelativeMat = ( mat4_t * )( cache->data + sizeof( dualquat_t ) * skmodel->numbones );
+
+		r_skmKernels->transformVerts( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
+			( vec_t * )skmesh->xyzArray[0], ( vec_t * )meshcache->xyzArray );
+
+		if( meshcache->sVectorsArray ) {
+			r_skmKernels->transformNormalsAndSVecs( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
+				( vec_t * )skmesh->normalsArray[0], ( vec_t * )meshcache->normalsArray,
+				( vec_t * )skmesh->sVectorsArray[0], ( vec_t * )meshcache->sVectorsArray );
+		} else {
+			r_skmKernels->transformNormals( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
+				( vec_t * )skmesh->normalsArray[0], ( vec_t * )meshcache->normalsArray );
+		}
+	}
+}
+
+/*
+* R_ScheduleSkeletalCacheJobs
+*
+* Computes bone transforms for all entities queued since the last call in one
+* parallel job, followed by another one which skins meshes on the CPU, if any.
+*/
+void R_ScheduleSkeletalCacheJobs( void ) {
+	unsigned i, j, numMeshJobs;
+	skmcacheentry_t **caches;
+	skmmeshjob_t *meshJobs;
+	jobarg_t ja = { 0 };
+
+	if( !r_skmbatchsize ) {
+		return;
+	}
+
+	// the batch array is reused by the next view before these jobs are done
+	caches = R_FrameCache_Alloc( sizeof( *caches ) * r_skmbatchsize );
+	memcpy( caches, r_skmbatch, sizeof( *caches ) * r_skmbatchsize );
+
+	ja.parg = caches;
+	RJ_ScheduleJob( &R_CacheBoneTransformsJob, &ja, r_skmbatchsize );
+
+	if( r_skmbatchmeshes ) {
+		meshJobs = R_FrameCache_Alloc( sizeof( *meshJobs ) * r_skmbatchmeshes );
+
+		numMeshJobs = 0;
+		for( i = 0; i < r_skmbatchsize; i++ ) {
+			if( !caches[i]->meshes ) {
+				continue;
+			}
+			for( j = 0; j < caches[i]->skmodel->nummeshes; j++ ) {
+				meshJobs[numMeshJobs].cache = caches[i];
+				meshJobs[numMeshJobs].meshNum = j;
+				numMeshJobs++;
+			}
+		}
+
+		ja.parg = meshJobs;
+		RJ_ScheduleDependentJob( &R_TransformSkeletalMeshesJob, &ja, numMeshJobs );
 	}
+
+	r_skmbatchsize = 0;
+	r_skmbatchmeshes = 0;
 }
 
 //=======================================================================
@@ -1228,20 +1874,35 @@ void R_DrawSkeletalSurf( const entity_t *e, const shader_t *shader, const mfog_t
 	dynamicMesh.numVerts = skmesh->numverts;
 	dynamicMesh.stArray = skmesh->stArray;
 
+	if( cache && cache->meshes ) {
+		const skmmeshcache_t *meshcache = cache->meshes + ( skmesh - skmodel->meshes );
+
+		// already skinned by the caching jobs
+		if( meshcache->sVectorsArray || !( vattribs & VATTRIB_SVECTOR_BIT ) ) {
+			dynamicMesh.xyzArray = meshcache->xyzArray;
+			dynamicMesh.normalsArray = meshcache->normalsArray;
+			dynamicMesh.sVectorsArray = meshcache->sVectorsArray;
+
+			RB_AddDynamicMesh( e, shader, fog, portalSurface, &dynamicMesh, GL_TRIANGLES, 0.0f, 0.0f );
+			RB_FlushDynamicMeshes();
+			return;
+		}
+	}
+
 	R_GetTransformBufferForMesh( &dynamicMesh, true,
 		 ( vattribs & ( VATTRIB_NORMAL_BIT | VATTRIB_SVECTOR_BIT ) ) ? true : false,
 		 ( vattribs & VATTRIB_SVECTOR_BIT ) ? true : false );
 
 	if( bonePoseRelativeMat ) {
-		R_SkeletalTransformVerts( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
+		r_skmKernels->transformVerts( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
 			  ( vec_t * )skmesh->xyzArray[0], ( vec_t * )( dynamicMesh.xyzArray ) );
 
 		if( vattribs & VATTRIB_SVECTOR_BIT ) {
-			R_SkeletalTransformNormalsAndSVecs( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
+			r_skmKernels->transformNormalsAndSVecs( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
 					( vec_t * )skmesh->normalsArray[0], ( vec_t * )( dynamicMesh.normalsArray ),
 					( vec_t * )skmesh->sVectorsArray[0], ( vec_t * )( dynamicMesh.sVectorsArray ) );
 		} else if( vattribs & VATTRIB_NORMAL_BIT ) {
-			R_SkeletalTransformNormals( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
+			r_skmKernels->transformNormals( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
 					( vec_t * )skmesh->normalsArray[0], ( vec_t * )( dynamicMesh.normalsArray ) );
 		}
 	} else {
@@ -1328,6 +1989,52 @@ void R_SkeletalModelFrameBounds( const model_t *mod, int frame, vec3_t mins, vec
 	VectorCopy( pframe->maxs, maxs );
 }
 
+/*
+* R_SkeletalMeshShader
+*/
+static const shader_t *R_SkeletalMeshShader( const entity_t *e, const mskmesh_t *mesh ) {
+	if( e->customSkin ) {
+		return R_FindShaderForSkinFile( e->customSkin, mesh->name );
+	}
+	if( e->customShader ) {
+		return e->customShader;
+	}
+	return mesh->skin.shader;
+}
+
+/*
+* R_AllocSkeletalMeshCache
+*
+* Allocates per-frame buffers for meshes of the entity to be skinned on the CPU.
+* Tangent vectors are only computed for meshes whose shaders need them.
+*/
+static void R_AllocSkeletalMeshCache( const entity_t *e, skmcacheentry_t *cache ) {
+	unsigned i;
+	const mskmodel_t *skmodel = cache->skmodel;
+	const mskmesh_t *mesh;
+	const shader_t *shader;
+	skmmeshcache_t *meshcache;
+	vec4_t *buf;
+	bool sVectors;
+
+	cache->meshes = R_FrameCache_Alloc( sizeof( *cache->meshes ) * skmodel->nummeshes );
+	if( !cache->meshes ) {
+		return;
+	}
+
+	for( i = 0, mesh = skmodel->meshes, meshcache = cache->meshes; i < skmodel->nummeshes; i++, mesh++, meshcache++ ) {
+		shader = R_SkeletalMeshShader( e, mesh );
+		sVectors = shader && ( shader->vattribs & VATTRIB_SVECTOR_BIT ) != 0;
+
+		buf = R_FrameCache_Alloc( sizeof( vec4_t ) * mesh->numverts * ( sVectors ? 3 : 2 ) );
+		meshcache->xyzArray = buf;
+		meshcache->normalsArray = buf + mesh->numverts;
+		meshcache->sVectorsArray = sVectors ? buf + mesh->numverts * 2 : NULL;
+	}
+
+	r_skmbatchmeshes += skmodel->nummeshes;
+}
+
 /*
 * R_AddSkeletalModelCacheJob
 */
@@ -1338,7 +2045,6 @@ static void R_AddSkeletalModelCacheJob( const entity_t *e, const model_t *mod )
 	const bonepose_t *bp, *oldbp;
 	skmcacheentry_t *cache;
 	bool hwTransform;
-	jobarg_t ja = { 0 };
 
 	entNum = R_ENT2NUM( e );
 	skmodel = ( ( mskmodel_t * )mod->extradata );
@@ -1352,7 +2058,8 @@ static void R_AddSkeletalModelCacheJob( const entity_t *e, const model_t *mod )
 		return;
 	}
 
-	hwTransform = (skmodel->numbones == 0 || glConfig.maxGLSLBones > 0);
+	// same condition as for building the static VBOs with bones data
+	hwTransform = skmodel->numbones <= glConfig.maxGLSLBones;
 	cache = ( void * )R_AllocSkeletalDataCache( entNum, skmodel, hwTransform );
 	if( !cache ) {
 		// probably out of memory
@@ -1405,8 +2112,11 @@ static void R_AddSkeletalModelCacheJob( const entity_t *e, const model_t *mod )
 		return;
 	}
 
-	ja.parg = cache;
-	RJ_ScheduleJob( &R_CacheBoneTransformsJob, &ja, 1 );
+	if( !hwTransform ) {
+		R_AllocSkeletalMeshCache( e, cache );
+	}
+
+	r_skmbatch[r_skmbatchsize++] = cache;
 }
 
 /*
@@ -1467,21 +2177,15 @@ bool R_AddSkeletalModelToDrawList( const entity_t *e ) {
 	}
 #endif
 
-	// run quaternions lerping job in the background
+	// queue quaternions lerping and skinning to be run in the background,
+	// see R_ScheduleSkeletalCacheJobs
 	R_AddSkeletalModelCacheJob( e, mod );
 
 	for( i = 0, mesh = skmodel->meshes; i < (int)skmodel->nummeshes; i++, mesh++ ) {
 		int drawOrder;
-		const shader_t *shader = NULL;
-
-		if( e->customSkin ) {
-			shader = R_FindShaderForSkinFile( e->customSkin, mesh->name );
-		} else if( e->customShader ) {
-			shader = e->customShader;
-		} else {
-			shader = mesh->skin.shader;
-		}
+		const shader_t *shader;
 
+		shader = R_SkeletalMeshShader( e, mesh );
 		if( !shader ) {
 			continue;
 		}
@@ -581,22 +581,99 @@ WORLD MODEL
 =============================================================
 */
 
+// leaves and surfaces are culled in parallel in chunks of fixed size, so that
+// whatever has to be reduced across the chunks ends up in fixed slots
+#define WORLD_LEAFS_PER_CHUNK   256     // must be a multiple of 4
+#define WORLD_SURFS_PER_CHUNK   512
+
+typedef struct {
+	vec3_t pvsMins, pvsMaxs;
+	unsigned numBrushPolys;
+	bool sky;
+} worldCullChunk_t;
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define R_CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+/*
+* R_CullLeafBounds4
+*
+* Frustum culls 4 consecutive leaves, starting at a multiple of 4, using leaf bounds
+* in SoA layout. Returns a mask of culled leaves in the lower 4 bits and a mask of
+* leaves which are entirely inside the frustum in the upper 4 bits. Same results
+* as with BoxOnPlaneSide.
+*/
+static unsigned R_CullLeafBounds4( const mbrushmodel_t *bm, unsigned first, unsigned clipFlags ) {
+	unsigned j, bit;
+	unsigned culled = 0, inside = 15;
+	const unsigned stride = bm->leafBoundsStride;
+	const float *b = bm->leafBounds + first;
+	const cplane_t *p;
+
+	for( j = 0, bit = 1, p = rn.frustum; j < sizeof( rn.frustum ) / sizeof( rn.frustum[0] ); j++, bit <<= 1, p++ ) {
+		// pick the box corners furthest along and against the normal
+		const float *x1 = b + ( ( p->signbits & 1 ) ? 0 : 3 ) * stride, *x2 = b + ( ( p->signbits & 1 ) ? 3 : 0 ) * stride;
+		const float *y1 = b + ( ( p->signbits & 2 ) ? 1 : 4 ) * stride, *y2 = b + ( ( p->signbits & 2 ) ? 4 : 1 ) * stride;
+		const float *z1 = b + ( ( p->signbits & 4 ) ? 2 : 5 ) * stride, *z2 = b + ( ( p->signbits & 4 ) ? 5 : 2 ) * stride;
+
+		if( !( clipFlags & bit ) ) {
+			continue;
+		}
+
+#ifdef R_CULL_SSE
+		{
+			const __m128 nx = _mm_set1_ps( p->normal[0] ), ny = _mm_set1_ps( p->normal[1] ), nz = _mm_set1_ps( p->normal[2] );
+			const __m128 dist = _mm_set1_ps( p->dist );
+			__m128 dist1, dist2;
+
+			dist1 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, _mm_load_ps( x1 ) ), _mm_mul_ps( ny, _mm_load_ps( y1 ) ) ), _mm_mul_ps( nz, _mm_load_ps( z1 ) ) );
+			dist2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, _mm_load_ps( x2 ) ), _mm_mul_ps( ny, _mm_load_ps( y2 ) ) ), _mm_mul_ps( nz, _mm_load_ps( z2 ) ) );
+
+			culled |= _mm_movemask_ps( _mm_cmplt_ps( dist1, dist ) );
+			inside &= _mm_movemask_ps( _mm_cmpge_ps( dist2, dist ) );
+		}
+#else
+		{
+			unsigned k;
+
+			for( k = 0; k < 4; k++ ) {
+				float dist1 = p->normal[0] * x1[k] + p->normal[1] * y1[k] + p->normal[2] * z1[k];
+				float dist2 = p->normal[0] * x2[k] + p->normal[1] * y2[k] + p->normal[2] * z2[k];
+
+				if( dist1 < p->dist ) {
+					culled |= 1 << k;
+				}
+				if( dist2 < p->dist ) {
+					inside &= ~( 1 << k );
+				}
+			}
+		}
+#endif
+	}
+
+	return culled | ( ( inside & ~culled ) << 4 );
+}
+
 /*
 * R_CullVisLeaves
 */
-static void R_CullVisLeaves( unsigned firstLeaf, unsigned numLeaves, unsigned clipFlags ) {
+static void R_CullVisLeaves( unsigned firstLeaf, unsigned numLeaves, unsigned clipFlags, worldCullChunk_t *chunk ) {
 	unsigned i, j;
+	const mbrushmodel_t *bm = rsh.worldBrushModel;
 	mleaf_t *leaf;
 	const uint8_t *pvs = rn.pvs;
 	const uint8_t *areabits = rn.areabits;
+	unsigned frustumGroup = UINT_MAX, frustumMask = 0;
+
+	VectorCopy( rn.pvsMins, chunk->pvsMins );
+	VectorCopy( rn.pvsMaxs, chunk->pvsMaxs );
 
 	for( i = 0; i < numLeaves; i++ ) {
-		int clipped;
-		unsigned bit, testFlags;
-		cplane_t *clipplane;
 		unsigned l = firstLeaf + i;
 
-		leaf = &rsh.worldBrushModel->leafs[l];
+		leaf = &bm->leafs[l];
 		if( leaf->cluster < 0 || !leaf->numVisSurfaces ) {
 			continue;
 		}
@@ -616,29 +693,21 @@ static void R_CullVisLeaves( unsigned firstLeaf, unsigned numLeaves, unsigned cl
 
 		// add leaf bounds to pvs bounds
 		for( j = 0; j < 3; j++ ) {
-			rn.pvsMins[j] = min( rn.pvsMins[j], leaf->mins[j] );
-			rn.pvsMaxs[j] = max( rn.pvsMaxs[j], leaf->maxs[j] );
+			chunk->pvsMins[j] = min( chunk->pvsMins[j], leaf->mins[j] );
+			chunk->pvsMaxs[j] = max( chunk->pvsMaxs[j], leaf->maxs[j] );
 		}
 
-		// track leaves, which are entirely inside the frustum
-		clipped = 0;
-		testFlags = clipFlags;
-		for( j = sizeof( rn.frustum ) / sizeof( rn.frustum[0] ), bit = 1, clipplane = rn.frustum; j > 0; j--, bit <<= 1, clipplane++ ) {
-			if( testFlags & bit ) {
-				clipped = BoxOnPlaneSide( leaf->mins, leaf->maxs, clipplane );
-				if( clipped == 2 ) {
-					break;
-				} else if( clipped == 1 ) {
-					testFlags &= ~bit; // node is entirely on screen
-				}
-			}
+		// frustum test the whole group of 4 leaves at once
+		if( frustumGroup != ( l & ~3 ) ) {
+			frustumGroup = l & ~3;
+			frustumMask = R_CullLeafBounds4( bm, frustumGroup, clipFlags );
 		}
 
-		if( clipped == 2 ) {
+		if( frustumMask & ( 1 << ( l & 3 ) ) ) {
 			continue; // fully clipped
 		}
 
-		if( testFlags == 0 ) {
+		if( frustumMask & ( 16 << ( l & 3 ) ) ) {
 			// fully visible
 			for( j = 0; j < leaf->numVisSurfaces; j++ ) {
 				assert( leaf->visSurfaces[j] < rn.meshlist->numWorldSurfVis );
@@ -658,13 +727,18 @@ static void R_CullVisLeaves( unsigned firstLeaf, unsigned numLeaves, unsigned cl
 
 /*
 * R_CullVisSurfaces
+*
+* Sky surfaces are clipped later on the calling thread, see R_ClipVisSkySurfaces.
 */
-static void R_CullVisSurfaces( unsigned firstSurf, unsigned numSurfs, unsigned clipFlags ) {
+static void R_CullVisSurfaces( unsigned firstSurf, unsigned numSurfs, unsigned clipFlags, worldCullChunk_t *chunk ) {
 	unsigned i;
 	unsigned end;
 
 	end = firstSurf + numSurfs;
 
+	chunk->numBrushPolys = 0;
+	chunk->sky = false;
+
 	for( i = firstSurf; i < end; i++ ) {
 		msurface_t *surf = rsh.worldBrushModel->surfaces + i;
 
@@ -692,14 +766,118 @@ static void R_CullVisSurfaces( unsigned firstSurf, unsigned numSurfs, unsigned c
 			rn.meshlist->worldDrawSurfVis[surf->drawSurf - 1] = 1;
 
 			if( surf->flags & SURF_SKY ) {
-				R_ClipSkySurface( &rn.skyDrawSurface, surf );
+				chunk->sky = true;
 			}
 
-			rf.stats.c_brush_polys++;
+			chunk->numBrushPolys++;
 		}
 	}
 }
 
+/*
+* R_CullVisLeavesJob
+*/
+static void R_CullVisLeavesJob( unsigned first, unsigned items, jobarg_t *ja ) {
+	unsigned i;
+	worldCullChunk_t *chunks = ja->parg;
+
+	for( i = first; i < first + items; i++ ) {
+		unsigned firstLeaf = i * WORLD_LEAFS_PER_CHUNK;
+		R_CullVisLeaves( firstLeaf, min( WORLD_LEAFS_PER_CHUNK, ja->uarg - firstLeaf ), ja->iarg, &chunks[i] );
+	}
+}
+
+/*
+* R_CullVisSurfacesJob
+*/
+static void R_CullVisSurfacesJob( unsigned first, unsigned items, jobarg_t *ja ) {
+	unsigned i;
+	worldCullChunk_t *chunks = ja->parg;
+
+	for( i = first; i < first + items; i++ ) {
+		unsigned firstSurf = i * WORLD_SURFS_PER_CHUNK;
+		R_CullVisSurfaces( firstSurf, min( WORLD_SURFS_PER_CHUNK, ja->uarg - firstSurf ), ja->iarg, &chunks[i] );
+	}
+}
+
+/*
+* R_RunWorldCullJob
+*
+* Runs the job over all chunks, either on the job system or on this thread.
+*/
+static void R_RunWorldCullJob( jobfunc_t job, unsigned numChunks, unsigned numItems, unsigned clipFlags,
+	worldCullChunk_t *chunks, bool parallel ) {
+	jobarg_t ja = { 0 };
+
+	ja.iarg = clipFlags;
+	ja.uarg = numItems;
+	ja.parg = chunks;
+
+	if( parallel ) {
+		RJ_ScheduleJob( job, &ja, numChunks );
+		RJ_FinishJobs();
+	} else {
+		job( 0, numChunks, &ja );
+	}
+}
+
+/*
+* R_CullWorldLeaves
+*/
+static void R_CullWorldLeaves( unsigned clipFlags, worldCullChunk_t *chunks, bool parallel ) {
+	unsigned i, j;
+	const mbrushmodel_t *bm = rsh.worldBrushModel;
+	unsigned numChunks = ( bm->numleafs + WORLD_LEAFS_PER_CHUNK - 1 ) / WORLD_LEAFS_PER_CHUNK;
+
+	R_RunWorldCullJob( &R_CullVisLeavesJob, numChunks, bm->numleafs, clipFlags, chunks, parallel );
+
+	for( i = 0; i < numChunks; i++ ) {
+		for( j = 0; j < 3; j++ ) {
+			rn.pvsMins[j] = min( rn.pvsMins[j], chunks[i].pvsMins[j] );
+			rn.pvsMaxs[j] = max( rn.pvsMaxs[j], chunks[i].pvsMaxs[j] );
+		}
+	}
+}
+
+/*
+* R_CullWorldSurfaces
+*/
+static void R_CullWorldSurfaces( unsigned clipFlags, worldCullChunk_t *chunks, bool parallel ) {
+	unsigned i, j;
+	const mbrushmodel_t *bm = rsh.worldBrushModel;
+	unsigned numChunks = ( bm->numModelSurfaces + WORLD_SURFS_PER_CHUNK - 1 ) / WORLD_SURFS_PER_CHUNK;
+
+	R_RunWorldCullJob( &R_CullVisSurfacesJob, numChunks, bm->numModelSurfaces, clipFlags, chunks, parallel );
+
+	for( i = 0; i < numChunks; i++ ) {
+		rf.stats.c_brush_polys += chunks[i].numBrushPolys;
+
+		if( !chunks[i].sky ) {
+			continue;
+		}
+
+		// sky clipping accumulates into the view's sky surface
+		for( j = i * WORLD_SURFS_PER_CHUNK; j < min( ( i + 1 ) * WORLD_SURFS_PER_CHUNK, bm->numModelSurfaces ); j++ ) {
+			const msurface_t *surf = bm->surfaces + j;
+
+			if( rn.meshlist->worldSurfVis[j] && ( surf->flags & SURF_SKY ) ) {
+				R_ClipSkySurface( &rn.skyDrawSurface, surf );
+			}
+		}
+	}
+}
+
+/*
+* R_AllocWorldCullChunks
+*/
+static worldCullChunk_t *R_AllocWorldCullChunks( void ) {
+	const mbrushmodel_t *bm = rsh.worldBrushModel;
+	unsigned numChunks = max( ( bm->numleafs + WORLD_LEAFS_PER_CHUNK - 1 ) / WORLD_LEAFS_PER_CHUNK,
+		( bm->numModelSurfaces + WORLD_SURFS_PER_CHUNK - 1 ) / WORLD_SURFS_PER_CHUNK );
+
+	return R_FrameCache_Alloc( sizeof( worldCullChunk_t ) * max( numChunks, 1 ) );
+}
+
 /*
 * R_AddVisSurfaces
 */
@@ -942,6 +1120,7 @@ void R_DrawWorldNode( void ) {
 	int64_t msec = 0, msec2 = 0;
 	bool speeds = r_speeds->integer != 0;
 	mbrushmodel_t *bm = rsh.worldBrushModel;
+	worldCullChunk_t *chunks;
 
 	R_ReserveDrawListWorldSurfaces( rn.meshlist );
 
@@ -975,8 +1154,10 @@ void R_DrawWorldNode( void ) {
 		msec2 = ri.Sys_Milliseconds();
 	}
 
+	chunks = R_AllocWorldCullChunks();
+
 	if( bm->numleafs <= bm->numsurfaces ) {
-		R_CullVisLeaves( 0, bm->numleafs, clipFlags );
+		R_CullWorldLeaves( clipFlags, chunks, true );
 	} else {
 		memset( (void *)rn.meshlist->worldSurfVis, 1, bm->numsurfaces * sizeof( *rn.meshlist->worldSurfVis ) );
 		memset( (void *)rn.meshlist->worldSurfFullVis, 0, bm->numsurfaces * sizeof( *rn.meshlist->worldSurfFullVis ) );
@@ -995,7 +1176,7 @@ void R_DrawWorldNode( void ) {
 		msec2 = ri.Sys_Milliseconds();
 	}
 
-	R_CullVisSurfaces( 0, bm->numModelSurfaces, clipFlags );
+	R_CullWorldSurfaces( clipFlags, chunks, true );
 
 	R_PostCullVisLeaves();
 
@@ -1048,3 +1229,190 @@ void R_DrawWorldNode( void ) {
 		rf.stats.t_world_node += ri.Sys_Milliseconds() - msec;
 	}
 }
+
+#ifndef PUBLIC_BUILD
+
+/*
+=============================================================
+
+WORLD CULLING BENCHMARK
+
+=============================================================
+*/
+
+#define WORLDCULLBENCH_MAX_VIEWS    1024
+#define WORLDCULLBENCH_AREABYTES    32
+
+// what's needed to replay world culling for a view
+typedef struct {
+	vec3_t viewOrigin;
+	cplane_t frustum[6];
+	unsigned clipFlags;
+	int viewcluster;
+	bool hasAreabits;
+	uint8_t areabits[WORLDCULLBENCH_AREABYTES];
+} worldCullView_t;
+
+static worldCullView_t r_worldCullViews[WORLDCULLBENCH_MAX_VIEWS];
+static unsigned r_numWorldCullViews, r_worldCullViewsHead;
+static const model_t *r_worldCullViewsModel;
+static volatile int r_worldCullBenchIterations;
+
+/*
+* R_RecordWorldCullView
+*
+* Records the camera of the main view after its frustum and PVS have been set up.
+*/
+void R_RecordWorldCullView( void ) {
+	worldCullView_t *view;
+	int arearowbytes;
+
+	if( !rsh.worldBrushModel ) {
+		return;
+	}
+
+	if( r_worldCullViewsModel != rsh.worldModel ) {
+		r_worldCullViewsModel = rsh.worldModel;
+		r_numWorldCullViews = r_worldCullViewsHead = 0;
+	}
+
+	view = &r_worldCullViews[r_worldCullViewsHead];
+	r_worldCullViewsHead = ( r_worldCullViewsHead + 1 ) % WORLDCULLBENCH_MAX_VIEWS;
+	r_numWorldCullViews = min( r_numWorldCullViews + 1, WORLDCULLBENCH_MAX_VIEWS );
+
+	VectorCopy( rn.viewOrigin, view->viewOrigin );
+	memcpy( view->frustum, rn.frustum, sizeof( view->frustum ) );
+	view->clipFlags = rn.clipFlags;
+	view->viewcluster = rn.viewcluster;
+
+	arearowbytes = ( rsh.worldBrushModel->numareas + 7 ) / 8;
+	view->hasAreabits = rn.areabits && arearowbytes <= WORLDCULLBENCH_AREABYTES;
+	if( view->hasAreabits ) {
+		memcpy( view->areabits, rn.areabits, arearowbytes );
+	}
+}
+
+/*
+* R_ReplayWorldCullView
+*
+* Returns time spent culling in microseconds.
+*/
+static uint64_t R_ReplayWorldCullView( worldCullView_t *view, worldCullChunk_t *chunks, bool parallel ) {
+	uint64_t t0;
+	mbrushmodel_t *bm = rsh.worldBrushModel;
+
+	VectorCopy( view->viewOrigin, rn.viewOrigin );
+	memcpy( rn.frustum, view->frustum, sizeof( rn.frustum ) );
+	rn.clipFlags = view->clipFlags;
+	rn.pvs = bm->pvs && view->viewcluster >= 0 ? Mod_ClusterPVS( view->viewcluster, bm ) : NULL;
+	rn.areabits = view->hasAreabits ? view->areabits : NULL;
+
+	VectorCopy( rn.viewOrigin, rn.pvsMins );
+	VectorCopy( rn.viewOrigin, rn.pvsMaxs );
+	R_ClearSky( &rn.skyDrawSurface );
+	R_ClearDrawList( rn.meshlist );
+
+	t0 = ri.Sys_Microseconds();
+
+	if( bm->numleafs <= bm->numsurfaces ) {
+		R_CullWorldLeaves( rn.clipFlags, chunks, parallel );
+	} else {
+		memset( (void *)rn.meshlist->worldSurfVis, 1, bm->numsurfaces * sizeof( *rn.meshlist->worldSurfVis ) );
+		memset( (void *)rn.meshlist->worldLeafVis, 1, bm->numleafs * sizeof( *rn.meshlist->worldLeafVis ) );
+	}
+	R_CullWorldSurfaces( rn.clipFlags, chunks, parallel );
+
+	return ri.Sys_Microseconds() - t0;
+}
+
+/*
+* R_RunWorldCullBench
+*
+* Replays culling of the world for all recorded views, first on this thread,
+* then on the job system, and checks that the results match.
+*/
+void R_RunWorldCullBench( void ) {
+	unsigned i, it, iterations, numViews, mismatches;
+	uint64_t time[2] = { 0, 0 }, maxTime[2] = { 0, 0 };
+	const mbrushmodel_t *bm = rsh.worldBrushModel;
+	refinst_t oldrn;
+	unsigned c_brush_polys;
+	worldCullChunk_t *chunks;
+	uint8_t *serialVis;
+	void *cachemark;
+
+	iterations = r_worldCullBenchIterations;
+	if( !iterations ) {
+		return;
+	}
+	r_worldCullBenchIterations = 0;
+
+	numViews = r_numWorldCullViews;
+	if( !bm || !numViews || r_worldCullViewsModel != rsh.worldModel ) {
+		Com_Printf( "worldcullbench: no views of the current map have been recorded\n" );
+		return;
+	}
+
+	oldrn = rn;
+	c_brush_polys = rf.stats.c_brush_polys;
+	R_ReserveDrawListWorldSurfaces( rn.meshlist );
+
+	cachemark = R_FrameCache_SetMark();
+	chunks = R_AllocWorldCullChunks();
+	serialVis = R_FrameCache_Alloc( bm->numsurfaces + bm->numDrawSurfaces );
+
+	mismatches = 0;
+	for( it = 0; it < iterations; it++ ) {
+		for( i = 0; i < numViews; i++ ) {
+			worldCullView_t *view = &r_worldCullViews[( r_worldCullViewsHead + WORLDCULLBENCH_MAX_VIEWS - numViews + i ) % WORLDCULLBENCH_MAX_VIEWS];
+			uint64_t t;
+
+			t = R_ReplayWorldCullView( view, chunks, false );
+			time[0] += t;
+			maxTime[0] = max( maxTime[0], t );
+
+			memcpy( serialVis, (const void *)rn.meshlist->worldSurfVis, bm->numsurfaces );
+			memcpy( serialVis + bm->numsurfaces, (const void *)rn.meshlist->worldDrawSurfVis, bm->numDrawSurfaces );
+
+			t = R_ReplayWorldCullView( view, chunks, true );
+			time[1] += t;
+			maxTime[1] = max( maxTime[1], t );
+
+			if( memcmp( serialVis, (const void *)rn.meshlist->worldSurfVis, bm->numsurfaces ) ||
+				memcmp( serialVis + bm->numsurfaces, (const void *)rn.meshlist->worldDrawSurfVis, bm->numDrawSurfaces ) ) {
+				mismatches++;
+			}
+		}
+	}
+
+	R_FrameCache_FreeToMark( cachemark );
+
+	R_ClearDrawList( rn.meshlist );
+	rf.stats.c_brush_polys = c_brush_polys;
+	rn = oldrn;
+
+	numViews *= iterations;
+	Com_Printf( "worldcullbench: %u views, %u leafs, %u surfaces, %i job threads\n",
+		numViews, bm->numleafs, bm->numModelSurfaces, ri.Jobs_NumThreads() );
+	Com_Printf( "serial:   %8.2f us/view, worst %" PRIu64 " us\n", (double)time[0] / numViews, maxTime[0] );
+	Com_Printf( "parallel: %8.2f us/view, worst %" PRIu64 " us\n", (double)time[1] / numViews, maxTime[1] );
+	if( mismatches ) {
+		Com_Printf( S_COLOR_RED "%u views culled differently on the job system\n", mismatches );
+	}
+}
+
+/*
+* R_WorldCullBench_f
+*
+* worldcullbench [iterations]
+*
+* Replays world culling for the last views of the current map rendered
+* by this client, e.g. during a demo playback, on the next frame.
+*/
+void R_WorldCullBench_f( void ) {
+	int iterations = ri.Cmd_Argc() > 1 ? atoi( ri.Cmd_Argv( 1 ) ) : 1;
+
+	r_worldCullBenchIterations = max( iterations, 1 );
+}
+
+#endif // PUBLIC_BUILD
@@ -75,8 +75,6 @@ void Sys_SendKeyEvents( void ) {
 /*****************************************************************************/
 
 int main( int argc, char **argv ) {
-	int64_t oldtime, newtime;
-
 #if defined( __APPLE__ ) && !defined( DEDICATED_ONLY )
 	char resourcesPath[MAXPATHLEN];
 	CFURLGetFileSystemRepresentation( CFBundleCopyResourcesDirectoryURL( CFBundleGetMainBundle() ), 1, (UInt8 *)resourcesPath, MAXPATHLEN );
@@ -93,19 +91,16 @@ int main( int argc, char **argv ) {
 
 	Qcommon_Init( argc, argv );
 
-	oldtime = Sys_Milliseconds();
 	while( true ) {
-		int time;
+		unsigned int time;
 		// find time spent rendering last frame
 		do {
-			newtime = Sys_Milliseconds();
-			time = newtime - oldtime;
+			time = Qcommon_FrameMsec();
 			if( time > 0 ) {
 				break;
 			}
 			Sys_Sleep( 0 );
 		} while( 1 );
-		oldtime = newtime;
 
 		Qcommon_Frame( time );
 	}
@@ -105,6 +105,13 @@ void Sys_Thread_Yield( void ) {
 	Sys_Sleep( 0 );
 }
 
+/*
+* Sys_Thread_NumProcessors
+*/
+int Sys_Thread_NumProcessors( void ) {
+	return SDL_GetCPUCount();
+}
+
 /*
 * Sys_Atomic_Add
 */
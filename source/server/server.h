@@ -327,6 +327,8 @@ extern cvar_t *sv_lastAutoUpdate;
 extern cvar_t *sv_defaultmap;
 
 extern cvar_t *sv_demodir;
+// KB of demo data which may be pending on the writer thread, 0 = synchronous writes
+extern cvar_t *sv_demowritequeue;
 
 extern cvar_t *sv_mm_authkey;
 extern cvar_t *sv_mm_loginonly;
@@ -480,6 +482,15 @@ void SV_DemoGet_f( client_t *client );
 
 bool SV_IsDemoDownloadRequest( const char *request );
 
+//
+// sv_bench.c
+//
+void SV_SnapBench_RunFrame( void );
+void SV_SnapBench_f( void );
+void SV_SnapBench_Shutdown( void );
+
+void SV_SnapStats_f( void );
+
 //
 // sv_motd.c
 //
@@ -0,0 +1,225 @@
+/*
+Copyright (C) 2026 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// sv_bench.c -- snapshot build and encoding benchmark
+//
+// Runs snapshot building and delta encoding for a number of synthetic
+// clients on top of the live game state, without touching the network.
+// The synthetic clients borrow the point of view of players in game
+// (bots included), so a dedicated server with bots is enough to get
+// realistic numbers.
+
+#include "server.h"
+
+typedef struct {
+	int numclients;
+	int numframes;
+	int framesleft;
+	client_t *clients;
+	client_entities_t client_entities;
+
+	uint64_t buildTime;
+	uint64_t writeTime;
+	uint64_t maxFrameTime;
+	uint64_t totalBytes;
+	int maxBytes;
+	int numsnaps;
+} sv_snapbench_t;
+
+static sv_snapbench_t sv_snapbench;
+
+/*
+* SV_SnapBench_Free
+*/
+static void SV_SnapBench_Free( void ) {
+	int i;
+
+	if( sv_snapbench.clients ) {
+		for( i = 0; i < sv_snapbench.numclients; i++ ) {
+			SNAP_FreeClientFrames( &sv_snapbench.clients[i] );
+		}
+		Mem_Free( sv_snapbench.clients );
+	}
+
+	if( sv_snapbench.client_entities.entities ) {
+		Mem_Free( sv_snapbench.client_entities.entities );
+	}
+
+	memset( &sv_snapbench, 0, sizeof( sv_snapbench ) );
+}
+
+/*
+* SV_SnapBench_Report
+*/
+static void SV_SnapBench_Report( void ) {
+	int frames = sv_snapbench.numframes - sv_snapbench.framesleft;
+
+	if( !frames || !sv_snapbench.numsnaps ) {
+		Com_Printf( "snapbench: no frames were run\n" );
+		return;
+	}
+
+	Com_Printf( "snapbench: %i clients, %i frames\n", sv_snapbench.numclients, frames );
+	Com_Printf( "build:  %8.2f us/frame %6.2f us/client\n",
+				(double)sv_snapbench.buildTime / frames, (double)sv_snapbench.buildTime / sv_snapbench.numsnaps );
+	Com_Printf( "encode: %8.2f us/frame %6.2f us/client\n",
+				(double)sv_snapbench.writeTime / frames, (double)sv_snapbench.writeTime / sv_snapbench.numsnaps );
+	Com_Printf( "worst frame: %" PRIu64 " us\n", sv_snapbench.maxFrameTime );
+	Com_Printf( "bytes:  %8.2f avg %i max per client per frame\n",
+				(double)sv_snapbench.totalBytes / sv_snapbench.numsnaps, sv_snapbench.maxBytes );
+}
+
+/*
+* SV_SnapBench_RunFrame
+*
+* Builds and encodes one snapshot for each synthetic client. The synthetic
+* clients acknowledge every frame, so all but the first snapshot are delta
+* compressed just like for a client on a perfect connection.
+*/
+void SV_SnapBench_RunFrame( void ) {
+	int i, numviews;
+	edict_t *views[MAX_CLIENTS];
+	uint64_t t0, t1, t2, frameTime;
+	msg_t msg;
+	static uint8_t msg_buffer[MAX_MSGLEN];
+
+	if( !sv_snapbench.framesleft ) {
+		return;
+	}
+
+	// collect the edicts whose point of view we're going to borrow
+	numviews = 0;
+	for( i = 0; i < sv_maxclients->integer; i++ ) {
+		client_t *cl = &svs.clients[i];
+		if( cl->state < CS_SPAWNED || !cl->edict || !cl->edict->r.client ) {
+			continue;
+		}
+		if( cl->edict->r.svflags & SVF_NOCLIENT ) {
+			continue;
+		}
+		views[numviews++] = cl->edict;
+	}
+
+	if( !numviews ) {
+		Com_Printf( "snapbench: no players left in game, aborting\n" );
+		SV_SnapBench_Report();
+		SV_SnapBench_Free();
+		return;
+	}
+
+	frameTime = 0;
+	for( i = 0; i < sv_snapbench.numclients; i++ ) {
+		client_t *client = &sv_snapbench.clients[i];
+
+		client->edict = views[i % numviews];
+
+		t0 = Sys_Microseconds();
+
+		SNAP_BuildClientFrameSnap( svs.cms, &sv.gi, sv.framenum, svs.gametime, client, ge->GetGameState(),
+								   &sv_snapbench.client_entities, false, sv_mempool );
+
+		t1 = Sys_Microseconds();
+
+		MSG_Init( &msg, msg_buffer, sizeof( msg_buffer ) );
+		SNAP_WriteFrameSnapToClient( &sv.gi, client, &msg, sv.framenum, svs.gametime, sv.baselines,
+									 &sv_snapbench.client_entities, 0, NULL, NULL );
+
+		t2 = Sys_Microseconds();
+
+		// pretend the client has received the frame
+		client->lastframe = sv.framenum;
+
+		sv_snapbench.buildTime += t1 - t0;
+		sv_snapbench.writeTime += t2 - t1;
+		sv_snapbench.totalBytes += msg.cursize;
+		if( (int)msg.cursize > sv_snapbench.maxBytes ) {
+			sv_snapbench.maxBytes = msg.cursize;
+		}
+		sv_snapbench.numsnaps++;
+		frameTime += t2 - t0;
+	}
+
+	if( frameTime > sv_snapbench.maxFrameTime ) {
+		sv_snapbench.maxFrameTime = frameTime;
+	}
+
+	if( --sv_snapbench.framesleft == 0 ) {
+		SV_SnapBench_Report();
+		SV_SnapBench_Free();
+	}
+}
+
+/*
+* SV_SnapBench_f
+*
+* snapbench <numclients> [numframes]
+*/
+void SV_SnapBench_f( void ) {
+	int i, numclients, numframes;
+
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: snapbench <numclients> [numframes]\n" );
+		return;
+	}
+
+	if( sv.state != ss_game ) {
+		Com_Printf( "Must be in a level to run the snapshot benchmark\n" );
+		return;
+	}
+
+	if( sv_snapbench.framesleft ) {
+		Com_Printf( "Snapshot benchmark already running, aborting\n" );
+		SV_SnapBench_Report();
+		SV_SnapBench_Free();
+		return;
+	}
+
+	numclients = atoi( Cmd_Argv( 1 ) );
+	numframes = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 1000;
+	if( numclients < 1 || numclients > MAX_CLIENTS || numframes < 1 ) {
+		Com_Printf( "Invalid number of clients or frames\n" );
+		return;
+	}
+
+	sv_snapbench.numclients = numclients;
+	sv_snapbench.numframes = sv_snapbench.framesleft = numframes;
+	sv_snapbench.clients = Mem_Alloc( sv_mempool, sizeof( client_t ) * numclients );
+
+	// the synthetic clients get their own entities storage, not to overwrite
+	// snapshots of the real clients which still can be delta compressed against
+	sv_snapbench.client_entities.num_entities = numclients * UPDATE_BACKUP * MAX_SNAP_ENTITIES;
+	sv_snapbench.client_entities.entities =
+		Mem_Alloc( sv_mempool, sizeof( entity_state_t ) * sv_snapbench.client_entities.num_entities );
+
+	for( i = 0; i < numclients; i++ ) {
+		client_t *client = &sv_snapbench.clients[i];
+		client->state = CS_SPAWNED;
+		client->lastframe = -1;
+	}
+
+	Com_Printf( "Running snapshot benchmark for %i clients over %i frames\n", numclients, numframes );
+}
+
+/*
+* SV_SnapBench_Shutdown
+*/
+void SV_SnapBench_Shutdown( void ) {
+	SV_SnapBench_Free();
+}
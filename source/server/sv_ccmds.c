@@ -390,6 +390,9 @@ void SV_InitOperatorCommands( void ) {
 
 	Cmd_AddCommand( "purelist", SV_PureList_f );
 
+	Cmd_AddCommand( "snapbench", SV_SnapBench_f );
+	Cmd_AddCommand( "snapstats", SV_SnapStats_f );
+
 	if( dedicated->integer ) {
 		Cmd_AddCommand( "autoupdate", SV_AutoUpdate_f );
 		Cmd_AddCommand( "autoupdatecheck", SV_AutoUpdateCheck_f );
@@ -423,6 +426,9 @@ void SV_ShutdownOperatorCommands( void ) {
 
 	Cmd_RemoveCommand( "purelist" );
 
+	Cmd_RemoveCommand( "snapbench" );
+	Cmd_RemoveCommand( "snapstats" );
+
 	if( dedicated->integer ) {
 		Cmd_RemoveCommand( "autoupdate" );
 		Cmd_RemoveCommand( "autoupdatecheck" );
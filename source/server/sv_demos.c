@@ -27,13 +27,13 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 *
 * Writes given message to the demofile
 */
-static void SV_Demo_WriteMessage( msg_t *msg ) {
+static bool SV_Demo_WriteMessage( msg_t *msg ) {
 	assert( svs.demo.file );
 	if( !svs.demo.file ) {
-		return;
+		return false;
 	}
 
-	SNAP_RecordDemoMessage( svs.demo.file, msg, 0 );
+	return SNAP_RecordDemoMessage( svs.demo.file, msg, 0 );
 }
 
 /*
@@ -53,6 +53,7 @@ static void SV_Demo_WriteStartMessages( void ) {
 void SV_Demo_WriteSnap( void ) {
 	int i;
 	msg_t msg;
+	int64_t reliableSent, reliableAcknowledge;
 	uint8_t msg_buffer[MAX_MSGLEN];
 
 	if( !svs.demo.file ) {
@@ -77,9 +78,19 @@ void SV_Demo_WriteSnap( void ) {
 
 	SV_WriteFrameSnapToClient( &svs.demo.client, &msg );
 
+	reliableSent = svs.demo.client.reliableSent;
+	reliableAcknowledge = svs.demo.client.reliableAcknowledge;
+
 	SV_AddReliableCommandsToMessage( &svs.demo.client, &msg );
 
-	SV_Demo_WriteMessage( &msg );
+	// if the message was dropped by the demo writer, the next snap
+	// must not be delta compressed against it and must carry the
+	// reliable commands again
+	svs.demo.client.nodelta = !SV_Demo_WriteMessage( &msg );
+	if( svs.demo.client.nodelta ) {
+		svs.demo.client.reliableSent = reliableSent;
+		svs.demo.client.reliableAcknowledge = reliableAcknowledge;
+	}
 
 	svs.demo.duration = svs.gametime - svs.demo.basetime;
 	svs.demo.client.lastframe = sv.framenum; // FIXME: is this needed?
@@ -176,6 +187,9 @@ void SV_Demo_Start_f( void ) {
 
 	Com_Printf( "Recording server demo: %s\n", svs.demo.filename );
 
+	// move disk I/O off the server frame
+	SNAP_AttachDemoWriter( svs.demo.file, (size_t)max( sv_demowritequeue->integer, 0 ) * 1024 );
+
 	SV_Demo_InitClient();
 
 	// write serverdata, configstrings and baselines
@@ -187,7 +201,6 @@ void SV_Demo_Start_f( void ) {
 	// write one nodelta frame
 	svs.demo.client.nodelta = true;
 	SV_Demo_WriteSnap();
-	svs.demo.client.nodelta = false;
 }
 
 /*
@@ -207,16 +220,7 @@ static void SV_Demo_Stop( bool cancel, bool silent ) {
 		SNAP_StopDemoRecording( svs.demo.file );
 
 		Com_Printf( "Stopped server demo recording: %s\n", svs.demo.filename );
-	}
 
-	FS_FCloseFile( svs.demo.file );
-	svs.demo.file = 0;
-
-	if( cancel ) {
-		if( !FS_RemoveFile( svs.demo.tempname ) ) {
-			Com_Printf( "Error: Failed to delete the temporary server demo file\n" );
-		}
-	} else {
 		// write some meta information about the match/demo
 		SV_SetDemoMetaKeyValue( "hostname", sv.configstrings[CS_HOSTNAME] );
 		SV_SetDemoMetaKeyValue( "localtime", va( "%" PRIi64, (int64_t)svs.demo.localtime ) );
@@ -228,14 +232,28 @@ static void SV_Demo_Stop( bool cancel, bool silent ) {
 		SV_SetDemoMetaKeyValue( "matchname", sv.configstrings[CS_MATCHNAME] );
 		SV_SetDemoMetaKeyValue( "matchscore", sv.configstrings[CS_MATCHSCORE] );
 		SV_SetDemoMetaKeyValue( "matchuuid", sv.configstrings[CS_MATCHUUID] );
+	}
 
-		SNAP_WriteDemoMetaData( svs.demo.tempname, svs.demo.meta_data, svs.demo.meta_data_realsize );
+	// the demo writer thread finalizes the file in the background
+	if( !SNAP_CloseDemoWriter( svs.demo.file, cancel, svs.demo.tempname, svs.demo.filename,
+							   svs.demo.meta_data, svs.demo.meta_data_realsize ) ) {
+		FS_FCloseFile( svs.demo.file );
 
-		if( !FS_MoveFile( svs.demo.tempname, svs.demo.filename ) ) {
-			Com_Printf( "Error: Failed to rename the server demo file\n" );
+		if( cancel ) {
+			if( !FS_RemoveFile( svs.demo.tempname ) ) {
+				Com_Printf( "Error: Failed to delete the temporary server demo file\n" );
+			}
+		} else {
+			SNAP_WriteDemoMetaData( svs.demo.tempname, svs.demo.meta_data, svs.demo.meta_data_realsize );
+
+			if( !FS_MoveFile( svs.demo.tempname, svs.demo.filename ) ) {
+				Com_Printf( "Error: Failed to rename the server demo file\n" );
+			}
 		}
 	}
 
+	svs.demo.file = 0;
+
 	svs.demo.localtime = 0;
 	svs.demo.basetime = svs.demo.duration = 0;
 
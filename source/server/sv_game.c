@@ -488,6 +488,12 @@ void SV_InitGameProgs( void ) {
 	import.CM_LeafArea = PF_CM_LeafArea;
 
 	import.Milliseconds = Sys_Milliseconds;
+	import.Microseconds = Sys_Microseconds;
+
+	import.Jobs_NumThreads = QJobs_NumThreads;
+	import.Jobs_Add = QJobs_Add;
+	import.Jobs_ParallelFor = QJobs_ParallelFor;
+	import.Jobs_Wait = QJobs_Wait;
 
 	import.ModelIndex = SV_ModelIndex;
 	import.SoundIndex = SV_SoundIndex;
@@ -210,6 +210,26 @@ void SV_SetServerConfigStrings( void ) {
 	Q_strncpyz( sv.configstrings[CS_MODMANIFEST], Cvar_String( "sv_modmanifest" ), sizeof( sv.configstrings[0] ) );
 }
 
+/*
+* SV_LoadCollisionMap
+*
+* Collision data comes from the process-wide map cache, so reloading the
+* same map and the local client don't load the bsp again.
+*/
+static void SV_LoadCollisionMap( const char *name, unsigned *checksum ) {
+	cmodel_state_t *cms;
+
+	// acquire first so that the old map stays cached on restarts
+	cms = CM_AcquireSharedMap( name, false, checksum );
+	CM_AddReference( cms );
+
+	Com_SetServerCM( NULL, 0 );
+	CM_ReleaseReference( svs.cms );
+	svs.cms = cms;
+
+	CM_PurgeSharedMaps();
+}
+
 /*
 * SV_SpawnServer
 * Change the server to a new map, taking all connected clients along with it.
@@ -244,7 +264,7 @@ static void SV_SpawnServer( const char *server, bool devmap ) {
 	sv.nextSnapTime = 1000;
 
 	Q_snprintfz( sv.configstrings[CS_WORLDMODEL], sizeof( sv.configstrings[CS_WORLDMODEL] ), "maps/%s.bsp", server );
-	CM_LoadMap( svs.cms, sv.configstrings[CS_WORLDMODEL], false, &checksum );
+	SV_LoadCollisionMap( sv.configstrings[CS_WORLDMODEL], &checksum );
 
 	Q_snprintfz( sv.configstrings[CS_MAPCHECKSUM], sizeof( sv.configstrings[CS_MAPCHECKSUM] ), "%i", checksum );
 
@@ -438,6 +458,8 @@ void SV_ShutdownGame( const char *finalmsg, bool reconnect ) {
 		SV_Demo_Stop_f();
 	}
 
+	SV_SnapBench_Shutdown();
+
 	if( svs.clients ) {
 		SV_FinalMessage( finalmsg, reconnect );
 	}
@@ -472,6 +494,9 @@ void SV_ShutdownGame( const char *finalmsg, bool reconnect ) {
 		svs.cms = NULL;
 	}
 
+	// free the maps nobody references anymore
+	CM_PurgeSharedMaps();
+
 	Com_SetServerCM( NULL, 0 );
 
 	memset( &sv, 0, sizeof( sv ) );
@@ -92,6 +92,7 @@ cvar_t *sv_autoUpdate;
 cvar_t *sv_lastAutoUpdate;
 
 cvar_t *sv_demodir;
+cvar_t *sv_demowritequeue;
 
 //============================================================================
 
@@ -388,11 +389,14 @@ static bool SV_RunGameFrame( int msec ) {
 		refreshGameModule = true;
 	}
 
-	// if there aren't pending packets to be sent, we can sleep
+	// if there aren't pending packets to be sent, we can sleep until the frame
+	// which is due to run the game or send a snapshot, or until a packet arrives
 	if( dedicated->integer && !sentFragments && !refreshSnapshot ) {
-		int sleeptime = min( WORLDFRAMETIME - ( accTime + 1 ), sv.nextSnapTime - ( svs.gametime + 1 ) );
+		int64_t sleeptime = min( WORLDFRAMETIME - accTime, sv.nextSnapTime - svs.gametime );
+		uint64_t deadline = Qcommon_FrameDeadline( max( sleeptime, 0 ) );
+		uint64_t now = Sys_Microseconds();
 
-		if( sleeptime > 0 ) {
+		if( sleeptime > 0 && deadline > now ) {
 			socket_t *sockets [] = { &svs.socket_udp, &svs.socket_udp6 };
 			socket_t *opened_sockets [sizeof( sockets ) / sizeof( sockets[0] ) + 1 ];
 			size_t sock_ind, open_ind;
@@ -408,7 +412,7 @@ static bool SV_RunGameFrame( int msec ) {
 			}
 			opened_sockets[open_ind] = NULL;
 
-			NET_Sleep( sleeptime, opened_sockets );
+			NET_SleepMicroseconds( deadline - now, opened_sockets );
 		}
 	}
 
@@ -622,6 +626,68 @@ static void SV_CheckMatchUUID( void ) {
 	SV_MM_GetMatchUUID( &SV_CheckMatchUUID_Callback );
 }
 
+typedef struct {
+	uint64_t lastSnapTime;
+	unsigned numIntervals;
+	double mean, m2;            // running mean and sum of squared deviations
+	uint64_t minInterval, maxInterval;
+} sv_snapstats_t;
+
+static sv_snapstats_t sv_snapstats;
+
+/*
+* SV_SnapStats_Update
+*/
+static void SV_SnapStats_Update( void ) {
+	uint64_t now = Sys_Microseconds();
+	uint64_t interval;
+	double delta;
+	sv_snapstats_t *stats = &sv_snapstats;
+
+	if( !stats->lastSnapTime ) {
+		stats->lastSnapTime = now;
+		return;
+	}
+
+	interval = now - stats->lastSnapTime;
+	stats->lastSnapTime = now;
+
+	if( !stats->numIntervals || interval < stats->minInterval ) {
+		stats->minInterval = interval;
+	}
+	if( interval > stats->maxInterval ) {
+		stats->maxInterval = interval;
+	}
+
+	stats->numIntervals++;
+	delta = (double)interval - stats->mean;
+	stats->mean += delta / stats->numIntervals;
+	stats->m2 += delta * ( (double)interval - stats->mean );
+}
+
+/*
+* SV_SnapStats_f
+*
+* Prints the timing of snapshots sent since the last call
+*/
+void SV_SnapStats_f( void ) {
+	sv_snapstats_t *stats = &sv_snapstats;
+	double variance;
+
+	if( !stats->numIntervals ) {
+		Com_Printf( "No snapshots were sent\n" );
+		return;
+	}
+
+	variance = stats->numIntervals > 1 ? stats->m2 / ( stats->numIntervals - 1 ) : 0.0;
+
+	Com_Printf( "snapshots: %u, expected interval %u us\n", stats->numIntervals + 1, svc.snapFrameTime * 1000 );
+	Com_Printf( "interval: %.1f us mean, %.1f us stddev, %.1f us^2 variance\n", stats->mean, sqrt( variance ), variance );
+	Com_Printf( "min: %" PRIu64 " us, max: %" PRIu64 " us\n", stats->minInterval, stats->maxInterval );
+
+	memset( stats, 0, sizeof( *stats ) );
+}
+
 /*
 * SV_Frame
 */
@@ -630,6 +696,7 @@ void SV_Frame( unsigned realmsec, unsigned gamemsec ) {
 
 	// if server is not active, do nothing
 	if( !svs.initialized ) {
+		sv_snapstats.lastSnapTime = 0;
 		SV_CheckDefaultMap();
 		return;
 	}
@@ -651,9 +718,14 @@ void SV_Frame( unsigned realmsec, unsigned gamemsec ) {
 		// send messages back to the clients that had packets read this frame
 		SV_SendClientMessages();
 
+		SV_SnapStats_Update();
+
 		// write snap to server demo file
 		SV_Demo_WriteSnap();
 
+		// build snaps for the synthetic benchmark clients
+		SV_SnapBench_RunFrame();
+
 		// run matchmaker stuff
 		SV_CheckMatchUUID();
 
@@ -858,6 +930,7 @@ void SV_Init( void ) {
 		Com_Printf( "Invalid demo prefix string: %s\n", sv_demodir->string );
 		Cvar_ForceSet( "sv_demodir", "" );
 	}
+	sv_demowritequeue = Cvar_Get( "sv_demowritequeue", "4096", CVAR_ARCHIVE );
 
 	// wsw : jal : cap client's exceding server rules
 	sv_maxrate =            Cvar_Get( "sv_maxrate", "0", CVAR_DEVELOPER );
@@ -938,6 +1011,9 @@ void SV_Shutdown( const char *finalmsg ) {
 	SV_MM_Shutdown( true );
 	SV_ShutdownGame( finalmsg, false );
 
+	// wait for the demos to be finalized
+	SNAP_ShutdownDemoWriters();
+
 	SV_ShutdownOperatorCommands();
 
 	Mem_FreePool( &sv_mempool );
@@ -419,7 +419,8 @@ void SV_SendClientMessages( void ) {
 
 		if( client->state == CS_SPAWNED ) {
 			if( !SV_SendClientDatagram( client ) ) {
-				Com_Printf( "Error sending message to %s: %s\n", client->name, NET_ErrorString() );
+				Com_LogPrintf( "server", COM_LOG_WARNING, (int)( client - svs.clients ), "Error sending message to %s: %s\n",
+							   client->name, NET_ErrorString() );
 				if( client->reliable ) {
 					SV_DropClient( client, DROP_TYPE_GENERAL, "Error sending message: %s\n", NET_ErrorString() );
 				}
@@ -431,7 +432,8 @@ void SV_SendClientMessages( void ) {
 				SV_InitClientMessage( client, &tmpMessage, NULL, 0 );
 				SV_AddReliableCommandsToMessage( client, &tmpMessage );
 				if( !SV_SendMessageToClient( client, &tmpMessage ) ) {
-					Com_Printf( "Error sending message to %s: %s\n", client->name, NET_ErrorString() );
+					Com_LogPrintf( "server", COM_LOG_WARNING, (int)( client - svs.clients ), "Error sending message to %s: %s\n",
+								   client->name, NET_ErrorString() );
 					if( client->reliable ) {
 						SV_DropClient( client, DROP_TYPE_GENERAL, "Error sending message: %s\n", NET_ErrorString() );
 					}
@@ -1555,6 +1555,14 @@ static unsigned S_HandleStuffCmd( const sndStuffCmd_t *cmd ) {
 	if( !Q_stricmp( cmd->text, "soundlist" ) ) {
 		S_SoundList_f();
 	}
+#ifndef PUBLIC_BUILD
+	else if( !Q_strnicmp( cmd->text, "mixbench ", 9 ) ) {
+		int numChannels, numFrames;
+		if( sscanf( cmd->text + 9, "%i %i", &numChannels, &numFrames ) == 2 ) {
+			S_MixBench( numChannels, numFrames );
+		}
+	}
+#endif
 	return sizeof( *cmd );
 }
 
@@ -232,6 +232,7 @@ extern cvar_t *s_mixahead;
 extern cvar_t *s_testsound;
 extern cvar_t *s_swapstereo;
 extern cvar_t *s_pseudoAcoustics;
+extern cvar_t *s_mixsimd;
 extern cvar_t *s_separationDelay;
 extern cvar_t *s_globalfocus;
 
@@ -257,6 +258,10 @@ void S_IssuePlaysound( playsound_t *ps );
 
 int S_PaintChannels( unsigned int endtime, int dumpfile, float gain );
 
+#ifndef PUBLIC_BUILD
+void S_MixBench( int numChannels, int numFrames );
+#endif
+
 //====================================================================
 
 /*
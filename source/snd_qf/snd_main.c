@@ -45,6 +45,7 @@ cvar_t *s_show;
 cvar_t *s_mixahead;
 cvar_t *s_swapstereo;
 cvar_t *s_pseudoAcoustics;
+cvar_t *s_mixsimd;
 cvar_t *s_separationDelay;
 cvar_t *s_globalfocus;
 
@@ -107,6 +108,28 @@ static void SF_SoundInfo_f( void ) {
 	Com_Printf( "0x%" PRIXPTR" dma buffer\n", (uintptr_t)dma.buffer );
 }
 
+#ifndef PUBLIC_BUILD
+/*
+* SF_MixBench_f
+*
+* mixbench [channels] [frames]
+*/
+static void SF_MixBench_f( void ) {
+	char text[80];
+	int numChannels = trap_Cmd_Argc() > 1 ? atoi( trap_Cmd_Argv( 1 ) ) : 64;
+	int numFrames = trap_Cmd_Argc() > 2 ? atoi( trap_Cmd_Argv( 2 ) ) : 200;
+
+	if( numChannels < 1 || numFrames < 1 ) {
+		Com_Printf( "Usage: mixbench [channels] [frames]\n" );
+		return;
+	}
+
+	// mix on the sound thread, which owns the mixer state
+	Q_snprintfz( text, sizeof( text ), "mixbench %i %i", numChannels, numFrames );
+	S_IssueStuffCmd( s_cmdPipe, text );
+}
+#endif
+
 /*
 * SF_StopAllSounds_f
 */
@@ -266,6 +289,7 @@ bool SF_Init( void *hwnd, int maxEntities, bool verbose ) {
 	s_testsound = trap_Cvar_Get( "s_testsound", "0", 0 );
 	s_swapstereo = trap_Cvar_Get( "s_swapstereo", "0", CVAR_ARCHIVE );
 	s_pseudoAcoustics = trap_Cvar_Get( "s_pseudoAcoustics", "0", CVAR_ARCHIVE );
+	s_mixsimd = trap_Cvar_Get( "s_mixsimd", "1", CVAR_ARCHIVE );
 	s_separationDelay = trap_Cvar_Get( "s_separationDelay", "1.0", CVAR_ARCHIVE );
 	s_globalfocus = trap_Cvar_Get( "s_globalfocus", "0", CVAR_ARCHIVE );
 
@@ -280,6 +304,9 @@ bool SF_Init( void *hwnd, int maxEntities, bool verbose ) {
 	trap_Cmd_AddCommand( "pausemusic", SF_PauseBackgroundTrack );
 	trap_Cmd_AddCommand( "soundlist", SF_SoundList_f );
 	trap_Cmd_AddCommand( "soundinfo", SF_SoundInfo_f );
+#ifndef PUBLIC_BUILD
+	trap_Cmd_AddCommand( "mixbench", SF_MixBench_f );
+#endif
 
 	num_sfx = 0;
 
@@ -349,6 +376,9 @@ void SF_Shutdown( bool verbose ) {
 	trap_Cmd_RemoveCommand( "pausemusic" );
 	trap_Cmd_RemoveCommand( "soundlist" );
 	trap_Cmd_RemoveCommand( "soundinfo" );
+#ifndef PUBLIC_BUILD
+	trap_Cmd_RemoveCommand( "mixbench" );
+#endif
 
 	S_MemFreePool( &soundpool );
 
@@ -21,7 +21,13 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "snd_local.h"
 
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define S_MIX_SSE2
+#include <emmintrin.h>
+#endif
+
 #define PAINTBUFFER_SIZE    2048
+#define MIX_BLOCK_SIZE      256
 static portable_samplepair_t paintbuffer[PAINTBUFFER_SIZE];
 static int snd_scaletable[32][256];
 static int *snd_p, snd_linear_count, snd_vol, music_vol;
@@ -161,10 +167,19 @@ LClampDone2:
 #pragma warning( disable : 4310 )       // cast truncates constant value
 #endif
 static void S_WriteLinearBlastStereo16( void ) {
-	int i;
+	int i = 0;
 	int val;
 
-	for( i = 0; i < snd_linear_count; i += 2 ) {
+#ifdef S_MIX_SSE2
+	// the saturating pack does the clamping
+	for( ; i + 8 <= snd_linear_count; i += 8 ) {
+		__m128i a = _mm_srai_epi32( _mm_loadu_si128( (const __m128i *)( snd_p + i ) ), 8 );
+		__m128i b = _mm_srai_epi32( _mm_loadu_si128( (const __m128i *)( snd_p + i + 4 ) ), 8 );
+		_mm_storeu_si128( (__m128i *)( snd_out + i ), _mm_packs_epi32( a, b ) );
+	}
+#endif
+
+	for( ; i < snd_linear_count; i += 2 ) {
 		val = snd_p[i] >> 8;
 		snd_out[i] = Q_bound( (short)0x8000, val, 0x7fff );
 
@@ -174,10 +189,20 @@ static void S_WriteLinearBlastStereo16( void ) {
 }
 
 static void S_WriteSwappedLinearBlastStereo16( void ) {
-	int i;
+	int i = 0;
 	int val;
 
-	for( i = 0; i < snd_linear_count; i += 2 ) {
+#ifdef S_MIX_SSE2
+	for( ; i + 8 <= snd_linear_count; i += 8 ) {
+		__m128i a = _mm_loadu_si128( (const __m128i *)( snd_p + i ) );
+		__m128i b = _mm_loadu_si128( (const __m128i *)( snd_p + i + 4 ) );
+		a = _mm_srai_epi32( _mm_shuffle_epi32( a, _MM_SHUFFLE( 2, 3, 0, 1 ) ), 8 );
+		b = _mm_srai_epi32( _mm_shuffle_epi32( b, _MM_SHUFFLE( 2, 3, 0, 1 ) ), 8 );
+		_mm_storeu_si128( (__m128i *)( snd_out + i ), _mm_packs_epi32( a, b ) );
+	}
+#endif
+
+	for( ; i < snd_linear_count; i += 2 ) {
 		val = snd_p[i + 1] >> 8;
 		snd_out[i] = Q_bound( (short)0x8000, val, 0x7fff );
 
@@ -340,10 +365,11 @@ CHANNEL MIXING
 ===============================================================================
 */
 
-static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
-static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
-static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
-static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
+static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int endtime, portable_samplepair_t *samp );
+static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, unsigned int endtime, portable_samplepair_t *samp );
+static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int endtime, portable_samplepair_t *samp );
+static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int endtime, portable_samplepair_t *samp );
+static void S_PaintChannel( channel_t *ch, sfxcache_t *sc, unsigned int count, portable_samplepair_t *samp, bool hq, bool simd );
 
 int S_PaintChannels( unsigned int endtime, int dumpfile, float gain ) {
 	unsigned int i;
@@ -355,8 +381,9 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain ) {
 	playsound_t *ps;
 
 	total = 0;
-	snd_vol = s_volume->value * gain * 256;
-	music_vol = s_musicvolume->value * gain * 256;
+	// mixing happens on the background thread while cvars are set on the main one
+	snd_vol = trap_Cvar_ReadValue( s_volume ) * gain * 256;
+	music_vol = trap_Cvar_ReadValue( s_musicvolume ) * gain * 256;
 
 	while( paintedtime < endtime ) {
 		// if paintbuffer is smaller than DMA buffer
@@ -437,19 +464,8 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain ) {
 				}
 
 				if( count > 0 && ch->sfx ) {
-					if( s_pseudoAcoustics->value ) {
-						if( sc->width == 1 ) {
-							S_PaintChannelFrom8HQ( ch, sc, count, ltime - paintedtime );
-						} else {
-							S_PaintChannelFrom16HQ( ch, sc, count, ltime - paintedtime );
-						}
-					} else {
-						if( sc->width == 1 ) {
-							S_PaintChannelFrom8( ch, sc, count, ltime - paintedtime );
-						} else {
-							S_PaintChannelFrom16( ch, sc, count, ltime - paintedtime );
-						}
-					}
+					S_PaintChannel( ch, sc, count, &paintbuffer[ltime - paintedtime], s_pseudoAcoustics->value != 0,
+									s_mixsimd->integer != 0 );
 					ltime += count;
 				}
 
@@ -491,12 +507,11 @@ void S_InitScaletable( void ) {
 	}
 }
 
-static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset ) {
+static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int count, portable_samplepair_t *samp ) {
 	unsigned int i;
 	int j;
 	int *lscale, *rscale;
 	unsigned char *sfx;
-	portable_samplepair_t *samp;
 
 	if( ch->leftvol > 255 ) {
 		ch->leftvol = 255;
@@ -513,8 +528,6 @@ static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int cou
 	lscale = snd_scaletable[ch->leftvol >> 3];
 	rscale = snd_scaletable[ch->rightvol >> 3];
 
-	samp = &paintbuffer[offset];
-
 	if( sc->channels == 2 ) {
 		sfx = (unsigned char *)sc->data + ch->pos * 2;
 
@@ -535,12 +548,11 @@ static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int cou
 	ch->pos += count;
 }
 
-static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset ) {
+static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, unsigned int count, portable_samplepair_t *samp ) {
 	unsigned int i;
 	int j;
 	int leftvol, rightvol;
 	signed short *sfx;
-	portable_samplepair_t *samp;
 
 	if( !snd_vol ) {
 		ch->pos += count;
@@ -550,8 +562,6 @@ static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, unsigned int co
 	leftvol = ch->leftvol * snd_vol;
 	rightvol = ch->rightvol * snd_vol;
 
-	samp = &paintbuffer[offset];
-
 	if( sc->channels == 2 ) {
 		sfx = (signed short *)sc->data + ch->pos * 2;
 
@@ -572,12 +582,11 @@ static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, unsigned int co
 	ch->pos += count;
 }
 
-static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset ) {
+static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int count, portable_samplepair_t *samp ) {
 	unsigned int i;
 	int j, k;
 	int *lscale, *rscale;
 	unsigned char *sfx;
-	portable_samplepair_t *samp;
 
 	if( ch->leftvol > 255 ) {
 		ch->leftvol = 255;
@@ -594,8 +603,6 @@ static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int c
 	lscale = snd_scaletable[ch->leftvol >> 3];
 	rscale = snd_scaletable[ch->rightvol >> 3];
 
-	samp = &paintbuffer[offset];
-
 	if( sc->channels == 2 ) {
 		sfx = (unsigned char *)sc->data + ch->pos * 2;
 
@@ -643,12 +650,11 @@ static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int c
 	ch->pos += count;
 }
 
-static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset ) {
+static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int count, portable_samplepair_t *samp ) {
 	unsigned int i;
 	int j, k;
 	int leftvol, rightvol;
 	signed short *sfx;
-	portable_samplepair_t *samp;
 
 	if( !snd_vol ) {
 		ch->pos += count;
@@ -658,8 +664,6 @@ static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int
 	leftvol = ch->leftvol * snd_vol;
 	rightvol = ch->rightvol * snd_vol;
 
-	samp = &paintbuffer[offset];
-
 	if( sc->channels == 2 ) {
 		sfx = (signed short *)sc->data + ch->pos * 2;
 
@@ -702,3 +706,449 @@ static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int
 
 	ch->pos += count;
 }
+
+/*
+===============================================================================
+
+BLOCK MIXING
+
+===============================================================================
+*/
+
+// with volumes up to this, ( sample * vol ) >> 8 can't overflow for 16-bit samples,
+// so the kernels below give exactly the same results as the scalar mixer
+#define MIX_MAX_VOLUME      0xffff
+
+#ifdef S_MIX_SSE2
+/*
+* S_MulVolume_SSE2
+*
+* Computes ( sample * vol ) >> 8 for eight 16-bit samples, the volumes are split
+* into their high and low bytes. Results for the first four samples go to lo.
+*/
+static inline void S_MulVolume_SSE2( __m128i s, __m128i volhi, __m128i vollo, __m128i *lo, __m128i *hi ) {
+	__m128i hl = _mm_mullo_epi16( s, volhi ), hh = _mm_mulhi_epi16( s, volhi );
+	__m128i ll = _mm_mullo_epi16( s, vollo ), lh = _mm_mulhi_epi16( s, vollo );
+
+	// ( s * ( volhi * 256 + vollo ) ) >> 8 == s * volhi + ( ( s * vollo ) >> 8 )
+	*lo = _mm_add_epi32( _mm_unpacklo_epi16( hl, hh ), _mm_srai_epi32( _mm_unpacklo_epi16( ll, lh ), 8 ) );
+	*hi = _mm_add_epi32( _mm_unpackhi_epi16( hl, hh ), _mm_srai_epi32( _mm_unpackhi_epi16( ll, lh ), 8 ) );
+}
+#endif
+
+/*
+* S_MixMono16
+*
+* Mixes 16-bit samples for each ear into the paint buffer, left and right may be the same.
+*/
+static void S_MixMono16( portable_samplepair_t *samp, const short *left, const short *right, unsigned int count,
+						 int leftvol, int rightvol, bool simd ) {
+	unsigned int i = 0;
+
+#ifdef S_MIX_SSE2
+	if( simd ) {
+		__m128i lhi = _mm_set1_epi16( leftvol >> 8 ), llo = _mm_set1_epi16( leftvol & 255 );
+		__m128i rhi = _mm_set1_epi16( rightvol >> 8 ), rlo = _mm_set1_epi16( rightvol & 255 );
+
+		for( ; i + 8 <= count; i += 8 ) {
+			__m128i l0, l1, r0, r1;
+			__m128i *out = (__m128i *)( samp + i );
+
+			S_MulVolume_SSE2( _mm_loadu_si128( (const __m128i *)( left + i ) ), lhi, llo, &l0, &l1 );
+			S_MulVolume_SSE2( _mm_loadu_si128( (const __m128i *)( right + i ) ), rhi, rlo, &r0, &r1 );
+
+			_mm_storeu_si128( out + 0, _mm_add_epi32( _mm_loadu_si128( out + 0 ), _mm_unpacklo_epi32( l0, r0 ) ) );
+			_mm_storeu_si128( out + 1, _mm_add_epi32( _mm_loadu_si128( out + 1 ), _mm_unpackhi_epi32( l0, r0 ) ) );
+			_mm_storeu_si128( out + 2, _mm_add_epi32( _mm_loadu_si128( out + 2 ), _mm_unpacklo_epi32( l1, r1 ) ) );
+			_mm_storeu_si128( out + 3, _mm_add_epi32( _mm_loadu_si128( out + 3 ), _mm_unpackhi_epi32( l1, r1 ) ) );
+		}
+	}
+#endif
+
+	for( ; i < count; i++ ) {
+		samp[i].left += ( left[i] * leftvol ) >> 8;
+		samp[i].right += ( right[i] * rightvol ) >> 8;
+	}
+}
+
+/*
+* S_MixStereo16
+*
+* Mixes interleaved 16-bit stereo samples into the paint buffer.
+*/
+static void S_MixStereo16( portable_samplepair_t *samp, const short *in, unsigned int count,
+						   int leftvol, int rightvol, bool simd ) {
+	unsigned int i = 0;
+
+#ifdef S_MIX_SSE2
+	if( simd ) {
+		int lhi = leftvol >> 8, llo = leftvol & 255, rhi = rightvol >> 8, rlo = rightvol & 255;
+		__m128i volhi = _mm_set_epi16( rhi, lhi, rhi, lhi, rhi, lhi, rhi, lhi );
+		__m128i vollo = _mm_set_epi16( rlo, llo, rlo, llo, rlo, llo, rlo, llo );
+
+		for( ; i + 4 <= count; i += 4 ) {
+			__m128i lo, hi;
+			__m128i *out = (__m128i *)( samp + i );
+
+			S_MulVolume_SSE2( _mm_loadu_si128( (const __m128i *)( in + i * 2 ) ), volhi, vollo, &lo, &hi );
+
+			_mm_storeu_si128( out + 0, _mm_add_epi32( _mm_loadu_si128( out + 0 ), lo ) );
+			_mm_storeu_si128( out + 1, _mm_add_epi32( _mm_loadu_si128( out + 1 ), hi ) );
+		}
+	}
+#endif
+
+	for( ; i < count; i++ ) {
+		samp[i].left += ( in[i * 2 + 0] * leftvol ) >> 8;
+		samp[i].right += ( in[i * 2 + 1] * rightvol ) >> 8;
+	}
+}
+
+/*
+* S_Widen8
+*
+* Converts 8-bit samples to 16-bit ones.
+*/
+static void S_Widen8( const uint8_t *in, short *out, unsigned int count, bool simd ) {
+	unsigned int i = 0;
+
+#ifdef S_MIX_SSE2
+	if( simd ) {
+		__m128i zero = _mm_setzero_si128();
+
+		for( ; i + 16 <= count; i += 16 ) {
+			__m128i b = _mm_loadu_si128( (const __m128i *)( in + i ) );
+			_mm_storeu_si128( (__m128i *)( out + i ), _mm_unpacklo_epi8( zero, b ) );
+			_mm_storeu_si128( (__m128i *)( out + i + 8 ), _mm_unpackhi_epi8( zero, b ) );
+		}
+	}
+#endif
+
+	for( ; i < count; i++ ) {
+		out[i] = (short)( in[i] << 8 );
+	}
+}
+
+/*
+* S_LowpassSamples
+*
+* Runs mono samples through the lowpass filter for one ear, writing 16-bit
+* results. The filter is recursive, so this can't be vectorized.
+*/
+static void S_LowpassSamples( const sfxcache_t *sc, int start, unsigned int count, int *history, int coeff, short *out ) {
+	unsigned int i;
+	int h[2];
+
+	// keep the history in registers
+	h[0] = history[0];
+	h[1] = history[1];
+
+	if( sc->width == 1 ) {
+		const uint8_t *sfx = sc->data + start;
+
+		for( i = 0; i < count; i++ ) {
+			int j = S_Lowpass2pole( sfx[i] << 8, h, coeff ) >> 8;
+			out[i] = (short)( ( j & 255 ) << 8 );
+		}
+	} else {
+		const short *sfx = (const short *)sc->data + start;
+
+		for( i = 0; i < count; i++ ) {
+			out[i] = S_Lowpass2pole( sfx[i], h, coeff );
+		}
+	}
+
+	history[0] = h[0];
+	history[1] = h[1];
+}
+
+/*
+* S_MixChannel
+*
+* Does the same as the S_PaintChannelFrom functions, in blocks of 16-bit samples,
+* with SIMD kernels if simd is true. Returns false if the volumes are out of the
+* range where the results would exactly match.
+*/
+static bool S_MixChannel( channel_t *ch, sfxcache_t *sc, unsigned int count, portable_samplepair_t *samp, bool hq, bool simd ) {
+	unsigned int i, n;
+	int leftvol, rightvol;
+	short lbuf[MIX_BLOCK_SIZE], rbuf[MIX_BLOCK_SIZE];
+
+	if( sc->width == 1 ) {
+		if( ch->leftvol > 255 ) {
+			ch->leftvol = 255;
+		}
+		if( ch->rightvol > 255 ) {
+			ch->rightvol = 255;
+		}
+
+		if( !s_volume->value ) {
+			ch->pos += count;
+			return true;
+		}
+
+		// the scale table holds ( signed char )sample * scale, the samples are widened to sample << 8
+		leftvol = snd_scaletable[ch->leftvol >> 3][1];
+		rightvol = snd_scaletable[ch->rightvol >> 3][1];
+	} else {
+		if( !snd_vol ) {
+			ch->pos += count;
+			return true;
+		}
+
+		leftvol = ch->leftvol * snd_vol;
+		rightvol = ch->rightvol * snd_vol;
+	}
+
+	if( leftvol < 0 || leftvol > MIX_MAX_VOLUME || rightvol < 0 || rightvol > MIX_MAX_VOLUME ) {
+		return false;
+	}
+
+	if( sc->channels == 2 ) {
+		if( sc->width == 2 ) {
+			S_MixStereo16( samp, (const short *)sc->data + ch->pos * 2, count, leftvol, rightvol, simd );
+		} else {
+			for( i = 0; i < count; i += n ) {
+				n = min( count - i, MIX_BLOCK_SIZE / 2 );
+				S_Widen8( sc->data + ( ch->pos + i ) * 2, lbuf, n * 2, simd );
+				S_MixStereo16( samp + i, lbuf, n, leftvol, rightvol, simd );
+			}
+		}
+	} else if( !hq ) {
+		if( sc->width == 2 ) {
+			const short *sfx = (const short *)sc->data + ch->pos;
+			S_MixMono16( samp, sfx, sfx, count, leftvol, rightvol, simd );
+		} else {
+			for( i = 0; i < count; i += n ) {
+				n = min( count - i, MIX_BLOCK_SIZE );
+				S_Widen8( sc->data + ch->pos + i, lbuf, n, simd );
+				S_MixMono16( samp + i, lbuf, lbuf, n, leftvol, rightvol, simd );
+			}
+		}
+	} else {
+		i = 0;
+
+		// while one ear is delayed, the other one gets the sound alone
+		if( ch->pos < ch->ldelay ) {
+			unsigned int rights = min( count, ch->ldelay - ch->pos );
+			for( ; i < rights; i += n ) {
+				n = min( rights - i, MIX_BLOCK_SIZE );
+				S_LowpassSamples( sc, ch->pos + i, n, &ch->lpf_history[2], ch->lpf_rcoeff, rbuf );
+				S_MixMono16( samp + i, rbuf, rbuf, n, 0, rightvol, simd );
+			}
+		} else if( ch->pos < ch->rdelay ) {
+			unsigned int lefts = min( count, ch->rdelay - ch->pos );
+			for( ; i < lefts; i += n ) {
+				n = min( lefts - i, MIX_BLOCK_SIZE );
+				S_LowpassSamples( sc, ch->pos + i, n, &ch->lpf_history[0], ch->lpf_lcoeff, lbuf );
+				S_MixMono16( samp + i, lbuf, lbuf, n, leftvol, 0, simd );
+			}
+		}
+
+		for( ; i < count; i += n ) {
+			n = min( count - i, MIX_BLOCK_SIZE );
+			S_LowpassSamples( sc, (int)( ch->pos + i ) - (int)ch->ldelay, n, &ch->lpf_history[0], ch->lpf_lcoeff, lbuf );
+			S_LowpassSamples( sc, (int)( ch->pos + i ) - (int)ch->rdelay, n, &ch->lpf_history[2], ch->lpf_rcoeff, rbuf );
+			S_MixMono16( samp + i, lbuf, rbuf, n, leftvol, rightvol, simd );
+		}
+	}
+
+	ch->pos += count;
+	return true;
+}
+
+/*
+* S_PaintChannel
+*/
+static void S_PaintChannel( channel_t *ch, sfxcache_t *sc, unsigned int count, portable_samplepair_t *samp, bool hq, bool simd ) {
+	if( simd && S_MixChannel( ch, sc, count, samp, hq, true ) ) {
+		return;
+	}
+
+	if( hq ) {
+		if( sc->width == 1 ) {
+			S_PaintChannelFrom8HQ( ch, sc, count, samp );
+		} else {
+			S_PaintChannelFrom16HQ( ch, sc, count, samp );
+		}
+	} else {
+		if( sc->width == 1 ) {
+			S_PaintChannelFrom8( ch, sc, count, samp );
+		} else {
+			S_PaintChannelFrom16( ch, sc, count, samp );
+		}
+	}
+}
+
+#ifndef PUBLIC_BUILD
+
+/*
+===============================================================================
+
+MIXER BENCHMARK
+
+===============================================================================
+*/
+
+#define MIXBENCH_SOUND_LENGTH   ( PAINTBUFFER_SIZE * 4 )
+#define MIXBENCH_MAX_DELAY      64
+
+static unsigned mixbench_seed;
+
+/*
+* S_MixBench_Rand
+*/
+static unsigned S_MixBench_Rand( void ) {
+	mixbench_seed = mixbench_seed * 1103515245 + 12345;
+	return mixbench_seed >> 8;
+}
+
+/*
+* S_MixBench_AllocSound
+*
+* Fills a sound with a sine wave and some noise on top.
+*/
+static sfxcache_t *S_MixBench_AllocSound( int width, int channels ) {
+	unsigned int i, numsamples = MIXBENCH_SOUND_LENGTH * channels;
+	sfxcache_t *sc = S_Malloc( sizeof( sfxcache_t ) + numsamples * width );
+
+	sc->length = MIXBENCH_SOUND_LENGTH;
+	sc->speed = dma.speed;
+	sc->width = width;
+	sc->channels = channels;
+
+	for( i = 0; i < numsamples; i++ ) {
+		int val = (int)( sin( i * 0.05 ) * 24000 ) + (int)( S_MixBench_Rand() & 8191 ) - 4096;
+		if( width == 1 ) {
+			sc->data[i] = (uint8_t)( val >> 8 );
+		} else {
+			( (short *)sc->data )[i] = val;
+		}
+	}
+
+	return sc;
+}
+
+/*
+* S_MixBench
+*
+* Mixes random channels playing synthetic 8 and 16-bit, mono and stereo sounds
+* with the scalar mixer and with the SIMD kernels, with and without pseudo
+* acoustics. Prints the timings and checks that both give the same results.
+*/
+void S_MixBench( int numChannels, int numFrames ) {
+	int i, j, pass, numMismatches = 0;
+	int oldvol = snd_vol;
+	int64_t t0, t1, t2, time[2][2] = { { 0, 0 }, { 0, 0 } };
+	sfxcache_t *sounds[4];
+	channel_t *channels[2];
+	portable_samplepair_t *buffers[2];
+	short *out[2];
+	static const char *passNames[2] = { "normal", "pseudo acoustics" };
+
+	if( !s_volume->value ) {
+		Com_Printf( "mixbench: s_volume is 0, nothing to mix\n" );
+		return;
+	}
+
+	mixbench_seed = 1;
+	snd_vol = s_volume->value * 256;
+
+	for( i = 0; i < 4; i++ ) {
+		sounds[i] = S_MixBench_AllocSound( 1 + ( i & 1 ), 1 + ( i >> 1 ) );
+	}
+	for( i = 0; i < 2; i++ ) {
+		channels[i] = S_Malloc( sizeof( channel_t ) * numChannels );
+		buffers[i] = S_Malloc( sizeof( portable_samplepair_t ) * PAINTBUFFER_SIZE );
+		out[i] = S_Malloc( sizeof( short ) * 2 * PAINTBUFFER_SIZE );
+	}
+
+	for( pass = 0; pass < 2; pass++ ) {
+		for( i = 0; i < numFrames; i++ ) {
+			// new positions, volumes and filters for all channels every frame
+			for( j = 0; j < numChannels; j++ ) {
+				channel_t *ch = &channels[0][j];
+				unsigned delay = S_MixBench_Rand() % MIXBENCH_MAX_DELAY;
+
+				memset( ch, 0, sizeof( *ch ) );
+				ch->leftvol = S_MixBench_Rand() & 255;
+				ch->rightvol = S_MixBench_Rand() & 255;
+				ch->pos = MIXBENCH_MAX_DELAY + S_MixBench_Rand() % ( MIXBENCH_SOUND_LENGTH - PAINTBUFFER_SIZE - MIXBENCH_MAX_DELAY );
+				if( pass ) {
+					ch->lpf_lcoeff = S_MixBench_Rand() & 0xffff;
+					ch->lpf_rcoeff = S_MixBench_Rand() & 0xffff;
+					// sometimes start within the delay
+					if( S_MixBench_Rand() & 1 ) {
+						ch->ldelay = ch->pos + delay;
+					} else {
+						ch->rdelay = delay;
+					}
+				}
+			}
+			memcpy( channels[1], channels[0], sizeof( channel_t ) * numChannels );
+			memset( buffers[0], 0, sizeof( portable_samplepair_t ) * PAINTBUFFER_SIZE );
+			memset( buffers[1], 0, sizeof( portable_samplepair_t ) * PAINTBUFFER_SIZE );
+
+			t0 = trap_Microseconds();
+			for( j = 0; j < numChannels; j++ ) {
+				S_PaintChannel( &channels[0][j], sounds[j & 3], PAINTBUFFER_SIZE, buffers[0], pass != 0, false );
+			}
+			t1 = trap_Microseconds();
+			for( j = 0; j < numChannels; j++ ) {
+				S_PaintChannel( &channels[1][j], sounds[j & 3], PAINTBUFFER_SIZE, buffers[1], pass != 0, true );
+			}
+			t2 = trap_Microseconds();
+
+			time[pass][0] += t1 - t0;
+			time[pass][1] += t2 - t1;
+
+			if( memcmp( buffers[0], buffers[1], sizeof( portable_samplepair_t ) * PAINTBUFFER_SIZE ) ||
+				memcmp( channels[0], channels[1], sizeof( channel_t ) * numChannels ) ) {
+				numMismatches++;
+			}
+		}
+
+		Com_Printf( "%-16s scalar %8.1f us/frame, SIMD %8.1f us/frame\n", passNames[pass],
+					(double)time[pass][0] / numFrames, (double)time[pass][1] / numFrames );
+	}
+
+	// the last mixed frame, clamped to 16 bits
+	for( i = 0; i < 2 * PAINTBUFFER_SIZE; i++ ) {
+		int val = ( (int *)buffers[0] )[i] >> 8;
+		out[0][i] = Q_bound( -32768, val, 32767 );
+	}
+
+	snd_p = (int *)buffers[0];
+	snd_out = out[1];
+	snd_linear_count = 2 * PAINTBUFFER_SIZE;
+	t0 = trap_Microseconds();
+	for( i = 0; i < numFrames; i++ ) {
+		S_WriteLinearBlastStereo16();
+	}
+	t1 = trap_Microseconds();
+
+	Com_Printf( "transfer         %8.1f us/frame\n", (double)( t1 - t0 ) / numFrames );
+	if( memcmp( out[0], out[1], sizeof( short ) * 2 * PAINTBUFFER_SIZE ) ) {
+		Com_Printf( S_COLOR_RED "mixbench: transferred samples differ\n" );
+	}
+
+	if( numMismatches ) {
+		Com_Printf( S_COLOR_RED "mixbench: %i of %i frames mixed differently\n", numMismatches, numFrames * 2 );
+	} else {
+		Com_Printf( "mixbench: %i channels, %i frames of %i samples, all results match\n", numChannels, numFrames,
+					PAINTBUFFER_SIZE );
+	}
+
+	for( i = 0; i < 2; i++ ) {
+		S_Free( out[i] );
+		S_Free( buffers[i] );
+		S_Free( channels[i] );
+	}
+	for( i = 0; i < 4; i++ ) {
+		S_Free( sounds[i] );
+	}
+
+	snd_vol = oldvol;
+}
+
+#endif // PUBLIC_BUILD
@@ -67,6 +67,12 @@ static inline const char *trap_Cvar_String( const char *name ) {
 	return SOUND_IMPORT.Cvar_String( name );
 }
 
+static inline float trap_Cvar_ReadValue( const cvar_t *var ) {
+	float value;
+	SOUND_IMPORT.Cvar_ReadNumbers( var, &value, NULL );
+	return value;
+}
+
 static inline int trap_Cmd_Argc( void ) {
 	return SOUND_IMPORT.Cmd_Argc();
 }
@@ -148,6 +154,10 @@ static inline int64_t trap_Milliseconds( void ) {
 	return SOUND_IMPORT.Sys_Milliseconds();
 }
 
+static inline uint64_t trap_Microseconds( void ) {
+	return SOUND_IMPORT.Sys_Microseconds();
+}
+
 static inline void trap_Sleep( unsigned int milliseconds ) {
 	SOUND_IMPORT.Sys_Sleep( milliseconds );
 }
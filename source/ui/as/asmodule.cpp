@@ -249,7 +249,11 @@ public:
 		if( !module ) {
 			return false;
 		}
-		return module->Build() >= 0;
+		if( module->Build() < 0 ) {
+			return false;
+		}
+		as_api->asFinalizeJIT( engine );
+		return true;
 	}
 
 	virtual bool addScript( asIScriptModule *module, const char *name, const char *code ) {
@@ -267,7 +271,11 @@ public:
 
 	virtual bool addFunction( asIScriptModule *module, const char *name, const char *code, asIScriptFunction **outFunction ) {
 		// note that reference count for outFunction is increased here!
-		return module ? ( module->CompileFunction( name, code, 0, asCOMP_ADD_TO_MODULE, outFunction ) >= 0 ) : false;
+		if( !module || module->CompileFunction( name, code, 0, asCOMP_ADD_TO_MODULE, outFunction ) < 0 ) {
+			return false;
+		}
+		as_api->asFinalizeJIT( engine );
+		return true;
 	}
 
 	// TODO: disk/mem-cache fully compiled set (use Binary*Stream)
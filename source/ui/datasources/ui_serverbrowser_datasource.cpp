@@ -353,7 +353,7 @@ void ServerInfoFetcher::clearQueries() {
 // advance queries
 void ServerInfoFetcher::updateFrame() {
 	int64_t now = trap::Milliseconds();
-	int64_t treshold = now - ( TIMEOUT_SEC * 1000 );
+	int64_t treshold = now - TIMEOUT_MSEC;
 	ActiveList::iterator it;
 
 	// remove old items (timeout)
@@ -367,9 +367,10 @@ void ServerInfoFetcher::updateFrame() {
 		}
 	}
 
-	// populate active queries with ones on the waiting line
-	if( now > lastQueryTime + QUERY_TIMEOUT_MSEC && numWaiting() > 0 ) {
-		lastQueryTime = now;
+	// populate active queries with ones on the waiting line, the client
+	// paces the actual requests so keep as many going as it allows
+	unsigned int maxActive = std::max( trap::Cvar_Int( "cl_serverQueryMax" ), 1 );
+	while( numActive() < maxActive && numWaiting() > 0 ) {
 		startQuery( serverQueue.front() );
 		serverQueue.pop();
 	}
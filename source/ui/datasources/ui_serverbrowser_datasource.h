@@ -195,9 +195,7 @@ public:
 // Module that will queue server pings
 class ServerInfoFetcher
 {
-	// amount if simultaneous queries
-	static const unsigned int TIMEOUT_SEC = 5;      // secs until we replace with another job
-	static const unsigned int QUERY_TIMEOUT_MSEC = 50;      // time between subsequent queries to individual servers
+	static const unsigned int TIMEOUT_MSEC = 1000;  // msecs until we replace with another job, matches SERVER_QUERY_TIMEOUT of the client
 
 	// waiting line
 	typedef std::queue<std::string> StringQueue;
@@ -210,7 +208,7 @@ class ServerInfoFetcher
 
 public:
 	ServerInfoFetcher()
-		: lastQueryTime( 0 ), numIssuedQueries( 0 )
+		: numIssuedQueries( 0 )
 	{}
 	~ServerInfoFetcher() {}
 
@@ -228,7 +226,6 @@ public:
 	unsigned int numIssued() const { return numIssuedQueries; }
 
 private:
-	int64_t lastQueryTime;
 	unsigned int numIssuedQueries;
 
 	// compare address of active query
@@ -268,7 +268,7 @@ void Sys_ReleaseWakeLock( void *wl ) {
 /*****************************************************************************/
 
 int main( int argc, char **argv ) {
-	unsigned int oldtime, newtime, time;
+	unsigned int time;
 
 	InitSig();
 
@@ -284,12 +284,10 @@ int main( int argc, char **argv ) {
 
 	fcntl( 0, F_SETFL, fcntl( 0, F_GETFL, 0 ) | O_NONBLOCK );
 
-	oldtime = Sys_Milliseconds();
 	while( true ) {
 		// find time spent rendering last frame
 		do {
-			newtime = Sys_Milliseconds();
-			time = newtime - oldtime;
+			time = Qcommon_FrameMsec();
 			if( time > 0 ) {
 				break;
 			}
@@ -297,7 +295,6 @@ int main( int argc, char **argv ) {
 			Sys_Sleep( 0 );
 #endif
 		} while( 1 );
-		oldtime = newtime;
 
 		Qcommon_Frame( time );
 	}
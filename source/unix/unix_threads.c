@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <pthread.h>
 #include <sched.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 struct qthread_s {
 	pthread_t t;
@@ -120,6 +121,14 @@ void Sys_Thread_Yield( void ) {
 	sched_yield();
 }
 
+/*
+* Sys_Thread_NumProcessors
+*/
+int Sys_Thread_NumProcessors( void ) {
+	long num = sysconf( _SC_NPROCESSORS_ONLN );
+	return num > 0 ? (int)num : 1;
+}
+
 /*
 * Sys_Atomic_Add
 */
@@ -184,6 +193,10 @@ bool Sys_CondVar_Wait( qcondvar_t *cond, qmutex_t *mutex, unsigned int timeout_m
 	ts.tv_nsec = tp.tv_usec * 1000;
 	ts.tv_sec += timeout_msec / 1000;
 	ts.tv_nsec += ( timeout_msec % 1000 ) * 1000000;
+	if( ts.tv_nsec >= 1000000000 ) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
 
 	return pthread_cond_timedwait( &cond->c, &mutex->m, &ts ) == 0;
 }
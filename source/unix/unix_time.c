@@ -1,4 +1,6 @@
 #include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
 #include "../qcommon/qcommon.h"
 
 #if defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0 && defined(CLOCK_MONOTONIC)
@@ -21,7 +23,7 @@ uint64_t Sys_Microseconds( void ) {
 	}
 
 	// TODO handle the wrap
-	return (uint64_t)( ts.tv_sec - sys_secbase ) * 1000000 + ts.ts_nsec / 1000;
+	return (uint64_t)( ts.tv_sec - sys_secbase ) * 1000000 + ts.tv_nsec / 1000;
 #else
 	struct timeval tp;
 	gettimeofday( &tp, NULL );
@@ -298,7 +298,7 @@ static void ParseCommandLine( LPSTR lpCmdLine ) {
 HINSTANCE global_hInstance;
 int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow ) {
 	MSG msg;
-	int64_t oldtime, newtime, time;
+	unsigned int time;
 
 	/* previous instances do not exist in Win32 */
 	if( hPrevInstance ) {
@@ -311,8 +311,6 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLin
 
 	Qcommon_Init( argc, argv );
 
-	oldtime = Sys_Milliseconds();
-
 	/* main window message loop */
 	while( 1 ) {
 		// if at a full screen console, don't update unless needed
@@ -330,15 +328,12 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLin
 		}
 
 		do {
-			newtime = Sys_Milliseconds();
-			time = newtime - oldtime; // no warp problem as unsigned
+			time = Qcommon_FrameMsec();
 			if( time > 0 ) {
 				break;
 			}
 			Sys_Sleep( 0 );
 		} while( 1 );
-		//Com_Printf ("time:%5.2u - %5.2u = %5.2u\n", newtime, oldtime, time);
-		oldtime = newtime;
 
 		// do as q3 (use the default floating point precision)
 		//	_controlfp( ~( _EM_ZERODIVIDE /*| _EM_INVALID*/ ), _MCW_EM );
@@ -173,6 +173,16 @@ void Sys_Thread_Yield( void ) {
 	Sys_Sleep( 0 );
 }
 
+/*
+* Sys_Thread_NumProcessors
+*/
+int Sys_Thread_NumProcessors( void ) {
+	SYSTEM_INFO sysInfo;
+
+	GetSystemInfo( &sysInfo );
+	return sysInfo.dwNumberOfProcessors > 0 ? (int)sysInfo.dwNumberOfProcessors : 1;
+}
+
 /*
 * Sys_Atomic_Add
 */